@@ -0,0 +1,197 @@
+/*
+ * Class instance pools (runtime/cax_slab.c) against calloc/free, the
+ * allocator heap objects used before.
+ *
+ *   slabBench
+ *
+ * Every workload runs in a child process of its own so each line can
+ * report that run's peak RSS next to its throughput (ns per alloc/free
+ * pair). Objects are 48 bytes, a typical small class:
+ *
+ *   churn      a window of live objects; free one, allocate one
+ *   bulk       allocate a million objects, then free them all
+ *   threads    churn on 4 threads at once
+ *   handoff    one thread allocates, another frees (batches cross threads)
+ */
+#define _DEFAULT_SOURCE   /* wait4 */
+
+#include "runtime/cax_runtime.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define OBJECT_SIZE 48
+#define THREADS 4
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* --------------------------------------------
+ * Allocators under test
+ * -------------------------------------------- */
+
+typedef struct {
+    const char* name;
+    void* (*alloc)(void);
+    void (*release)(void* object);
+} Allocator;
+
+static CaxSlabPool pool = {OBJECT_SIZE, NULL};
+
+static void* slabAlloc(void) { return cax_slab_alloc(&pool); }
+static void slabFree(void* object) { cax_slab_free(&pool, object); }
+static void* heapAlloc(void) { return calloc(1, OBJECT_SIZE); }
+static void heapFree(void* object) { free(object); }
+
+static const Allocator allocators[] = {
+    {"calloc", heapAlloc, heapFree},
+    {"slab", slabAlloc, slabFree},
+};
+
+/* --------------------------------------------
+ * Workloads (each returns the number of alloc/free pairs)
+ * -------------------------------------------- */
+
+static const Allocator* current;
+
+static void* churn(void* unused) {
+    (void)unused;
+    enum { WINDOW = 4096, ROUNDS = 20000000 / THREADS };
+    void** live = malloc(WINDOW * sizeof(void*));
+    for (int i = 0; i < WINDOW; i++) live[i] = current->alloc();
+
+    uint32_t seed = 12345;
+    for (int r = 0; r < ROUNDS; r++) {
+        seed = seed * 1664525u + 1013904223u;
+        int slot = (int)(seed >> 20) % WINDOW;
+        current->release(live[slot]);
+        live[slot] = current->alloc();
+        memset(live[slot], r, 8);
+    }
+    for (int i = 0; i < WINDOW; i++) current->release(live[i]);
+    free(live);
+    return NULL;
+}
+
+static int64_t runChurn(void) {
+    churn(NULL);
+    return 20000000 / THREADS + 4096;
+}
+
+static int64_t runBulk(void) {
+    enum { COUNT = 1000000, REPEATS = 5 };
+    void** objects = malloc(COUNT * sizeof(void*));
+    for (int r = 0; r < REPEATS; r++) {
+        for (int i = 0; i < COUNT; i++) objects[i] = current->alloc();
+        for (int i = 0; i < COUNT; i++) current->release(objects[i]);
+    }
+    free(objects);
+    return (int64_t)COUNT * REPEATS;
+}
+
+static int64_t runThreads(void) {
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, churn, NULL);
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+    return (int64_t)THREADS * (20000000 / THREADS + 4096);
+}
+
+enum { HANDOFF_COUNT = 4000000, HANDOFF_RING = 1 << 12 };
+
+static void* volatile ring[HANDOFF_RING];
+
+static void* consume(void* unused) {
+    (void)unused;
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        void* object;
+        while (!(object = __atomic_load_n(&ring[i % HANDOFF_RING], __ATOMIC_ACQUIRE))) sched_yield();
+        __atomic_store_n(&ring[i % HANDOFF_RING], NULL, __ATOMIC_RELAXED);
+        current->release(object);
+    }
+    return NULL;
+}
+
+static int64_t runHandoff(void) {
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, consume, NULL);
+    for (int i = 0; i < HANDOFF_COUNT; i++) {
+        void* object = current->alloc();
+        while (__atomic_load_n(&ring[i % HANDOFF_RING], __ATOMIC_ACQUIRE)) sched_yield();
+        __atomic_store_n(&ring[i % HANDOFF_RING], object, __ATOMIC_RELEASE);
+    }
+    pthread_join(consumer, NULL);
+    return HANDOFF_COUNT;
+}
+
+typedef struct {
+    const char* name;
+    int64_t (*run)(void);
+} Workload;
+
+static const Workload workloads[] = {
+    {"churn", runChurn},
+    {"bulk", runBulk},
+    {"threads", runThreads},
+    {"handoff", runHandoff},
+};
+
+/* --------------------------------------------
+ * Driver
+ * -------------------------------------------- */
+
+/* Runs one workload in a child; returns ns per pair and the child's peak RSS */
+static int measure(const Workload* workload, const Allocator* allocator, double* nsPerPair, long* maxRssKb) {
+    int channel[2];
+    if (pipe(channel) != 0) return 0;
+
+    pid_t child = fork();
+    if (child == 0) {
+        current = allocator;
+        double start = now();
+        int64_t pairs = workload->run();
+        double result = (now() - start) * 1e9 / (double)pairs;
+        ssize_t written = write(channel[1], &result, sizeof(result));
+        _exit(written == (ssize_t)sizeof(result) ? 0 : 1);
+    }
+    close(channel[1]);
+    if (child < 0) {
+        close(channel[0]);
+        return 0;
+    }
+
+    ssize_t got = read(channel[0], nsPerPair, sizeof(*nsPerPair));
+    close(channel[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) < 0 || got != (ssize_t)sizeof(*nsPerPair) || status != 0) return 0;
+    *maxRssKb = usage.ru_maxrss;
+    return 1;
+}
+
+int main(void) {
+    printf("Object pools: %d-byte objects, %d threads where threaded\n", OBJECT_SIZE, THREADS);
+
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        double ns[2];
+        long rss[2];
+        for (int a = 0; a < 2; a++) {
+            if (!measure(&workloads[w], &allocators[a], &ns[a], &rss[a])) {
+                fprintf(stderr, "%s/%s: run failed\n", workloads[w].name, allocators[a].name);
+                return 1;
+            }
+        }
+        printf("%-8s calloc %6.1f ns/op %7ld KiB   slab %6.1f ns/op %7ld KiB   x%.1f\n",
+               workloads[w].name, ns[0], rss[0], ns[1], rss[1], ns[0] / ns[1]);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Tensor kernel throughput: runtime kernels (runtime/cax_tensor.c) against
+ * the plain loops a .cax program would otherwise compile to.
+ *
+ *   tensorBench            use the best kernels for this CPU
+ *   CAX_TENSOR_ISA=avx2 tensorBench   (or generic / avx512) to compare
+ *
+ * Each line reports GFLOP/s for the naive loop and the kernel, the
+ * speedup, and the largest difference between their results.
+ */
+#include "runtime/cax_runtime.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double* randomBuffer(int64_t n) {
+    double* buffer = malloc((size_t)n * sizeof(double));
+    if (!buffer) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (int64_t i = 0; i < n; i++) buffer[i] = (double)rand() / RAND_MAX - 0.5;
+    return buffer;
+}
+
+static void report(const char* name, double flops, double naiveSeconds, double kernelSeconds, double error) {
+    printf("%-22s naive %7.2f GFLOP/s   kernel %7.2f GFLOP/s   x%-6.1f  max|diff| %.1e\n",
+           name, flops / naiveSeconds * 1e-9, flops / kernelSeconds * 1e-9,
+           naiveSeconds / kernelSeconds, error);
+}
+
+/* --------------------------------------------
+ * Naive baselines
+ * -------------------------------------------- */
+
+static double naiveDot(const double* x, const double* y, int64_t n) {
+    double sum = 0;
+    for (int64_t i = 0; i < n; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+static void naiveAxpy(int64_t n, double alpha, const double* x, double* y) {
+    for (int64_t i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+static void naiveMatmul(const double* a, const double* b, double* c, int64_t m, int64_t k, int64_t n) {
+    for (int64_t i = 0; i < m; i++) {
+        for (int64_t j = 0; j < n; j++) {
+            double sum = 0;
+            for (int64_t p = 0; p < k; p++) sum += a[i * k + p] * b[p * n + j];
+            c[i * n + j] = sum;
+        }
+    }
+}
+
+static double naiveSum(const double* x, int64_t n) {
+    double sum = 0;
+    for (int64_t i = 0; i < n; i++) sum += x[i];
+    return sum;
+}
+
+/* --------------------------------------------
+ * Benchmarks
+ * -------------------------------------------- */
+
+static void benchDot(int64_t n, int repeats) {
+    double* x = randomBuffer(n);
+    double* y = randomBuffer(n);
+    volatile double sink = 0;
+
+    double start = now();
+    double naive = 0;
+    for (int r = 0; r < repeats; r++) sink += naive = naiveDot(x, y, n);
+    double naiveSeconds = now() - start;
+
+    start = now();
+    double fast = 0;
+    for (int r = 0; r < repeats; r++) sink += fast = cax_dot_f64(x, y, n);
+    double kernelSeconds = now() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "dot n=%lld", (long long)n);
+    report(name, 2.0 * n * repeats, naiveSeconds, kernelSeconds, fabs(naive - fast));
+    free(x);
+    free(y);
+}
+
+static void benchAxpy(int64_t n, int repeats) {
+    double* x = randomBuffer(n);
+    double* y1 = randomBuffer(n);
+    double* y2 = malloc((size_t)n * sizeof(double));
+    for (int64_t i = 0; i < n; i++) y2[i] = y1[i];
+
+    double start = now();
+    for (int r = 0; r < repeats; r++) naiveAxpy(n, 1e-9, x, y1);
+    double naiveSeconds = now() - start;
+
+    start = now();
+    for (int r = 0; r < repeats; r++) cax_axpy_f64(n, 1e-9, x, y2);
+    double kernelSeconds = now() - start;
+
+    double error = 0;
+    for (int64_t i = 0; i < n; i++) error = fmax(error, fabs(y1[i] - y2[i]));
+
+    char name[64];
+    snprintf(name, sizeof(name), "axpy n=%lld", (long long)n);
+    report(name, 2.0 * n * repeats, naiveSeconds, kernelSeconds, error);
+    free(x);
+    free(y1);
+    free(y2);
+}
+
+static void benchSum(int64_t n, int repeats) {
+    double* x = randomBuffer(n);
+    volatile double sink = 0;
+
+    double start = now();
+    double naive = 0;
+    for (int r = 0; r < repeats; r++) sink += naive = naiveSum(x, n);
+    double naiveSeconds = now() - start;
+
+    start = now();
+    double fast = 0;
+    for (int r = 0; r < repeats; r++) sink += fast = cax_sum_f64(x, n);
+    double kernelSeconds = now() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "sum n=%lld", (long long)n);
+    report(name, 1.0 * n * repeats, naiveSeconds, kernelSeconds, fabs(naive - fast));
+    free(x);
+}
+
+static void benchMatmul(int64_t size) {
+    double* a = randomBuffer(size * size);
+    double* b = randomBuffer(size * size);
+    double* c1 = malloc((size_t)(size * size) * sizeof(double));
+    double* c2 = malloc((size_t)(size * size) * sizeof(double));
+
+    double start = now();
+    naiveMatmul(a, b, c1, size, size, size);
+    double naiveSeconds = now() - start;
+
+    start = now();
+    cax_matmul_f64(a, b, c2, size, size, size);
+    double kernelSeconds = now() - start;
+
+    double error = 0;
+    for (int64_t i = 0; i < size * size; i++) error = fmax(error, fabs(c1[i] - c2[i]));
+
+    char name[64];
+    snprintf(name, sizeof(name), "matmul %lldx%lld", (long long)size, (long long)size);
+    report(name, 2.0 * size * size * size, naiveSeconds, kernelSeconds, error);
+    free(a);
+    free(b);
+    free(c1);
+    free(c2);
+}
+
+int main(void) {
+    srand(42);
+    printf("Tensor kernels: %s\n", cax_tensor_isa());
+
+    benchDot(4096, 20000);          /* L1/L2 resident */
+    benchDot(4 << 20, 20);          /* memory bound */
+    benchAxpy(4096, 20000);
+    benchSum(4096, 20000);
+    benchMatmul(255);               /* exercises the edge tiles */
+    benchMatmul(512);
+    benchMatmul(1024);
+    return 0;
+}
@@ -5,6 +5,9 @@
 #include <filesystem>
 #include <cstdlib>
 #include <sstream>
+#include <cstring>
+
+#include "diagnostics/diagnostics.h"
 
 #ifndef _WIN32
 #include <sys/stat.h>
@@ -30,6 +33,8 @@ private:
     bool verbose;
     bool keepIntermediate;
     int optimizeLevel;
+    string codegenOptions;   // Forwarded to irGenerator
+    string profileUse;       // --profile-use=<file>
 
     string findExecutable(const string& name) {
         // Search in cmake-build-debug first (your CLion default), then build
@@ -99,8 +104,9 @@ private:
             return false;
         }
 
-        // Pass the input file as argument to irGenerator
-        string cmd = irGenPath + " " + inputFile;
+        // Pass the input file as argument to irGenerator, along with the
+        // verbosity/trace options so it stays quiet unless asked.
+        string cmd = irGenPath + " " + inputFile + diag::forwardedOptions() + codegenOptions;
 
         if (verbose) {
             cout << "  Command: " << cmd << endl;
@@ -141,12 +147,27 @@ private:
     bool compileToExecutable() {
         printStep("COMPILE", "Compiling to native executable...");
 
+        // Generated code calls into the C-Accel runtime (print buffering etc.)
+        string runtimeLib = findExecutable("libcaxruntime.a");
+        if (runtimeLib.empty()) {
+            printError("Could not find C-Accel runtime library (libcaxruntime.a)");
+            printWarning("Please build the project first with CLion or: cmake --build cmake-build-debug");
+            return false;
+        }
+
         // Use clang to compile LLVM IR to executable
         stringstream cmd;
-        cmd << "clang " << outputLL << " -o " << outputFile;
+        cmd << "clang " << outputLL << " " << runtimeLib << " -o " << outputFile;
+        #ifdef __linux__
+        cmd << " -lpthread";
+        #endif
 
         if (optimizeLevel > 0) {
             cmd << " -O" << optimizeLevel;
+            if (!profileUse.empty()) {
+                // Outline the blocks the profile shows to be cold
+                cmd << " -mllvm -hot-cold-split=true";
+            }
         }
 
         if (verbose) {
@@ -198,9 +219,27 @@ private:
         cout << "Options:\n";
         cout << "  -o <file>          Specify output executable name\n";
         cout << "  -emit-llvm <file>  Output LLVM IR to specified file\n";
-        cout << "  -v, --verbose      Enable verbose output\n";
+        cout << "  -v, --verbose      Enable verbose output (-vv for debug output)\n";
+        cout << "  --trace=<cats>     Trace categories: driver,lexer,parser,irgen,all\n";
+        cout << "  -q, --quiet        Only report errors\n";
         cout << "  -k, --keep         Keep intermediate files\n";
         cout << "  -O<level>          Optimization level (0-3)\n";
+        cout << "  --bounds-check=<m> Index checks on vector/array access: off (default), on,\n";
+        cout << "                     auto (skip checks proven unnecessary at compile time)\n";
+        cout << "  --layout-report    Print each class's size, padding and cache-line span\n";
+        cout << "  --no-ast-opt       Skip the source-level passes (constant folding, dead\n";
+        cout << "                     branches, ...) that run before IR generation\n";
+        cout << "  --profile-generate[=<file>]\n";
+        cout << "                     Build a program that counts function calls and branch\n";
+        cout << "                     outcomes into <file> (default.caxprof) when it exits\n";
+        cout << "  --profile-use=<file>\n";
+        cout << "                     Optimize with a profile from --profile-generate runs\n";
+        cout << "                     (branch weights, inlining, hot/cold code placement)\n";
+        cout << "  --instrument=<kinds>\n";
+        cout << "                     functions: calls and time per function; loops: trip\n";
+        cout << "                     counts; branches: if taken/not taken. Comma-separated; the\n";
+        cout << "                     program reports at exit and on SIGUSR1 (on stderr, or in\n";
+        cout << "                     CAX_INSTRUMENT_OUTPUT=<file>, JSON if it ends in .json)\n";
         cout << "  -h, --help         Show this help message\n\n";
         cout << "Examples:\n";
         cout << "  " << progName << " program.cax\n";
@@ -226,8 +265,8 @@ public:
             if (arg == "-h" || arg == "--help") {
                 printUsage(argv[0]);
                 return false;
-            } else if (arg == "-v" || arg == "--verbose") {
-                verbose = true;
+            } else if (diag::parseOption(arg)) {
+                // -v, -vv, -q, --trace=<categories>
             } else if (arg == "-k" || arg == "--keep") {
                 keepIntermediate = true;
             } else if (arg == "-o" && i + 1 < argc) {
@@ -235,6 +274,17 @@ public:
             } else if (arg == "-emit-llvm" && i + 1 < argc) {
                 outputLL = argv[++i];
                 keepIntermediate = true;
+            } else if (arg == "--bounds-check=on" || arg == "--bounds-check=off" ||
+                       arg == "--bounds-check=auto" || arg == "--layout-report" ||
+                       arg == "--no-ast-opt") {
+                codegenOptions += " " + arg;
+            } else if (arg == "--profile-generate" || arg.rfind("--profile-generate=", 0) == 0) {
+                codegenOptions += " " + arg;
+            } else if (arg.rfind("--instrument=", 0) == 0) {
+                codegenOptions += " " + arg;
+            } else if (arg.rfind("--profile-use=", 0) == 0) {
+                profileUse = arg.substr(strlen("--profile-use="));
+                codegenOptions += " " + arg;
             } else if (arg.substr(0, 2) == "-O" && arg.length() == 3) {
                 optimizeLevel = arg[2] - '0';
             } else if (inputFile.empty()) {
@@ -250,6 +300,12 @@ public:
             return false;
         }
 
+        verbose = diag::enabled(diag::Level::Info, diag::CAT_DRIVER);
+
+        if (!profileUse.empty() && optimizeLevel == 0) {
+            printWarning("--profile-use only takes effect with -O1 or higher");
+        }
+
         // Set default output file if not specified
         if (outputFile.empty()) {
             fs::path p(inputFile);
@@ -0,0 +1,189 @@
+#ifndef CLANGAX_DIAGNOSTICS_H
+#define CLANGAX_DIAGNOSTICS_H
+
+#include <iostream>
+#include <string>
+#include <sstream>
+
+// ============================================
+// LEVELLED DIAGNOSTICS / TRACING
+// ============================================
+//
+// One logging facility shared by the driver, parser and IR generator.
+//
+//   CAX_INFO(diag::CAT_IRGEN, "Declaring function: " << name);
+//   CAX_TRACE(diag::CAT_PARSER, "parseBlock loop -> " << tok.value);
+//
+// Call sites above CAX_MAX_LOG_LEVEL are discarded at compile time
+// (the message expression is never evaluated or emitted). Call sites
+// that are compiled in cost one load and a branch when disabled.
+//
+// Runtime control (see diag::parseOption):
+//   (default)          errors and warnings only
+//   -v, --verbose      + info
+//   -vv                + debug for every category
+//   --trace=a,b        debug + trace for the listed categories
+//                      (driver, lexer, parser, irgen, all)
+//   -q, --quiet        errors only
+
+#ifndef CAX_MAX_LOG_LEVEL
+#define CAX_MAX_LOG_LEVEL 4
+#endif
+
+namespace diag {
+
+enum class Level : int {
+    Error = 0,
+    Warning = 1,
+    Info = 2,
+    Debug = 3,
+    Trace = 4
+};
+
+enum Category : unsigned {
+    CAT_NONE   = 0,
+    CAT_DRIVER = 1u << 0,
+    CAT_LEXER  = 1u << 1,
+    CAT_PARSER = 1u << 2,
+    CAT_IRGEN  = 1u << 3,
+    CAT_ALL    = ~0u
+};
+
+struct Config {
+    Level level = Level::Warning;    // Applies to every category
+    unsigned traced = CAT_NONE;      // Categories opened up to Trace
+};
+
+inline Config& config() {
+    static Config cfg;
+    return cfg;
+}
+
+inline bool enabled(Level level, unsigned category) {
+    const Config& cfg = config();
+    if (static_cast<int>(level) <= static_cast<int>(cfg.level)) return true;
+    return (cfg.traced & category) != 0;
+}
+
+inline const char* levelName(Level level) {
+    switch (level) {
+        case Level::Error: return "ERROR";
+        case Level::Warning: return "WARN";
+        case Level::Info: return "INFO";
+        case Level::Debug: return "DEBUG";
+        case Level::Trace: return "TRACE";
+    }
+    return "?";
+}
+
+inline const char* categoryName(unsigned category) {
+    switch (category) {
+        case CAT_DRIVER: return "driver";
+        case CAT_LEXER: return "lexer";
+        case CAT_PARSER: return "parser";
+        case CAT_IRGEN: return "irgen";
+        default: return "all";
+    }
+}
+
+inline unsigned categoryFromName(const std::string& name) {
+    if (name == "driver") return CAT_DRIVER;
+    if (name == "lexer") return CAT_LEXER;
+    if (name == "parser") return CAT_PARSER;
+    if (name == "irgen" || name == "ir") return CAT_IRGEN;
+    if (name == "all") return CAT_ALL;
+    return CAT_NONE;
+}
+
+// clog is buffered, unlike cerr, so trace-heavy runs don't pay for a
+// flush on every line. Errors still go through cerr.
+inline std::ostream& stream(Level level, unsigned category) {
+    std::ostream& out = (level == Level::Error) ? std::cerr : std::clog;
+    out << "[" << levelName(level) << "][" << categoryName(category) << "] ";
+    return out;
+}
+
+// Consume a diagnostics command-line option. Returns false if the
+// argument is not one of ours so callers can keep parsing it.
+inline bool parseOption(const std::string& arg) {
+    Config& cfg = config();
+
+    if (arg == "-v" || arg == "--verbose") {
+        if (static_cast<int>(cfg.level) < static_cast<int>(Level::Info)) cfg.level = Level::Info;
+        return true;
+    }
+    if (arg == "-vv") {
+        cfg.level = Level::Debug;
+        return true;
+    }
+    if (arg == "-q" || arg == "--quiet") {
+        cfg.level = Level::Error;
+        return true;
+    }
+    if (arg.rfind("--trace=", 0) == 0) {
+        std::stringstream list(arg.substr(8));
+        std::string name;
+        while (std::getline(list, name, ',')) {
+            unsigned category = categoryFromName(name);
+            if (category == CAT_NONE) {
+                std::cerr << "Unknown trace category: " << name << "\n";
+                continue;
+            }
+            cfg.traced |= category;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Rebuild the options that reproduce the current configuration, so a
+// driver can forward them to the tools it launches.
+inline std::string forwardedOptions() {
+    const Config& cfg = config();
+    std::string opts;
+
+    if (cfg.level == Level::Error) opts += " -q";
+    else if (cfg.level == Level::Info) opts += " -v";
+    else if (static_cast<int>(cfg.level) >= static_cast<int>(Level::Debug)) opts += " -vv";
+
+    if (cfg.traced != CAT_NONE) {
+        if (cfg.traced == CAT_ALL) {
+            opts += " --trace=all";
+        } else {
+            std::string list;
+            for (unsigned cat : {CAT_DRIVER, CAT_LEXER, CAT_PARSER, CAT_IRGEN}) {
+                if (cfg.traced & cat) {
+                    if (!list.empty()) list += ",";
+                    list += categoryName(cat);
+                }
+            }
+            opts += " --trace=" + list;
+        }
+    }
+    return opts;
+}
+
+} // namespace diag
+
+#define CAX_LOG(LEVEL, CATEGORY, EXPR)                                              \
+    do {                                                                            \
+        if constexpr (static_cast<int>(diag::Level::LEVEL) <= CAX_MAX_LOG_LEVEL) {  \
+            if (diag::enabled(diag::Level::LEVEL, (CATEGORY))) {                    \
+                diag::stream(diag::Level::LEVEL, (CATEGORY)) << EXPR << '\n';       \
+            }                                                                       \
+        }                                                                           \
+    } while (0)
+
+#define CAX_ERROR(CATEGORY, EXPR) CAX_LOG(Error, CATEGORY, EXPR)
+#define CAX_WARN(CATEGORY, EXPR)  CAX_LOG(Warning, CATEGORY, EXPR)
+#define CAX_INFO(CATEGORY, EXPR)  CAX_LOG(Info, CATEGORY, EXPR)
+#define CAX_DEBUG(CATEGORY, EXPR) CAX_LOG(Debug, CATEGORY, EXPR)
+#define CAX_TRACE(CATEGORY, EXPR) CAX_LOG(Trace, CATEGORY, EXPR)
+
+// True when a block of diagnostics output (e.g. a module dump) should be
+// produced. Folds to false when LEVEL is compiled out.
+#define CAX_LOG_ENABLED(LEVEL, CATEGORY)                                            \
+    (static_cast<int>(diag::Level::LEVEL) <= CAX_MAX_LOG_LEVEL &&                   \
+     diag::enabled(diag::Level::LEVEL, (CATEGORY)))
+
+#endif // CLANGAX_DIAGNOSTICS_H
@@ -8,6 +8,13 @@
 #include <sstream>
 #include <regex>
 #include <set>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <iomanip>
 
 // LLVM Headers
 #include "llvm/IR/LLVMContext.h"
@@ -17,8 +24,20 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/ProfileSummary.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/TargetParser/Host.h"
+
+#include "diagnostics/diagnostics.h"
 
 using namespace llvm;
 using namespace std;
@@ -94,6 +113,12 @@ class Parser;
 // LLVM IR GENERATOR
 // ============================================
 
+// --bounds-check=off|on|auto
+//   off   no index checks (out-of-range access is undefined behaviour)
+//   on    every vector and array index is checked
+//   auto  array indices proven in range at compile time are not checked
+enum class BoundsCheckMode { Off, On, Auto };
+
 class IRGenerator {
 private:
     unique_ptr<LLVMContext> context;
@@ -106,14 +131,76 @@ private:
     map<string, Function*> functions;             // Function registry
     map<string, Type*> structTypes;               // Class/struct types
 
-    bool hasMain = false;
+    // Module-wide constant pool: one private unnamed_addr global per
+    // distinct string, shared by string literals and printf formats
+    map<string, GlobalVariable*> stringPool;
+    int stringPoolHits = 0;
+
+    // Immutable array literals live in private constant globals, pooled by
+    // contents. Arrays bound once and never written through an index are
+    // used in place; only mutable ones get a stack copy.
+    map<Constant*, GlobalVariable*> constantArrayPool;
+    set<string> mutableArrays;                    // Array names needing a local copy
+
+    // Arrays used through a pointer other than their own stack slot:
+    // read-only literals (their constant global) and, inside an outlined
+    // parallel loop body, the arrays of the enclosing function
+    struct BoundArray {
+        Value* storage;
+        ArrayType* type;
+    };
+    map<string, BoundArray> boundArrays;
 
-    // Printf function for print support
-    Function* printfFunc = nullptr;
-    Function* putsFunc = nullptr;
+    // A vector in memory: a local's stack slot or a field of `this`
+    struct VectorRef {
+        Value* storage = nullptr;
+        StructType* type = nullptr;
+        explicit operator bool() const { return storage != nullptr; }
+    };
+
+    bool hasMain = false;
+    int internalFunctions = 0;                    // Not exported: internal + fastcc
+
+    // Index checking (--bounds-check). Vector sizes are only known at run
+    // time, so vector accessors are checked in both `on` and `auto` modes.
+    BoundsCheckMode boundsCheckMode = BoundsCheckMode::Off;
+    int boundsCheckSites = 0;      // Array accesses seen while checks are enabled
+    int boundsChecksElided = 0;    // ... of which proven in range
+
+    // Value ranges of the induction variables of enclosing counted loops,
+    // innermost last (used to prove array indices in range)
+    struct IndexRange {
+        int64_t lo;
+        int64_t hi;
+    };
+    vector<pair<string, IndexRange>> inductionRanges;
+
+    // exec(threads=N, fraction): worker count and chunking fraction of the
+    // parallel-for runtime (0 threads = no directive)
+    // exec(cpu=C, weight): core budget the runtime sizes and pins the pool
+    // to (-1 = no directive, 0 = all usable CPUs)
+    int execThreads = 0;
+    double execFraction = 1.0;
+    int execCpus = -1;
+    double execWeight = 1.0;
+    int parallelLoops = 0;         // Loops outlined into parallel-for bodies
+    bool inParallelBody = false;   // Generating an outlined loop body
 
     // Current function context
     Function* currentFunction = nullptr;
+    const ASTNode* currentFunctionNode = nullptr;
+    vector<AllocaInst*> functionVectors;          // Vector slots to free on return
+
+    // Stack slot lifetimes. Every alloca lives in the entry block; slots
+    // that are only live for part of the function are bracketed with
+    // llvm.lifetime.start/end so stack coloring can overlap them.
+    //  - array literal temporaries live for the statement that built them
+    //  - block-scoped local arrays (see findScopedLocals) live from their
+    //    defining assignment to the end of the block that contains all their
+    //    uses (scalars are SSA values and have no slot)
+    vector<AllocaInst*> statementTemporaries;
+    map<const ASTNode*, vector<string>> scopedLocals;   // Block -> locals ending there
+    map<const ASTNode*, string> scopedDefinitions;      // Defining assignment -> local
 
     // Loop context (for break/continue)
     struct LoopContext {
@@ -127,59 +214,64 @@ public:
         context = make_unique<LLVMContext>();
         module = make_unique<Module>(moduleName, *context);
         builder = make_unique<IRBuilder<>>(*context);
+        setHostTarget();
+    }
 
-        // Declare printf and puts for print support
-        declarePrintf();
-        declarePuts();
+    // The program is built for the machine running the compiler: take its
+    // triple and data layout, which class field order, padding and the
+    // layout report are computed from
+    void setHostTarget() {
+        InitializeNativeTarget();
+        string triple = sys::getDefaultTargetTriple();
+        string error;
+        const Target* target = TargetRegistry::lookupTarget(triple, error);
+        if (!target) {
+            CAX_WARN(diag::CAT_IRGEN, "No target for " << triple << " (" << error
+                     << "); the module gets LLVM's default data layout");
+            return;
+        }
+        unique_ptr<TargetMachine> machine(target->createTargetMachine(triple, "generic", "", TargetOptions(),
+                                                                      Reloc::PIC_));
+        module->setTargetTriple(triple);
+        module->setDataLayout(machine->createDataLayout());
     }
 
+    void setBoundsCheckMode(BoundsCheckMode mode) { boundsCheckMode = mode; }
+
     // ============================================
-    // PRINTF/PUTS DECLARATION
+    // RUNTIME DECLARATIONS
     // ============================================
 
-    void declarePrintf() {
-        // Declare: i32 @printf(i8*, ...)
-        vector<Type*> printfArgs;
-        printfArgs.push_back(getPtrType());
-
-        FunctionType* printfType = FunctionType::get(
-            getInt32Type(),
-            printfArgs,
-            true  // varargs
-        );
-
-        printfFunc = Function::Create(
-            printfType,
-            Function::ExternalLinkage,
-            "printf",
-            module.get()
-        );
-    }
-
-    void declarePuts() {
-        // Declare: i32 @puts(i8*)
-        vector<Type*> putsArgs;
-        putsArgs.push_back(getPtrType());
-
-        FunctionType* putsType = FunctionType::get(
-            getInt32Type(),
-            putsArgs,
-            false
-        );
+    // Declare a C-Accel runtime function (runtime/cax_runtime.h) on first
+    // use, so modules only reference the parts of the runtime they need.
+    Function* getRuntimeFunction(const string& name, Type* returnType, ArrayRef<Type*> params) {
+        if (Function* existing = module->getFunction(name)) {
+            return existing;
+        }
 
-        putsFunc = Function::Create(
-            putsType,
+        FunctionType* funcType = FunctionType::get(returnType, params, false);
+        Function* func = Function::Create(
+            funcType,
             Function::ExternalLinkage,
-            "puts",
+            name,
             module.get()
         );
+        func->setDoesNotThrow();
+        return func;
     }
 
     // ============================================
     // STRING CONSTANT CREATION
     // ============================================
 
-    GlobalVariable* createGlobalString(const string& str, const string& name = "") {
+    GlobalVariable* createGlobalString(const string& str) {
+        // Reuse the pooled constant if this string was already emitted
+        auto pooled = stringPool.find(str);
+        if (pooled != stringPool.end()) {
+            stringPoolHits++;
+            return pooled->second;
+        }
+
         // Create a constant string in global memory
         Constant* strConstant = ConstantDataArray::getString(*context, str, true);
 
@@ -189,15 +281,20 @@ public:
             true,  // isConstant
             GlobalValue::PrivateLinkage,
             strConstant,
-            name.empty() ? ".str" : name
+            ".str"
         );
 
         gvar->setAlignment(Align(1));
+        // Address is not significant, so the linker may merge identical
+        // constants across modules as well
+        gvar->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+
+        stringPool[str] = gvar;
         return gvar;
     }
 
     Value* getStringPtr(const string& str) {
-        // Create global string and return pointer to it
+        // Get (or create) the pooled global string and return pointer to it
         GlobalVariable* gvar = createGlobalString(str);
 
         // Get pointer to first element
@@ -225,21 +322,143 @@ public:
             funcName = "main";
             isMain = true;
             hasMain = true;
-            cout << "  Found Main function, declaring as 'main'" << endl;
+            CAX_INFO(diag::CAT_IRGEN, "Found Main function, declaring as 'main'");
         } else {
-            cout << "  Declaring function: " << funcName << endl;
+            CAX_INFO(diag::CAT_IRGEN, "Declaring function: " << funcName);
         }
 
         Type* returnType = isMain ? getInt32Type() : getVoidType();
         FunctionType* funcType = FunctionType::get(returnType, {}, false);
+        functions[funcName] = createFunction(node, funcName, funcType, isMain);
+    }
+
+    // Only main and func(Export) functions can be called from outside
+    // the module. Everything else is internal and uses fastcc, so LLVM
+    // may change its signature, inline it and drop it once unused.
+    Function* createFunction(shared_ptr<ASTNode> node, const string& funcName, FunctionType* funcType, bool isMain) {
+        bool exported = isMain || hasAnnotation(node, "Export");
+
         Function* func = Function::Create(
             funcType,
-            Function::ExternalLinkage,
+            exported ? Function::ExternalLinkage : Function::InternalLinkage,
             funcName,
             module.get()
         );
+        if (!exported) {
+            func->setCallingConv(CallingConv::Fast);
+            internalFunctions++;
+        }
+        func->setDoesNotThrow();   // .cax code has no exceptions
+
+        bool alwaysInline = hasAnnotation(node, "Inline");
+        bool neverInline = hasAnnotation(node, "NoInline");
+        if (alwaysInline && neverInline) {
+            CAX_WARN(diag::CAT_IRGEN, "Function " << funcName << " is marked both Inline and NoInline; ignoring both");
+        } else if (alwaysInline) {
+            func->addFnAttr(Attribute::AlwaysInline);
+        } else if (neverInline) {
+            func->addFnAttr(Attribute::NoInline);
+        }
+        return func;
+    }
+
+    // func(Export, Inline, ...) annotations
+    static bool hasAnnotation(shared_ptr<ASTNode> node, const string& name) {
+        auto it = node->attributes.find("annotations");
+        if (it == node->attributes.end()) return false;
+        stringstream list(it->second);
+        string annotation;
+        while (getline(list, annotation, ',')) {
+            if (annotation == name) return true;
+        }
+        return false;
+    }
+
+    // ============================================
+    // CALL GRAPH
+    // ============================================
+    // Only functions reachable from main and from func(Export) entry points
+    // are lowered; the rest would be dropped by LLVM anyway, after paying
+    // for their IR. Calls are resolved by name before any types are known,
+    // so m() reaches every method named m (and a function m): a superset
+    // of the real graph, which is all pruning needs.
+
+    set<const ASTNode*> reachableBodies;         // Functions and methods to lower
+    vector<pair<string, const ASTNode*>> prunedBodies;   // Qualified name, body
+    size_t reachableNodes = 0;                   // AST size of what is lowered / pruned
+    size_t prunedNodes = 0;
+
+    static size_t countNodes(const ASTNode* node) {
+        size_t count = 1;
+        for (auto& child : node->children) count += countNodes(child.get());
+        return count;
+    }
+
+    void findReachableFunctions(shared_ptr<ASTNode> program) {
+        multimap<string, const ASTNode*> byName;   // Callable name -> bodies
+        vector<const ASTNode*> worklist;
+        vector<pair<string, const ASTNode*>> all;
+
+        for (auto& decl : program->children) {
+            if (decl->type == NodeType::FUNCTION_DECL) {
+                byName.insert({decl->value, decl.get()});
+                all.push_back({decl->value, decl.get()});
+                auto type = decl->attributes.find("type");
+                bool isMain = type != decl->attributes.end() && type->second == "Main";
+                if (isMain || hasAnnotation(decl, "Export")) worklist.push_back(decl.get());
+            } else if (decl->type == NodeType::CLASS_DECL) {
+                for (auto& section : decl->children) {
+                    if (section->type != NodeType::MEMBER_SECTION) continue;
+                    for (auto& method : section->children) {
+                        byName.insert({method->value, method.get()});
+                        all.push_back({decl->value + "::" + method->value, method.get()});
+                    }
+                }
+            }
+        }
 
-        functions[funcName] = func;
+        reachableBodies.clear();
+        while (!worklist.empty()) {
+            const ASTNode* body = worklist.back();
+            worklist.pop_back();
+            if (!reachableBodies.insert(body).second) continue;
+
+            function<void(const ASTNode*)> visit = [&](const ASTNode* node) {
+                if (node->type == NodeType::FUNCTION_CALL) {
+                    auto range = byName.equal_range(node->value);
+                    for (auto it = range.first; it != range.second; ++it) worklist.push_back(it->second);
+                }
+                for (auto& child : node->children) visit(child.get());
+            };
+            visit(body);
+        }
+
+        prunedBodies.clear();
+        reachableNodes = prunedNodes = 0;
+        for (auto& [name, body] : all) {
+            if (reachableBodies.count(body)) {
+                reachableNodes += countNodes(body);
+            } else {
+                prunedBodies.push_back({name, body});
+                prunedNodes += countNodes(body);
+            }
+        }
+    }
+
+    bool isReachable(const ASTNode* body) const { return reachableBodies.count(body) > 0; }
+
+    // Pruned functions, and the lowering time they would have cost at the
+    // rate (per AST node) measured for the functions that were lowered
+    void reportPrunedFunctions(double loweringSeconds) {
+        if (prunedBodies.empty()) return;
+        double perNode = reachableNodes ? loweringSeconds / reachableNodes : 0.0;
+        CAX_INFO(diag::CAT_IRGEN, "Call graph: " << prunedBodies.size() << " of "
+                 << (prunedBodies.size() + reachableBodies.size()) << " functions unreachable from main and "
+                 << "exported functions, not lowered (about " << fixed << setprecision(3)
+                 << perNode * prunedNodes * 1e3 << " ms saved)");
+        for (auto& [name, body] : prunedBodies) {
+            CAX_INFO(diag::CAT_IRGEN, "  pruned " << name << " (line " << body->line << ")");
+        }
     }
 
     // ============================================
@@ -264,38 +483,513 @@ public:
         return getInt32Type(); // Default
     }
 
+    // Convert a scalar to the requested type (int widths, int<->float).
+    // Returns the value unchanged if no conversion applies.
+    Value* convertValue(Value* value, Type* target) {
+        Type* source = value->getType();
+        if (source == target) return value;
+
+        if (source->isIntegerTy() && target->isIntegerTy()) {
+            if (source->isIntegerTy(1)) return builder->CreateZExt(value, target, "zext");
+            return builder->CreateSExtOrTrunc(value, target, "conv");
+        }
+        if (source->isIntegerTy() && target->isFloatingPointTy()) {
+            if (source->isIntegerTy(1)) return builder->CreateUIToFP(value, target, "uitofp");
+            return builder->CreateSIToFP(value, target, "sitofp");
+        }
+        if (source->isFloatingPointTy() && target->isIntegerTy()) {
+            return builder->CreateFPToSI(value, target, "fptosi");
+        }
+        if (source->isFloatingPointTy() && target->isFloatingPointTy()) {
+            return builder->CreateFPCast(value, target, "fpcast");
+        }
+        return value;
+    }
+
+    // Truth value of a scalar condition (non-zero / non-null)
+    Value* toBool(Value* value, const string& name) {
+        Type* type = value->getType();
+        if (type == getBoolType()) return value;
+        if (type->isFloatingPointTy()) {
+            return builder->CreateFCmpUNE(value, ConstantFP::get(type, 0.0), name);
+        }
+        if (type->isPointerTy()) return builder->CreateIsNotNull(value, name);
+        return builder->CreateICmpNE(value, ConstantInt::get(type, 0), name);
+    }
+
+    // ============================================
+    // TYPE INFERENCE
+    // ============================================
+    // .cax variables carry no declared type. Before a function body is
+    // lowered, each scalar local gets one static type: the join of every
+    // value assigned to it (integers widen i1 < i8 < i32 < i64, an integer
+    // and a float give the float, except i64 with f32 which gives f64).
+    // Codegen creates the slot with that type and casts at every
+    // assignment and operator, so each operation is well typed.
+    //
+    // Numeric literals are weak: they take the type of the other operand
+    // (x * 0.5 with an f32 x stays f32, n + 1 with an i64 n stays i64) and
+    // only pick i32/i64/f64 on their own. i8(), i32(), i64(), f32() and
+    // f64() convert explicitly.
+
+    struct StaticType {
+        Type* type = nullptr;       // nullptr: not known statically
+        bool weak = false;          // numeric literal (or only ever assigned one)
+    };
+
+    map<string, StaticType> localTypes;     // Scalar locals of the current function
+    map<string, Type*> elementTypes;        // Element type of its arrays and vectors
+
+    // i8(x), i32(x), i64(x), f32(x), f64(x)
+    Type* getCastBuiltinType(const string& name) {
+        if (name == "i8") return getInt8Type();
+        if (name == "i32") return getInt32Type();
+        if (name == "i64") return getInt64Type();
+        if (name == "f32") return getFloatType();
+        if (name == "f64") return getDoubleType();
+        return nullptr;
+    }
+
+    static bool isNumericType(Type* type) {
+        return type && (type->isIntegerTy() || type->isFloatingPointTy());
+    }
+
+    // Common type of two operands, nullptr if they do not mix (strings)
+    Type* joinTypes(Type* a, Type* b) {
+        if (!a) return b;
+        if (!b || a == b) return a;
+        if (!isNumericType(a) || !isNumericType(b)) return nullptr;
+
+        if (a->isIntegerTy() && b->isIntegerTy()) {
+            return a->getIntegerBitWidth() >= b->getIntegerBitWidth() ? a : b;
+        }
+        if (a->isFloatingPointTy() && b->isFloatingPointTy()) {
+            return a->isDoubleTy() ? a : b;
+        }
+        Type* floatType = a->isFloatingPointTy() ? a : b;
+        Type* intType = a->isIntegerTy() ? a : b;
+        if (floatType->isFloatTy() && intType->getIntegerBitWidth() > 32) return getDoubleType();
+        return floatType;
+    }
+
+    StaticType joinStatic(StaticType a, StaticType b) {
+        if (!a.type) return b;
+        if (!b.type) return a;
+        if (a.weak != b.weak && isNumericType(a.type) && isNumericType(b.type)) {
+            const StaticType& literal = a.weak ? a : b;
+            const StaticType& typed = a.weak ? b : a;
+            // The literal adopts the typed side unless that would lose it:
+            // a float literal next to an integer, or an integer literal too
+            // wide for the integer type
+            if (typed.type->isFloatingPointTy()) return typed;
+            if (literal.type->isIntegerTy() &&
+                literal.type->getIntegerBitWidth() <= typed.type->getIntegerBitWidth()) {
+                return typed;
+            }
+        }
+        return {joinTypes(a.type, b.type), a.weak && b.weak};
+    }
+
+    static bool isComparisonOp(const string& op) {
+        return op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=";
+    }
+
+    // Numeric literal, possibly negated
+    static bool isNumericLiteral(shared_ptr<ASTNode> node) {
+        if (node->type == NodeType::UNARY_OP && node->value == "-" && !node->children.empty()) {
+            node = node->children[0];
+        }
+        if (node->type != NodeType::LITERAL || node->value.empty()) return false;
+        const string& text = node->value;
+        return isdigit((unsigned char)text[0]) || (text.size() > 1 && text[0] == '-');
+    }
+
+    // Static type of an expression from the types inferred so far
+    StaticType typeOf(shared_ptr<ASTNode> node) {
+        switch (node->type) {
+            case NodeType::LITERAL: {
+                Value* constant = generateLiteralConstant(node->value);
+                return {constant ? constant->getType() : getPtrType(),
+                        isNumericLiteral(node) || node->value == "null"};
+            }
+            case NodeType::IDENTIFIER: {
+                auto it = localTypes.find(node->value);
+                if (it == localTypes.end()) return {};
+                return {it->second.type, false};
+            }
+            case NodeType::BINARY_OP: {
+                if (node->children.size() < 2) return {};
+                if (isComparisonOp(node->value) || node->value == "&&" || node->value == "||") {
+                    return {getBoolType(), false};
+                }
+                return joinStatic(typeOf(node->children[0]), typeOf(node->children[1]));
+            }
+            case NodeType::UNARY_OP:
+                if (node->children.empty()) return {};
+                if (node->value == "!") return {getBoolType(), false};
+                return typeOf(node->children[0]);
+            case NodeType::FUNCTION_CALL: {
+                const string& name = node->value;
+                shared_ptr<ASTNode> object;
+                if (Function* method = resolveMethod(node, object)) {
+                    Type* returnType = method->getReturnType();
+                    return {returnType->isVoidTy() ? nullptr : returnType, false};
+                }
+                auto userFunc = functions.find(name);
+                if (userFunc != functions.end() && userFunc->second) {
+                    Type* returnType = userFunc->second->getReturnType();
+                    return {returnType->isVoidTy() ? nullptr : returnType, false};
+                }
+                if (Type* castType = getCastBuiltinType(name)) return {castType, false};
+                if (findClass(name) && node->children.empty()) return {getPtrType(), false};
+                if (name == "len" || name == "size") return {getInt32Type(), false};
+                if (name == "dot" || name == "sum" || name == "vmax" || name == "vmin") {
+                    return {getDoubleType(), false};
+                }
+                if (name == "pop" && !node->children.empty()) return {elementTypeOf(node->children[0]), false};
+                return {};
+            }
+            case NodeType::ARRAY_ACCESS:
+                return {elementTypeOf(node), false};
+            case NodeType::MEMBER_ACCESS: {
+                const ClassInfo* info = node->children.empty() ? nullptr : classOf(node->children[0]);
+                if (!info) return {};
+                auto field = info->fieldIndex.find(node->value);
+                if (field == info->fieldIndex.end()) return {};
+                Type* fieldType = info->type->getElementType(field->second);
+                return {fieldType->isAggregateType() ? nullptr : fieldType, false};
+            }
+            default:
+                return {};
+        }
+    }
+
+    // Element type of the array or vector under a (possibly nested) index
+    Type* elementTypeOf(shared_ptr<ASTNode> node) {
+        while (node->type == NodeType::ARRAY_ACCESS && !node->children.empty()) {
+            node = node->children[0];
+        }
+        if (node->type != NodeType::IDENTIFIER) return nullptr;
+        auto it = elementTypes.find(node->value);
+        return it == elementTypes.end() ? nullptr : it->second;
+    }
+
+    // Join of the leaf element types of an array literal
+    StaticType arrayLiteralType(shared_ptr<ASTNode> node) {
+        StaticType result;
+        for (auto& child : node->children) {
+            StaticType element = child->type == NodeType::ARRAY_LITERAL ? arrayLiteralType(child) : typeOf(child);
+            StaticType joined = joinStatic(result, element);
+            if (joined.type) result = joined;
+        }
+        return result;
+    }
+
+    // Fixpoint over the function's assignments: a variable's type can
+    // depend on variables assigned later in the source (loops)
+    void inferLocalTypes(shared_ptr<ASTNode> funcNode) {
+        localTypes.clear();
+        elementTypes.clear();
+        objectClasses.clear();
+        vectorClasses.clear();
+        set<string> conflicts;
+
+        // In a method, fields have the types fixed by the class layout
+        set<string> fields;
+        if (currentClass) {
+            for (unsigned i = 0; i < currentClass->fields.size(); i++) {
+                const string& field = currentClass->fields[i];
+                Type* type = currentClass->type->getElementType(i);
+                fields.insert(field);
+                if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+                    elementTypes[field] = getArrayLeafType(arrayType);
+                } else if (isVectorType(type)) {
+                    elementTypes[field] = getVectorElementOf(cast<StructType>(type));
+                } else {
+                    localTypes[field] = {type, false};
+                }
+            }
+        }
+
+        bool changed = true;
+        for (int pass = 0; changed && pass < 16; pass++) {
+            changed = false;
+            auto assign = [&](const string& name, StaticType type) {
+                if (!type.type || fields.count(name)) return;
+                auto it = localTypes.find(name);
+                if (it == localTypes.end()) {
+                    localTypes[name] = type;
+                    changed = true;
+                    return;
+                }
+                StaticType joined = joinStatic(it->second, type);
+                if (!joined.type) {
+                    conflicts.insert(name);
+                    return;
+                }
+                if (joined.type != it->second.type || joined.weak != it->second.weak) {
+                    it->second = joined;
+                    changed = true;
+                }
+            };
+
+            function<void(shared_ptr<ASTNode>)> visit = [&](shared_ptr<ASTNode> node) {
+                if (node->type == NodeType::ASSIGNMENT && node->children.size() == 1) {
+                    shared_ptr<ASTNode> value = node->children[0];
+                    if (fields.count(node->value)) {
+                        // Fixed by the class layout
+                    } else if (value->type == NodeType::ARRAY_LITERAL) {
+                        Type* leaf = arrayLiteralType(value).type;
+                        Type*& current = elementTypes[node->value];
+                        if (leaf && current != leaf) {
+                            current = current ? joinTypes(current, leaf) : leaf;
+                            if (!current) current = leaf;
+                            changed = true;
+                        }
+                    } else {
+                        string objectClass = objectClassOf(value);
+                        if (!objectClass.empty() && !objectClasses.count(node->value)) {
+                            objectClasses[node->value] = objectClass;
+                            changed = true;
+                        }
+                        assign(node->value, typeOf(value));
+                    }
+                } else if (node->type == NodeType::RANGE_FOR) {
+                    // Induction variables are i32, or i64 when a bound is
+                    StaticType bound = {getInt32Type(), false};
+                    if (!node->children.empty()) {
+                        for (auto& arg : node->children[0]->children) {
+                            StaticType argType = typeOf(arg);
+                            if (argType.type && argType.type->isIntegerTy(64)) bound.type = argType.type;
+                        }
+                    }
+                    assign(node->value, bound);
+                } else if (node->type == NodeType::VECTOR_DECL && findClass(node->attributes["elementType"])) {
+                    vectorClasses[node->value] = node->attributes["elementType"];
+                } else if (node->type == NodeType::VECTOR_DECL && !fields.count(node->value)) {
+                    auto typeIt = node->attributes.find("elementType");
+                    Type* element = typeIt == node->attributes.end() ? nullptr : vectorElementTypeNamed(typeIt->second);
+                    if (element && elementTypes[node->value] != element) {
+                        elementTypes[node->value] = element;
+                        changed = true;
+                    }
+                }
+                for (auto& child : node->children) visit(child);
+            };
+            visit(funcNode);
+        }
+
+        for (const string& name : conflicts) {
+            CAX_WARN(diag::CAT_IRGEN, "Variable '" << name << "' in " << funcNode->value
+                     << " is assigned values of incompatible types; keeping "
+                     << getTypeSuffix(localTypes[name].type));
+        }
+        if (CAX_LOG_ENABLED(Debug, diag::CAT_IRGEN)) {
+            string summary;
+            for (auto& entry : localTypes) {
+                summary += (summary.empty() ? "" : ", ") + entry.first + ": " + getTypeSuffix(entry.second.type);
+            }
+            CAX_DEBUG(diag::CAT_IRGEN, "Types in " << funcNode->value << ": "
+                      << (summary.empty() ? string("(none)") : summary));
+        }
+    }
+
+    // Slot type for a new local: its inferred type when both are scalars
+    Type* getLocalType(const string& name, Type* valueType) {
+        auto it = localTypes.find(name);
+        if (it != localTypes.end() && isNumericType(it->second.type) && isNumericType(valueType)) {
+            return it->second.type;
+        }
+        return valueType;
+    }
+
+    // ============================================
+    // SSA CONSTRUCTION
+    // ============================================
+    // Scalar locals get no stack slot. An assignment records the value as
+    // the variable's current definition in the current block; a read looks
+    // it up there and otherwise walks back through the predecessors,
+    // placing a phi where paths meet (Braun et al., "Simple and Efficient
+    // Construction of Static Single Assignment Form", CC 2013). Phis that
+    // end up merging a single value are removed again, so -O0 code carries
+    // no loads, stores or redundant phis for scalars.
+    //
+    // A block is sealed once all its predecessors exist. Control flow is
+    // structured, so every block is complete before code reads from it,
+    // except loop headers: they are opened with beginLoopHeader(), collect
+    // incomplete phis, and are sealed once the latch branch is emitted.
+    // Arrays and vectors keep their stack slots (namedValues).
+
+    map<string, Type*> scalarTypes;                               // SSA locals
+    map<BasicBlock*, map<string, Value*>> currentDefs;
+    set<BasicBlock*> unsealedBlocks;
+    map<BasicBlock*, vector<pair<string, PHINode*>>> incompletePhis;
+    int phisPlaced = 0;
+    int phisRemoved = 0;
+
+    bool isScalarVariable(const string& name) { return scalarTypes.count(name) > 0; }
+
+    void writeVariable(const string& name, Value* value) {
+        currentDefs[builder->GetInsertBlock()][name] = convertValue(value, scalarTypes[name]);
+    }
+
+    Value* readVariable(const string& name) { return readVariable(name, builder->GetInsertBlock()); }
+
+    Value* readVariable(const string& name, BasicBlock* block) {
+        auto blockIt = currentDefs.find(block);
+        if (blockIt != currentDefs.end()) {
+            auto it = blockIt->second.find(name);
+            if (it != blockIt->second.end()) return it->second;
+        }
+
+        Type* type = scalarTypes[name];
+        Value* value;
+        if (unsealedBlocks.count(block)) {
+            PHINode* phi = createPhi(name, type, block);
+            incompletePhis[block].push_back({name, phi});
+            value = phi;
+        } else if (BasicBlock* pred = block->getSinglePredecessor()) {
+            value = readVariable(name, pred);
+        } else if (pred_empty(block)) {
+            // Not assigned on any path that reaches this point
+            value = Constant::getNullValue(type);
+        } else {
+            // Record the phi first: a loop can lead back here
+            PHINode* phi = createPhi(name, type, block);
+            currentDefs[block][name] = phi;
+            value = addPhiOperands(name, phi);
+        }
+        currentDefs[block][name] = value;
+        return value;
+    }
+
+    PHINode* createPhi(const string& name, Type* type, BasicBlock* block) {
+        phisPlaced++;
+        if (Instruction* first = block->getFirstNonPHI()) {
+            return PHINode::Create(type, 2, name, first);
+        }
+        return PHINode::Create(type, 2, name, block);
+    }
+
+    Value* addPhiOperands(const string& name, PHINode* phi) {
+        for (BasicBlock* pred : predecessors(phi->getParent())) {
+            phi->addIncoming(readVariable(name, pred), pred);
+        }
+        return tryRemoveTrivialPhi(phi);
+    }
+
+    // A phi whose operands are itself and one other value is that value
+    Value* tryRemoveTrivialPhi(PHINode* phi) {
+        if (unsealedBlocks.count(phi->getParent())) return phi;   // Operands still to come
+
+        Value* same = nullptr;
+        for (Value* operand : phi->incoming_values()) {
+            if (operand == same || operand == phi) continue;
+            if (same) return phi;
+            same = operand;
+        }
+        if (!same) same = Constant::getNullValue(phi->getType());
+
+        vector<WeakVH> phiUsers;
+        for (User* user : phi->users()) {
+            if (user != phi && isa<PHINode>(user)) phiUsers.push_back(user);
+        }
+        WeakTrackingVH result = same;
+        phi->replaceAllUsesWith(same);
+        for (auto& block : currentDefs) {
+            for (auto& def : block.second) {
+                if (def.second == phi) def.second = same;
+            }
+        }
+        phi->eraseFromParent();
+        phisRemoved++;
+
+        // Users may have become trivial in turn
+        for (WeakVH& user : phiUsers) {
+            if (auto* userPhi = dyn_cast_or_null<PHINode>(static_cast<Value*>(user))) {
+                tryRemoveTrivialPhi(userPhi);
+            }
+        }
+        return result;
+    }
+
+    // Loop headers are entered before their back edge exists
+    void beginLoopHeader(BasicBlock* header) { unsealedBlocks.insert(header); }
+
+    void sealBlock(BasicBlock* block) {
+        auto it = incompletePhis.find(block);
+        if (it != incompletePhis.end()) {
+            vector<pair<string, PHINode*>> phis;
+            phis.swap(it->second);
+            incompletePhis.erase(it);
+            vector<WeakVH> added;
+            for (auto& entry : phis) {
+                addPhiOperands(entry.first, entry.second);
+                added.push_back(entry.second);
+            }
+            unsealedBlocks.erase(block);
+            for (WeakVH& handle : added) {
+                if (auto* phi = dyn_cast_or_null<PHINode>(static_cast<Value*>(handle))) {
+                    tryRemoveTrivialPhi(phi);
+                }
+            }
+        }
+        unsealedBlocks.erase(block);
+    }
+
     // ============================================
     // CODE GENERATION FROM AST
     // ============================================
 
     void generateProgram(shared_ptr<ASTNode> ast) {
         if (!ast || ast->type != NodeType::PROGRAM) {
-            cerr << "Error: Invalid AST root" << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Invalid AST root");
             return;
         }
 
-        cout << "Generating IR from AST... (debug check)\n";
+        CAX_INFO(diag::CAT_IRGEN, "Generating IR from AST...");
 
-        // First pass: declare all functions
+        // First pass: declare the functions that can run
+        findReachableFunctions(ast);
         for (auto& child : ast->children) {
-            if (child->type == NodeType::FUNCTION_DECL) {
+            if (child->type == NodeType::FUNCTION_DECL && isReachable(child.get())) {
                 declareFunction(child);
             }
         }
 
+        // Class layouts, which need the functions' return types, then
+        // their methods, which need the layouts
+        for (auto& child : ast->children) {
+            if (child->type == NodeType::CLASS_DECL) {
+                declareClass(child);
+            }
+        }
+        for (auto& entry : classes) {
+            declareMethods(entry.second);
+        }
+
+        // exec directives apply to the whole program, wherever they appear
+        for (auto& child : ast->children) {
+            if (child->type == NodeType::EXEC_STMT) {
+                readExecDirective(child);
+            }
+        }
+
         // Second pass: generate function bodies
+        auto loweringStart = chrono::steady_clock::now();
         for (auto& child : ast->children) {
-            if (child->type == NodeType::FUNCTION_DECL) {
+            if (child->type == NodeType::FUNCTION_DECL && isReachable(child.get())) {
                 generateFunction(child);
-            } else if (child->type == NodeType::EXEC_STMT) {
-                // Handle exec directives (could be used for optimization hints)
-                // For now, we'll skip them
             }
         }
+        for (auto& entry : classes) {
+            generateMethods(entry.second);
+        }
+        double loweringSeconds = chrono::duration<double>(chrono::steady_clock::now() - loweringStart).count();
 
         // Check if main function was created
         if (functions.find("main") == functions.end()) {
-            cout << "Warning: No main function found, creating empty main..." << endl;
+            CAX_WARN(diag::CAT_IRGEN, "No main function found, creating empty main...");
 
             // Create a simple main that returns 0
             FunctionType* mainType = FunctionType::get(getInt32Type(), {}, false);
@@ -307,8 +1001,33 @@ public:
 
             functions["main"] = mainFunc;
         }
-
-        cout << "IR generation completed!" << endl;
+        finishProfile();
+        finishInstrumentation();
+
+        CAX_DEBUG(diag::CAT_IRGEN, "Constant pool: " << stringPool.size() << " strings, "
+                  << stringPoolHits << " duplicate uses merged");
+        if (boundsCheckMode == BoundsCheckMode::Auto) {
+            CAX_INFO(diag::CAT_IRGEN, "Bounds checks: " << boundsCheckSites << " array accesses, "
+                     << boundsChecksElided << " proven in range and removed, "
+                     << (boundsCheckSites - boundsChecksElided) << " kept");
+        }
+        if (parallelLoopsEnabled()) {
+            CAX_INFO(diag::CAT_IRGEN, "Parallel loops: " << parallelLoops << " outlined for "
+                     << (execThreads > 0 ? to_string(execThreads) : string("budgeted")) << " threads (chunk fraction "
+                     << execFraction << ")");
+        }
+        if (objectSites > 0) {
+            CAX_INFO(diag::CAT_IRGEN, "Objects: " << objectSites << " allocation sites, " << stackObjectSites
+                     << " heap allocations elided (stack), " << (objectSites - stackObjectSites) << " on the heap");
+        }
+        int exportedFunctions = 0;
+        for (auto& entry : functions) {
+            if (entry.second && entry.second->hasExternalLinkage()) exportedFunctions++;
+        }
+        CAX_INFO(diag::CAT_IRGEN, "Functions: " << internalFunctions << " internal (fastcc), "
+                 << exportedFunctions << " exported");
+        reportPrunedFunctions(loweringSeconds);
+        CAX_INFO(diag::CAT_IRGEN, "IR generation completed!");
     }
 
     void generateFunction(shared_ptr<ASTNode> node) {
@@ -323,18 +1042,48 @@ public:
 
         Function* func = functions[funcName];
         if (!func) {
-            cerr << "Error: Function " << funcName << " not declared" << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Function " << funcName << " not declared");
             return;
         }
+        generateFunctionBody(node, func, isMain);
+    }
 
+    void generateFunctionBody(shared_ptr<ASTNode> node, Function* func, bool isMain) {
+        const string funcName = func->getName().str();
         currentFunction = func;
+        currentFunctionNode = node.get();
 
         // Create entry block
         BasicBlock* entryBB = BasicBlock::Create(*context, "entry", func);
         builder->SetInsertPoint(entryBB);
 
+        if (isMain && execThreads > 0) {
+            Function* configure = getRuntimeFunction("cax_parallel_configure", getVoidType(),
+                                                     {getInt32Type(), getDoubleType()});
+            builder->CreateCall(configure, {builder->getInt32(execThreads),
+                                            ConstantFP::get(getDoubleType(), execFraction)});
+        }
+        if (isMain && execCpus >= 0) {
+            Function* budget = getRuntimeFunction("cax_parallel_cpu_budget", getVoidType(),
+                                                  {getInt32Type(), getDoubleType()});
+            builder->CreateCall(budget, {builder->getInt32(execCpus),
+                                         ConstantFP::get(getDoubleType(), execWeight)});
+        }
+        beginFunctionProfile(func, isMain);
+        beginFunctionInstrumentation(func, node, isMain);
+
         // Clear local variable table
         namedValues.clear();
+        scalarTypes.clear();
+        currentDefs.clear();
+        functionVectors.clear();
+        objectVectors.clear();
+        boundArrays.clear();
+        mutableArrays = findMutableArrays(node);
+        statementTemporaries.clear();
+        findScopedLocals(node);
+        inferLocalTypes(node);
+        findStackObjects(node);
 
         // Generate function body
         if (!node->children.empty() && node->children[0]->type == NodeType::BLOCK) {
@@ -343,23 +1092,58 @@ public:
 
         // Add return if not present
         if (!builder->GetInsertBlock()->getTerminator()) {
+            emitVectorCleanup();
+            emitFunctionExit();
             if (isMain) {
                 builder->CreateRet(ConstantInt::get(*context, APInt(32, 0, true)));
-            } else {
+            } else if (func->getReturnType()->isVoidTy()) {
                 builder->CreateRetVoid();
+            } else {
+                builder->CreateRet(Constant::getNullValue(func->getReturnType()));
             }
         }
 
+        CAX_DEBUG(diag::CAT_IRGEN, "SSA for " << funcName << ": " << scalarTypes.size() << " scalars, "
+                  << phisPlaced << " phis placed, " << phisRemoved << " removed as trivial");
+        phisPlaced = phisRemoved = 0;
+
         currentFunction = nullptr;
+        currentFunctionNode = nullptr;
     }
 
     void generateBlock(shared_ptr<ASTNode> node) {
         for (auto& stmt : node->children) {
             generateStatement(stmt);
         }
+
+        // Locals scoped to this block die here
+        auto scopeIt = scopedLocals.find(node.get());
+        if (scopeIt != scopedLocals.end() && !builder->GetInsertBlock()->getTerminator()) {
+            for (const string& name : scopeIt->second) {
+                auto varIt = namedValues.find(name);
+                if (varIt != namedValues.end() && varIt->second) {
+                    emitLifetime(false, varIt->second);
+                }
+            }
+        }
     }
 
     void generateStatement(shared_ptr<ASTNode> node) {
+        size_t temporaryMark = statementTemporaries.size();
+        generateStatementBody(node);
+
+        // Temporaries built by this statement are dead once it completes
+        if (statementTemporaries.size() > temporaryMark) {
+            if (!builder->GetInsertBlock()->getTerminator()) {
+                for (size_t i = temporaryMark; i < statementTemporaries.size(); i++) {
+                    emitLifetime(false, statementTemporaries[i]);
+                }
+            }
+            statementTemporaries.resize(temporaryMark);
+        }
+    }
+
+    void generateStatementBody(shared_ptr<ASTNode> node) {
         switch (node->type) {
             case NodeType::ASSIGNMENT:
                 generateAssignment(node);
@@ -398,60 +1182,352 @@ public:
         string varName = node->value;
 
         if (node->children.empty()) {
-            cerr << "Error: Assignment has no value" << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Assignment has no value");
+            return;
+        }
+
+        if (node->attributes.count("member")) {
+            generateElementFieldAssignment(node);
+            return;
+        }
+
+        // Indexed assignment: name[index] (op)= value
+        if (node->children.size() >= 2) {
+            generateIndexedAssignment(node);
             return;
         }
 
         Value* value = generateExpression(node->children[0]);
         if (!value) return;
 
-        // Check if variable exists
-        AllocaInst* var = namedValues[varName];
+        if (isField(varName)) {
+            generateFieldAssignment(node, value);
+            return;
+        }
 
-        if (!var) {
-            // Create new variable with appropriate type
-            Type* allocaType = value->getType();
-
-            // Special handling for array literals - allocate array type
-            if (node->children[0]->type == NodeType::ARRAY_LITERAL) {
-                int arraySize = node->children[0]->children.size();
-                if (arraySize > 0) {
-                    // Get the type of first element
-                    Type* elemType = value->getType();
-                    allocaType = ArrayType::get(elemType, arraySize);
-                }
+        if (ArrayType* arrayType = assignedArrayType(node->children[0], value)) {
+            generateArrayAssignment(node, value, arrayType);
+            return;
+        }
+
+        // Arrays and vectors live in stack slots; anything else is SSA
+        auto slotIt = namedValues.find(varName);
+        if (slotIt != namedValues.end() && slotIt->second) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign a " << getTypeSuffix(value->getType()) << " value to '"
+                      << varName << "' (array or vector) on line " << node->line);
+            return;
+        }
+
+        // Compound assignment: x += v  ->  x = x + v
+        auto opIt = node->attributes.find("operator");
+        if (opIt != node->attributes.end()) {
+            if (!isScalarVariable(varName)) {
+                CAX_ERROR(diag::CAT_IRGEN, "Compound assignment to undefined variable: " << varName);
+                return;
             }
+            Value* current = readVariable(varName);
+            value = createArithmetic(opIt->second.substr(0, 1), current,
+                                     convertValue(value, current->getType()));
+            if (!value) return;
+        }
 
-            var = createEntryBlockAlloca(currentFunction, varName, allocaType);
-            namedValues[varName] = var;
+        if (!isScalarVariable(varName)) {
+            // New variable with its inferred type
+            scalarTypes[varName] = getLocalType(varName, value->getType());
         }
 
-        builder->CreateStore(value, var);
+        Type* varType = scalarTypes[varName];
+        value = convertValue(value, varType);
+        if (value->getType() != varType) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign a " << getTypeSuffix(value->getType()) << " value to '"
+                      << varName << "' (" << getTypeSuffix(varType) << ") on line " << node->line);
+            return;
+        }
+        writeVariable(varName, value);
     }
 
-    void generateIf(shared_ptr<ASTNode> node) {
-        if (node->children.size() < 2) return;
-
-        Value* cond = generateExpression(node->children[0]);
-        if (!cond) return;
+    // field = value inside a method: a store to `this` (array fields copy
+    // the literal in)
+    void generateFieldAssignment(shared_ptr<ASTNode> node, Value* value) {
+        const string& name = node->value;
+        Type* type = fieldType(name);
+        Value* addr = fieldAddress(name);
+
+        if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+            if (getArrayStorageType(value) != arrayType) {
+                CAX_ERROR(diag::CAT_IRGEN, "Field '" << name << "' is a fixed-size array; the value on line "
+                          << node->line << " does not have its shape");
+                return;
+            }
+            const DataLayout& layout = module->getDataLayout();
+            Align align = layout.getABITypeAlign(getArrayLeafType(arrayType));
+            builder->CreateMemCpy(addr, align, value, align, layout.getTypeAllocSize(arrayType));
+            return;
+        }
+        if (type->isAggregateType()) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign to vector field '" << name << "' on line " << node->line);
+            return;
+        }
 
-        // Convert condition to boolean if needed
-        if (cond->getType() != getBoolType()) {
-            cond = builder->CreateICmpNE(cond,
-                ConstantInt::get(cond->getType(), 0), "ifcond");
+        auto opIt = node->attributes.find("operator");
+        if (opIt != node->attributes.end()) {
+            Value* current = builder->CreateLoad(type, addr, name);
+            value = createArithmetic(opIt->second.substr(0, 1), current, convertValue(value, type));
+            if (!value) return;
+        }
+        value = convertValue(value, type);
+        if (value->getType() != type) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign a " << getTypeSuffix(value->getType()) << " value to field '"
+                      << name << "' (" << getTypeSuffix(type) << ") on line " << node->line);
+            return;
         }
+        builder->CreateStore(value, addr);
+    }
 
-        BasicBlock* thenBB = BasicBlock::Create(*context, "then", currentFunction);
-        BasicBlock* elseBB = node->children.size() > 2 ?
-            BasicBlock::Create(*context, "else") : nullptr;
-        BasicBlock* mergeBB = BasicBlock::Create(*context, "ifcont");
+    // Shape of the array an assignment's right-hand side evaluated to: an
+    // array literal, or another array variable (its slot or bound storage)
+    ArrayType* assignedArrayType(shared_ptr<ASTNode> rhs, Value* value) {
+        if (rhs->type == NodeType::ARRAY_LITERAL) {
+            return getArrayStorageType(value);
+        }
+        if (rhs->type != NodeType::IDENTIFIER || isField(rhs->value)) {
+            return nullptr;
+        }
+        auto boundIt = boundArrays.find(rhs->value);
+        if (boundIt != boundArrays.end()) {
+            return boundIt->second.type;
+        }
+        auto slotIt = namedValues.find(rhs->value);
+        if (slotIt != namedValues.end() && slotIt->second == value) {
+            return getArrayStorageType(value);
+        }
+        return nullptr;
+    }
 
-        if (elseBB) {
-            builder->CreateCondBr(cond, thenBB, elseBB);
-        } else {
-            builder->CreateCondBr(cond, thenBB, mergeBB);
+    // name = [ ... ] or name = other: `storage` points at the source array
+    // (a literal's constant global or stack temporary, or another array
+    // variable's storage)
+    void generateArrayAssignment(shared_ptr<ASTNode> node, Value* storage, ArrayType* arrayType) {
+        const string& varName = node->value;
+        shared_ptr<ASTNode> source = node->children[0];
+        bool fromLiteral = source->type == NodeType::ARRAY_LITERAL;
+
+        // Never written and bound only here: use the constant in place
+        if (!mutableArrays.count(varName) && isa<GlobalVariable>(storage)) {
+            boundArrays[varName] = {storage, arrayType};
+            return;
         }
 
+        AllocaInst* var = namedValues[varName];
+
+        // First binding of a literal built on the stack: the temporary becomes
+        // the variable (its lifetime.start already precedes the element stores)
+        if (!var && fromLiteral && isa<AllocaInst>(storage)) {
+            AllocaInst* slot = cast<AllocaInst>(storage);
+            statementTemporaries.erase(
+                remove(statementTemporaries.begin(), statementTemporaries.end(), slot),
+                statementTemporaries.end());
+            slot->setName(varName);
+            namedValues[varName] = slot;
+            return;
+        }
+
+        if (!var || var->getAllocatedType() != arrayType) {
+            var = createEntryBlockAlloca(currentFunction, varName, arrayType);
+            if (MDNode* shapeInfo = getShapeMetadata(arrayType)) {
+                var->setMetadata("cax.shape", shapeInfo);
+            }
+            namedValues[varName] = var;
+        }
+
+        if (scopedDefinitions.count(node.get())) {
+            emitLifetime(true, var);
+        }
+
+        // One memcpy from the source instead of an aggregate store
+        const DataLayout& layout = module->getDataLayout();
+        Align align = layout.getABITypeAlign(getArrayLeafType(arrayType));
+        builder->CreateMemCpy(var, align, storage, align, layout.getTypeAllocSize(arrayType));
+    }
+
+    // Arrays that are written through an index or assigned more than once
+    // need their own storage; everything else can alias its literal
+    set<string> findMutableArrays(shared_ptr<ASTNode> root) {
+        set<string> written;
+        map<string, int> assignCount;
+
+        function<void(shared_ptr<ASTNode>)> visit = [&](shared_ptr<ASTNode> node) {
+            if (!node) return;
+            if (node->type == NodeType::ASSIGNMENT) {
+                if (node->children.size() >= 2) {
+                    written.insert(node->value);
+                } else {
+                    assignCount[node->value]++;
+                }
+            } else if (node->type == NodeType::FUNCTION_CALL) {
+                // Output operand of a tensor kernel
+                int output = tensorOutputArg(node->value);
+                if (output >= 0 && (int)node->children.size() > output &&
+                    node->children[output]->type == NodeType::IDENTIFIER) {
+                    written.insert(node->children[output]->value);
+                }
+            }
+            for (auto& child : node->children) {
+                visit(child);
+            }
+        };
+        visit(root);
+
+        for (auto& entry : assignCount) {
+            if (entry.second > 1) written.insert(entry.first);
+        }
+        return written;
+    }
+
+    // A local is block-scoped when every reference to it sits inside one
+    // nested block and the first of them is a plain assignment made
+    // directly in that block (so each entry into the block writes it before
+    // any read, and nothing outside the block can observe it).
+    void findScopedLocals(shared_ptr<ASTNode> root) {
+        scopedLocals.clear();
+        scopedDefinitions.clear();
+
+        struct LocalUses {
+            vector<const ASTNode*> blocks;   // Innermost common block path
+            const ASTNode* first = nullptr;  // First reference in source order
+            const ASTNode* firstParent = nullptr;
+            bool excluded = false;
+        };
+        map<string, LocalUses> uses;
+        vector<const ASTNode*> blockPath;
+
+        auto reference = [&](const string& name, const ASTNode* node, const ASTNode* parent) {
+            auto inserted = uses.emplace(name, LocalUses());
+            LocalUses& local = inserted.first->second;
+            if (inserted.second) {
+                local.blocks = blockPath;
+                local.first = node;
+                local.firstParent = parent;
+                return;
+            }
+            size_t common = 0;
+            while (common < local.blocks.size() && common < blockPath.size() &&
+                   local.blocks[common] == blockPath[common]) {
+                common++;
+            }
+            local.blocks.resize(common);
+        };
+
+        function<bool(const ASTNode*, const string&)> mentions = [&](const ASTNode* node, const string& name) {
+            if (node->type == NodeType::IDENTIFIER && node->value == name) return true;
+            for (auto& child : node->children) {
+                if (mentions(child.get(), name)) return true;
+            }
+            return false;
+        };
+
+        function<void(const ASTNode*, const ASTNode*)> visit = [&](const ASTNode* node, const ASTNode* parent) {
+            if (node->type == NodeType::ASSIGNMENT || node->type == NodeType::IDENTIFIER ||
+                node->type == NodeType::RANGE_FOR) {
+                reference(node->value, node, parent);
+            } else if (node->type == NodeType::VECTOR_DECL) {
+                // Vector slots are freed at function exit, so they stay function-wide
+                uses[node->value].excluded = true;
+            }
+
+            bool isBlock = node->type == NodeType::BLOCK;
+            if (isBlock) blockPath.push_back(node);
+            for (auto& child : node->children) {
+                visit(child.get(), node);
+            }
+            if (isBlock) blockPath.pop_back();
+        };
+        visit(root.get(), nullptr);
+
+        for (auto& entry : uses) {
+            const LocalUses& local = entry.second;
+            // blocks[0] is the function body; those locals are function-wide anyway
+            if (local.excluded || local.blocks.size() < 2) continue;
+
+            const ASTNode* scope = local.blocks.back();
+            const ASTNode* def = local.first;
+            if (def->type != NodeType::ASSIGNMENT || local.firstParent != scope) continue;
+            if (def->children.size() != 1 || def->attributes.count("operator")) continue;
+            if (mentions(def->children[0].get(), entry.first)) continue;
+
+            scopedLocals[scope].push_back(entry.first);
+            scopedDefinitions[def] = entry.first;
+        }
+
+        CAX_DEBUG(diag::CAT_IRGEN, "Block-scoped locals: " << scopedDefinitions.size());
+    }
+
+    // llvm.lifetime.start/end covering the whole of `slot`
+    void emitLifetime(bool start, AllocaInst* slot) {
+        const DataLayout& layout = module->getDataLayout();
+        ConstantInt* size = builder->getInt64(layout.getTypeAllocSize(slot->getAllocatedType()));
+        if (start) {
+            builder->CreateLifetimeStart(slot, size);
+        } else {
+            builder->CreateLifetimeEnd(slot, size);
+        }
+    }
+
+    // Scalar element type of a (possibly multi-dimensional) array
+    Type* getArrayLeafType(ArrayType* type) {
+        Type* level = type;
+        while (auto* array = dyn_cast<ArrayType>(level)) {
+            level = array->getElementType();
+        }
+        return level;
+    }
+
+    // Static array type of `name` or of a partial index like `m[i]`,
+    // without generating code
+    ArrayType* staticArrayTypeOf(shared_ptr<ASTNode> node) {
+        if (node->type == NodeType::IDENTIFIER) {
+            if (isField(node->value)) return dyn_cast<ArrayType>(fieldType(node->value));
+            auto boundIt = boundArrays.find(node->value);
+            if (boundIt != boundArrays.end()) return boundIt->second.type;
+            auto varIt = namedValues.find(node->value);
+            if (varIt != namedValues.end() && varIt->second) return getArrayStorageType(varIt->second);
+            return nullptr;
+        }
+        if (node->type == NodeType::ARRAY_ACCESS && !node->children.empty()) {
+            ArrayType* outer = staticArrayTypeOf(node->children[0]);
+            return outer ? dyn_cast<ArrayType>(outer->getElementType()) : nullptr;
+        }
+        return nullptr;
+    }
+
+    // Array type behind a pointer produced by an array literal or variable
+    ArrayType* getArrayStorageType(Value* storage) {
+        if (auto* global = dyn_cast<GlobalVariable>(storage)) {
+            return dyn_cast<ArrayType>(global->getValueType());
+        }
+        if (auto* slot = dyn_cast<AllocaInst>(storage)) {
+            return dyn_cast<ArrayType>(slot->getAllocatedType());
+        }
+        return nullptr;
+    }
+
+    void generateIf(shared_ptr<ASTNode> node) {
+        if (node->children.size() < 2) return;
+
+        Value* cond = generateExpression(node->children[0]);
+        if (!cond) return;
+
+        // Convert condition to boolean if needed
+        cond = toBool(cond, "ifcond");
+
+        BasicBlock* thenBB = BasicBlock::Create(*context, "then", currentFunction);
+        BasicBlock* elseBB = node->children.size() > 2 ?
+            BasicBlock::Create(*context, "else") : nullptr;
+        BasicBlock* mergeBB = BasicBlock::Create(*context, "ifcont");
+
+        countBranch(node, cond);
+        createProfiledCondBr(node, "if", cond, thenBB, elseBB ? elseBB : mergeBB);
+
         // Then block
         builder->SetInsertPoint(thenBB);
         generateBlock(node->children[1]);
@@ -481,21 +1557,21 @@ public:
         BasicBlock* bodyBB = BasicBlock::Create(*context, "whilebody");
         BasicBlock* afterBB = BasicBlock::Create(*context, "afterwhile");
 
+        LoopTrips trips = beginLoopTrips(node);
         builder->CreateBr(condBB);
+        beginLoopHeader(condBB);
         builder->SetInsertPoint(condBB);
 
         Value* cond = generateExpression(node->children[0]);
         if (!cond) return;
 
-        if (cond->getType() != getBoolType()) {
-            cond = builder->CreateICmpNE(cond,
-                ConstantInt::get(cond->getType(), 0), "whilecond");
-        }
+        cond = toBool(cond, "whilecond");
 
-        builder->CreateCondBr(cond, bodyBB, afterBB);
+        createProfiledCondBr(node, "while", cond, bodyBB, afterBB);
 
         currentFunction->insert(currentFunction->end(), bodyBB);
         builder->SetInsertPoint(bodyBB);
+        countLoopTrip(trips);
 
         // Push loop context
         loopStack.push({condBB, afterBB});
@@ -508,43 +1584,63 @@ public:
         if (!builder->GetInsertBlock()->getTerminator()) {
             builder->CreateBr(condBB);
         }
+        sealBlock(condBB);
 
         currentFunction->insert(currentFunction->end(), afterBB);
         builder->SetInsertPoint(afterBB);
+        endLoopTrips(trips);
     }
 
     void generateFor(shared_ptr<ASTNode> node) {
+        if (node->children.size() == 2 && node->children[0]->type == NodeType::RANGE_FOR) {
+            generateRangeFor(node);
+            return;
+        }
         if (node->children.size() < 4) return;
 
         // Init
         generateStatement(node->children[0]);
 
+        if (parallelLoopsEnabled() && !inParallelBody && generateParallelFor(node)) {
+            return;
+        }
+
         BasicBlock* condBB = BasicBlock::Create(*context, "forcond", currentFunction);
         BasicBlock* bodyBB = BasicBlock::Create(*context, "forbody");
         BasicBlock* incBB = BasicBlock::Create(*context, "forinc");
         BasicBlock* afterBB = BasicBlock::Create(*context, "afterfor");
 
+        LoopTrips trips = beginLoopTrips(node);
         builder->CreateBr(condBB);
+        beginLoopHeader(condBB);
         builder->SetInsertPoint(condBB);
 
         Value* cond = generateExpression(node->children[1]);
         if (!cond) return;
 
-        if (cond->getType() != getBoolType()) {
-            cond = builder->CreateICmpNE(cond,
-                ConstantInt::get(cond->getType(), 0), "forcond");
-        }
+        cond = toBool(cond, "forcond");
 
-        builder->CreateCondBr(cond, bodyBB, afterBB);
+        createProfiledCondBr(node, "for", cond, bodyBB, afterBB);
 
         currentFunction->insert(currentFunction->end(), bodyBB);
         builder->SetInsertPoint(bodyBB);
+        countLoopTrip(trips);
 
         // Push loop context
         loopStack.push({incBB, afterBB});
 
+        IndexRange inductionRange;
+        string inductionVar = findInductionRange(node, inductionRange);
+        if (!inductionVar.empty()) {
+            inductionRanges.push_back({inductionVar, inductionRange});
+        }
+
         generateBlock(node->children[3]);
 
+        if (!inductionVar.empty()) {
+            inductionRanges.pop_back();
+        }
+
         // Pop loop context
         loopStack.pop();
 
@@ -557,19 +1653,205 @@ public:
 
         generateStatement(node->children[2]); // Increment
 
+        attachLoopMetadata(builder->CreateBr(condBB), node, false);
+        sealBlock(condBB);
+
+        currentFunction->insert(currentFunction->end(), afterBB);
+        builder->SetInsertPoint(afterBB);
+        endLoopTrips(trips);
+    }
+
+    // for (v in range(end)) / range(begin, end) / range(begin, end, step)
+    // as a canonical counted loop: the bounds are evaluated once, an i32
+    // (or i64) induction PHI steps by a constant with `add nsw`, and `v`
+    // is stored from it at the top of each iteration. No range is built.
+    void generateRangeFor(shared_ptr<ASTNode> node) {
+        shared_ptr<ASTNode> rangeNode = node->children[0];
+        shared_ptr<ASTNode> body = node->children[1];
+        const string& var = rangeNode->value;
+
+        shared_ptr<ASTNode> call = rangeNode->children.empty() ? nullptr : rangeNode->children[0];
+        if (!call || call->type != NodeType::FUNCTION_CALL || call->value != "range" ||
+            call->children.empty() || call->children.size() > 3) {
+            CAX_ERROR(diag::CAT_IRGEN, "for (" << var << " in ...) on line " << node->line
+                      << " needs range(end), range(begin, end) or range(begin, end, step)");
+            return;
+        }
+
+        int64_t step = 1;
+        if (call->children.size() == 3) {
+            IndexRange stepRange;
+            if (!indexRangeOf(call->children[2], stepRange) || stepRange.lo != stepRange.hi || stepRange.lo == 0) {
+                CAX_ERROR(diag::CAT_IRGEN, "range() step on line " << node->line
+                          << " must be a non-zero integer constant");
+                return;
+            }
+            step = stepRange.lo;
+        }
+        shared_ptr<ASTNode> beginNode = call->children.size() >= 2 ? call->children[0] : nullptr;
+        shared_ptr<ASTNode> endNode = call->children.size() >= 2 ? call->children[1] : call->children[0];
+
+        // Hoisted bounds
+        Value* begin = beginNode ? generateExpression(beginNode) : builder->getInt32(0);
+        Value* end = generateExpression(endNode);
+        if (!begin || !end) return;
+        Type* inductionType = begin->getType()->isIntegerTy(64) || end->getType()->isIntegerTy(64)
+            ? getInt64Type() : getInt32Type();
+        begin = convertValue(begin, inductionType);
+        end = convertValue(end, inductionType);
+
+        if (!isScalarVariable(var)) {
+            scalarTypes[var] = getLocalType(var, inductionType);
+        }
+        Type* varType = scalarTypes[var];
+
+        // Range of `var` in the body, for bounds-check elision
+        IndexRange first = {0, 0}, limit;
+        IndexRange inductionRange;
+        bool rangeKnown = (!beginNode || indexRangeOf(beginNode, first)) && indexRangeOf(endNode, limit) &&
+                          !writesVariable(body, var);
+        if (rangeKnown) {
+            inductionRange = step > 0 ? IndexRange{first.lo, limit.hi - 1} : IndexRange{limit.lo + 1, first.hi};
+        }
+
+        if (step == 1 && parallelLoopsEnabled() && !inParallelBody) {
+            vector<string> captures;
+            string reason;
+            if (rangeKnown && limit.hi - first.lo < PARALLEL_MIN_TRIP_COUNT) {
+                reason = "too few iterations";
+            } else {
+                reason = findLoopDependence(body, var, nullptr, captures);
+            }
+            if (reason.empty()) {
+                Type* i64 = getInt64Type();
+                Value* begin64 = builder->CreateSExt(begin, i64, "begin");
+                Value* end64 = builder->CreateSExt(end, i64, "end");
+                emitParallelFor(node, body, var, inductionType, begin64, end64, captures,
+                                rangeKnown ? &inductionRange : nullptr);
+
+                // `var` keeps the last value it took, as after the serial loop
+                Value* ran = builder->CreateICmpSLT(begin, end, "ran");
+                Value* last = convertValue(builder->CreateSub(end, ConstantInt::get(inductionType, 1)), varType);
+                Value* previous = readVariable(var);
+                writeVariable(var, builder->CreateSelect(ran, last, previous, "last"));
+                return;
+            }
+            CAX_DEBUG(diag::CAT_IRGEN, "Loop on line " << node->line << " stays serial: " << reason);
+        }
+
+        BasicBlock* preheaderBB = builder->GetInsertBlock();
+        BasicBlock* condBB = BasicBlock::Create(*context, "rangecond", currentFunction);
+        BasicBlock* bodyBB = BasicBlock::Create(*context, "rangebody");
+        BasicBlock* incBB = BasicBlock::Create(*context, "rangeinc");
+        BasicBlock* afterBB = BasicBlock::Create(*context, "afterrange");
+
+        LoopTrips trips = beginLoopTrips(node);
         builder->CreateBr(condBB);
+        beginLoopHeader(condBB);
+        builder->SetInsertPoint(condBB);
+        PHINode* iv = builder->CreatePHI(inductionType, 2, var + ".iv");
+        iv->addIncoming(begin, preheaderBB);
+        Value* cond = step > 0 ? builder->CreateICmpSLT(iv, end, "rangecond")
+                               : builder->CreateICmpSGT(iv, end, "rangecond");
+        createProfiledCondBr(node, "range", cond, bodyBB, afterBB);
+
+        currentFunction->insert(currentFunction->end(), bodyBB);
+        builder->SetInsertPoint(bodyBB);
+        writeVariable(var, iv);
+        countLoopTrip(trips);
+
+        loopStack.push({incBB, afterBB});
+        if (rangeKnown) {
+            inductionRanges.push_back({var, inductionRange});
+        }
+
+        generateBlock(body);
+
+        if (rangeKnown) {
+            inductionRanges.pop_back();
+        }
+        loopStack.pop();
+
+        if (!builder->GetInsertBlock()->getTerminator()) {
+            builder->CreateBr(incBB);
+        }
+
+        currentFunction->insert(currentFunction->end(), incBB);
+        builder->SetInsertPoint(incBB);
+        Value* next = builder->CreateAdd(iv, ConstantInt::get(inductionType, step, true), var + ".next",
+                                         false, true);
+        iv->addIncoming(next, incBB);
+        attachLoopMetadata(builder->CreateBr(condBB), node, true);
+        sealBlock(condBB);
 
         currentFunction->insert(currentFunction->end(), afterBB);
         builder->SetInsertPoint(afterBB);
+        endLoopTrips(trips);
+    }
+
+    // !llvm.loop on a loop's latch branch: mustprogress for loops known to
+    // terminate, and the header's unroll=N / vectorize=N annotations
+    // (N = 1 turns unrolling / vectorization off)
+    void attachLoopMetadata(BranchInst* latch, shared_ptr<ASTNode> node, bool finite) {
+        vector<Metadata*> properties;
+        auto property = [&](const string& name, Metadata* value) {
+            vector<Metadata*> operands = {MDString::get(*context, name)};
+            if (value) operands.push_back(value);
+            properties.push_back(MDNode::get(*context, operands));
+        };
+        auto count = [&](int value) {
+            return ConstantAsMetadata::get(builder->getInt32(value));
+        };
+
+        if (finite) {
+            property("llvm.loop.mustprogress", nullptr);
+        }
+
+        auto unrollIt = node->attributes.find("unroll");
+        if (unrollIt != node->attributes.end()) {
+            int factor = atoi(unrollIt->second.c_str());
+            if (factor <= 1) {
+                property("llvm.loop.unroll.disable", nullptr);
+            } else {
+                property("llvm.loop.unroll.count", count(factor));
+            }
+        }
+
+        auto vectorizeIt = node->attributes.find("vectorize");
+        if (vectorizeIt != node->attributes.end()) {
+            int width = atoi(vectorizeIt->second.c_str());
+            if (width <= 1) {
+                property("llvm.loop.vectorize.width", count(1));
+            } else {
+                property("llvm.loop.vectorize.enable", ConstantAsMetadata::get(builder->getTrue()));
+                property("llvm.loop.vectorize.width", count(width));
+            }
+        }
+
+        if (properties.empty()) return;
+
+        // Loop IDs are distinct and refer to themselves
+        properties.insert(properties.begin(), nullptr);
+        MDNode* loopID = MDNode::getDistinct(*context, properties);
+        loopID->replaceOperandWith(0, loopID);
+        latch->setMetadata(LLVMContext::MD_loop, loopID);
     }
 
     void generateReturn(shared_ptr<ASTNode> node) {
+        emitVectorCleanup();
+
         if (node->children.empty()) {
+            emitFunctionExit();
             builder->CreateRetVoid();
         } else {
             Value* retVal = generateExpression(node->children[0]);
-            if (retVal) {
-                builder->CreateRet(retVal);
+            emitFunctionExit();
+            Type* returnType = currentFunction->getReturnType();
+            if (returnType->isVoidTy()) {
+                // Value of a function whose result type is unknown: dropped
+                builder->CreateRetVoid();
+            } else if (retVal) {
+                builder->CreateRet(convertValue(retVal, returnType));
             }
         }
     }
@@ -583,41 +1865,68 @@ public:
 
         Type* valType = val->getType();
 
-        // Create format string based on type
-        string formatStr;
-        if (valType->isIntegerTy(32)) {
-            formatStr = "%d\n";
+        // Each printable type lowers to one direct call into the buffered
+        // output runtime (runtime/cax_print.c) instead of varargs printf
+        Function* printFunc = nullptr;
+        if (valType->isIntegerTy(64)) {
+            printFunc = getRuntimeFunction("cax_print_i64", getVoidType(), {getInt64Type()});
         } else if (valType->isIntegerTy(8)) {
-            formatStr = "%c\n";
+            printFunc = getRuntimeFunction("cax_print_char", getVoidType(), {getInt32Type()});
+            val = builder->CreateZExt(val, getInt32Type(), "charval");
         } else if (valType->isIntegerTy(1)) {
-            formatStr = "%d\n";  // Print bool as 0/1
+            // Print bool as 0/1
+            printFunc = getRuntimeFunction("cax_print_bool", getVoidType(), {getInt32Type()});
+            val = builder->CreateZExt(val, getInt32Type(), "boolval");
         } else if (valType->isDoubleTy() || valType->isFloatTy()) {
-            formatStr = "%f\n";
+            printFunc = getRuntimeFunction("cax_print_f64", getVoidType(), {getDoubleType()});
+            if (valType->isFloatTy()) {
+                val = builder->CreateFPExt(val, getDoubleType(), "fpext");
+            }
         } else if (valType->isPointerTy()) {
             // Assume it's a string pointer
-            formatStr = "%s\n";
+            printFunc = getRuntimeFunction("cax_print_str", getVoidType(), {getPtrType()});
+        } else if (valType->isIntegerTy()) {
+            printFunc = getRuntimeFunction("cax_print_i32", getVoidType(), {getInt32Type()});
+            val = builder->CreateSExtOrTrunc(val, getInt32Type(), "intval");
         } else {
-            // Unknown type, print as integer
-            formatStr = "%d\n";
+            CAX_WARN(diag::CAT_IRGEN, "print() of unsupported value type ignored");
+            return;
         }
 
-        // Get format string pointer
-        Value* formatStrPtr = getStringPtr(formatStr);
-
-        // Call printf
-        vector<Value*> printfArgs;
-        printfArgs.push_back(formatStrPtr);
-        printfArgs.push_back(val);
-
-        builder->CreateCall(printfFunc, printfArgs);
+        builder->CreateCall(printFunc, {val});
     }
 
     void generateVectorDecl(shared_ptr<ASTNode> node) {
         string varName = node->value;
-        // Allocate space for vector pointer
-        // For simplicity, we'll treat vectors as pointers
-        AllocaInst* var = createEntryBlockAlloca(currentFunction, varName, getPtrType());
-        namedValues[varName] = var;
+        if (const ClassInfo* cls = findClass(node->attributes["elementType"])) {
+            generateObjectVectorDecl(node, *cls);
+            return;
+        }
+        Type* elemType = getVectorElementType(node->attributes["elementType"]);
+        StructType* vecType = getVectorType(elemType);
+
+        // Declaring a vector field inside a method empties it
+        if (isField(varName)) {
+            if (fieldType(varName) != vecType) {
+                CAX_ERROR(diag::CAT_IRGEN, "Field '" << varName << "' is not a vector of "
+                          << node->attributes["elementType"] << " (line " << node->line << ")");
+                return;
+            }
+            builder->CreateStore(ConstantInt::get(getInt64Type(), 0),
+                                 builder->CreateStructGEP(vecType, fieldAddress(varName), 1, "sizeptr"));
+            return;
+        }
+
+        AllocaInst* var = namedValues[varName];
+        if (!var || var->getAllocatedType() != vecType) {
+            var = createVectorSlot(varName, vecType);
+            namedValues[varName] = var;
+            functionVectors.push_back(var);
+        }
+
+        // (Re)declaring empties the vector but keeps any heap capacity
+        builder->CreateStore(ConstantInt::get(getInt64Type(), 0),
+                             builder->CreateStructGEP(vecType, var, 1, "sizeptr"));
     }
 
     Value* generateExpression(shared_ptr<ASTNode> node) {
@@ -636,14 +1945,24 @@ public:
                 return generateArrayAccess(node);
             case NodeType::ARRAY_LITERAL:
                 return generateArrayLiteral(node);
+            case NodeType::MEMBER_ACCESS:
+                return generateMemberAccess(node);
             default:
                 return nullptr;
         }
     }
 
     Value* generateLiteral(shared_ptr<ASTNode> node) {
-        string val = node->value;
+        if (Constant* constant = generateLiteralConstant(node->value)) {
+            return constant;
+        }
+        // String literal - pooled global string constant
+        return getStringPtr(node->value);
+    }
 
+    // Scalar literals; nullptr for a string literal. Integers are i32, or
+    // i64 when they do not fit.
+    Constant* generateLiteralConstant(const string& val) {
         // Check for boolean first
         if (val == "true") {
             return ConstantInt::get(*context, APInt(1, 1));
@@ -675,15 +1994,17 @@ public:
         try {
             // Handle negative numbers
             if (val[0] == '-' || isdigit(val[0])) {
-                int intVal = stoi(val);
-                return ConstantInt::get(*context, APInt(32, intVal, true));
+                long long intVal = stoll(val);
+                if (intVal >= INT32_MIN && intVal <= INT32_MAX) {
+                    return ConstantInt::get(*context, APInt(32, intVal, true));
+                }
+                return ConstantInt::get(*context, APInt(64, intVal, true));
             }
         } catch (...) {}
 
-        // String literals - create global string constant
-        if (!val.empty() && !isdigit(val[0]) && val != "true" && val != "false") {
-            // This is a string literal
-            return getStringPtr(val);
+        // String literals
+        if (!val.empty() && !isdigit(val[0])) {
+            return nullptr;
         }
 
         // Default to 0
@@ -693,12 +2014,34 @@ public:
     Value* generateIdentifier(shared_ptr<ASTNode> node) {
         string name = node->value;
 
+        // Fields of `this`: arrays and vectors are used in place
+        if (isField(name)) {
+            Type* type = fieldType(name);
+            Value* addr = fieldAddress(name);
+            return type->isAggregateType() ? addr : builder->CreateLoad(type, addr, name);
+        }
+
+        // Read-only arrays are their constant global
+        auto boundIt = boundArrays.find(name);
+        if (boundIt != boundArrays.end()) {
+            return boundIt->second.storage;
+        }
+
+        if (isScalarVariable(name)) {
+            return readVariable(name);
+        }
+
         AllocaInst* var = namedValues[name];
         if (!var) {
-            cerr << "Error: Unknown variable: " << name << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Unknown variable: " << name);
             return nullptr;
         }
 
+        // Arrays are used through their storage, never loaded whole
+        if (var->getAllocatedType()->isArrayTy()) {
+            return var;
+        }
+
         return builder->CreateLoad(var->getAllocatedType(), var, name.c_str());
     }
 
@@ -712,36 +2055,43 @@ public:
 
         string op = node->value;
 
-        // Arithmetic operations
-        if (op == "+") {
-            if (lhs->getType()->isFloatingPointTy()) {
-                return builder->CreateFAdd(lhs, rhs, "addtmp");
-            }
-            return builder->CreateAdd(lhs, rhs, "addtmp");
-        }
-        if (op == "-") {
-            if (lhs->getType()->isFloatingPointTy()) {
-                return builder->CreateFSub(lhs, rhs, "subtmp");
-            }
-            return builder->CreateSub(lhs, rhs, "subtmp");
+        // Logical operations
+        if (op == "&&") {
+            return builder->CreateAnd(toBool(lhs, "lhsbool"), toBool(rhs, "rhsbool"), "andtmp");
         }
-        if (op == "*") {
-            if (lhs->getType()->isFloatingPointTy()) {
-                return builder->CreateFMul(lhs, rhs, "multmp");
-            }
-            return builder->CreateMul(lhs, rhs, "multmp");
+        if (op == "||") {
+            return builder->CreateOr(toBool(lhs, "lhsbool"), toBool(rhs, "rhsbool"), "ortmp");
         }
-        if (op == "/") {
-            if (lhs->getType()->isFloatingPointTy()) {
-                return builder->CreateFDiv(lhs, rhs, "divtmp");
+
+        // Both operands are cast to their common type first
+        if (lhs->getType() != rhs->getType()) {
+            StaticType common = joinStatic({lhs->getType(), isNumericLiteral(node->children[0])},
+                                           {rhs->getType(), isNumericLiteral(node->children[1])});
+            if (!common.type) {
+                CAX_ERROR(diag::CAT_IRGEN, "Operands of '" << op << "' on line " << node->line
+                          << " have incompatible types " << getTypeSuffix(lhs->getType())
+                          << " and " << getTypeSuffix(rhs->getType()));
+                return nullptr;
             }
-            return builder->CreateSDiv(lhs, rhs, "divtmp");
+            lhs = convertValue(lhs, common.type);
+            rhs = convertValue(rhs, common.type);
         }
-        if (op == "%") {
-            return builder->CreateSRem(lhs, rhs, "modtmp");
+
+        // Arithmetic operations
+        if (Value* arith = createArithmetic(op, lhs, rhs)) {
+            return arith;
         }
 
         // Comparison operations
+        if (lhs->getType()->isFloatingPointTy()) {
+            if (op == "<") return builder->CreateFCmpOLT(lhs, rhs, "cmptmp");
+            if (op == ">") return builder->CreateFCmpOGT(lhs, rhs, "cmptmp");
+            if (op == "<=") return builder->CreateFCmpOLE(lhs, rhs, "cmptmp");
+            if (op == ">=") return builder->CreateFCmpOGE(lhs, rhs, "cmptmp");
+            if (op == "==") return builder->CreateFCmpOEQ(lhs, rhs, "cmptmp");
+            if (op == "!=") return builder->CreateFCmpUNE(lhs, rhs, "cmptmp");
+            return nullptr;
+        }
         if (op == "<") {
             return builder->CreateICmpSLT(lhs, rhs, "cmptmp");
         }
@@ -761,12 +2111,40 @@ public:
             return builder->CreateICmpNE(lhs, rhs, "cmptmp");
         }
 
-        // Logical operations
-        if (op == "&&") {
-            return builder->CreateAnd(lhs, rhs, "andtmp");
+        return nullptr;
+    }
+
+    // +, -, *, /, % on two scalars; nullptr for any other operator
+    Value* createArithmetic(const string& op, Value* lhs, Value* rhs) {
+        if (op == "+") {
+            if (lhs->getType()->isFloatingPointTy()) {
+                return builder->CreateFAdd(lhs, rhs, "addtmp");
+            }
+            return builder->CreateAdd(lhs, rhs, "addtmp");
         }
-        if (op == "||") {
-            return builder->CreateOr(lhs, rhs, "ortmp");
+        if (op == "-") {
+            if (lhs->getType()->isFloatingPointTy()) {
+                return builder->CreateFSub(lhs, rhs, "subtmp");
+            }
+            return builder->CreateSub(lhs, rhs, "subtmp");
+        }
+        if (op == "*") {
+            if (lhs->getType()->isFloatingPointTy()) {
+                return builder->CreateFMul(lhs, rhs, "multmp");
+            }
+            return builder->CreateMul(lhs, rhs, "multmp");
+        }
+        if (op == "/") {
+            if (lhs->getType()->isFloatingPointTy()) {
+                return builder->CreateFDiv(lhs, rhs, "divtmp");
+            }
+            return builder->CreateSDiv(lhs, rhs, "divtmp");
+        }
+        if (op == "%") {
+            if (lhs->getType()->isFloatingPointTy()) {
+                return builder->CreateFRem(lhs, rhs, "modtmp");
+            }
+            return builder->CreateSRem(lhs, rhs, "modtmp");
         }
 
         return nullptr;
@@ -782,20 +2160,27 @@ public:
             if (node->children[0]->type != NodeType::IDENTIFIER) return nullptr;
 
             string varName = node->children[0]->value;
-            AllocaInst* var = namedValues[varName];
-            if (!var) return nullptr;
+            bool field = isField(varName) && !fieldType(varName)->isAggregateType();
+            if (!field && !isScalarVariable(varName)) return nullptr;
 
-            Value* val = builder->CreateLoad(var->getAllocatedType(), var, varName.c_str());
-            Value* one = ConstantInt::get(val->getType(), 1);
+            Value* addr = field ? fieldAddress(varName) : nullptr;
+            Value* val = field ? builder->CreateLoad(fieldType(varName), addr, varName) : readVariable(varName);
+            bool increment = op == "++post" || op == "++";
 
             Value* newVal;
-            if (op == "++post" || op == "++") {
-                newVal = builder->CreateAdd(val, one, "inc");
+            if (val->getType()->isFloatingPointTy()) {
+                Value* one = ConstantFP::get(val->getType(), 1.0);
+                newVal = increment ? builder->CreateFAdd(val, one, "inc") : builder->CreateFSub(val, one, "dec");
             } else {
-                newVal = builder->CreateSub(val, one, "dec");
+                Value* one = ConstantInt::get(val->getType(), 1);
+                newVal = increment ? builder->CreateAdd(val, one, "inc") : builder->CreateSub(val, one, "dec");
             }
 
-            builder->CreateStore(newVal, var);
+            if (field) {
+                builder->CreateStore(newVal, addr);
+            } else {
+                writeVariable(varName, newVal);
+            }
             return val; // Return old value for post-increment
         }
 
@@ -809,7 +2194,7 @@ public:
             return builder->CreateNeg(operand, "negtmp");
         }
         if (op == "!") {
-            return builder->CreateNot(operand, "nottmp");
+            return builder->CreateNot(toBool(operand, "notcond"), "nottmp");
         }
 
         return nullptr;
@@ -820,41 +2205,90 @@ public:
 
         // Handle special built-in functions
         if (funcName == "len") {
-            // For arrays, return their length
+            // For vectors, len(v) is v.size()
             if (!node->children.empty()) {
-                // Check if the argument is an identifier that refers to an array
-                if (node->children[0]->type == NodeType::IDENTIFIER) {
-                    string arrayName = node->children[0]->value;
-                    AllocaInst* arrayVar = namedValues[arrayName];
-
-                    if (arrayVar) {
-                        Type* allocatedType = arrayVar->getAllocatedType();
-                        if (ArrayType* arrayType = dyn_cast<ArrayType>(allocatedType)) {
-                            uint64_t arraySize = arrayType->getNumElements();
-                            return ConstantInt::get(*context, APInt(32, arraySize, true));
-                        }
-                    }
+                if (VectorRef vec = lookupVector(node->children[0])) {
+                    return generateVectorCall(vec, "size", node);
+                }
+                if (ObjectVector* vec = lookupObjectVector(node->children[0])) {
+                    return generateObjectVectorCall(*vec, "size", node);
+                }
+            }
+
+            // For arrays, return their length (len(m[i]) is a row length)
+            if (!node->children.empty()) {
+                if (ArrayType* arrayType = staticArrayTypeOf(node->children[0])) {
+                    uint64_t arraySize = arrayType->getNumElements();
+                    return ConstantInt::get(*context, APInt(32, arraySize, true));
                 }
             }
             // Fallback: return 0
             return ConstantInt::get(*context, APInt(32, 0, true));
         }
 
-        if (funcName == "size") {
-            // Similar to len, but for vectors
-            // For now, return 0
-            return ConstantInt::get(*context, APInt(32, 0, true));
+        // Tensor kernels, unless the program defines a function of that name
+        if (isTensorBuiltin(funcName)) {
+            auto userFunc = functions.find(funcName);
+            if (userFunc == functions.end() || !userFunc->second) {
+                return generateTensorCall(funcName, node);
+            }
         }
 
-        if (funcName == "push" || funcName == "pop") {
-            // Vector operations - skip for now
-            return nullptr;
+        if (funcName == "size" || funcName == "push" || funcName == "pop") {
+            // Vector methods: the object is the first child
+            if (ObjectVector* vec = node->children.empty() ? nullptr : lookupObjectVector(node->children[0])) {
+                return generateObjectVectorCall(*vec, funcName, node);
+            }
+            VectorRef vec = node->children.empty() ? VectorRef() : lookupVector(node->children[0]);
+            if (!vec) {
+                CAX_ERROR(diag::CAT_IRGEN, "'" << funcName << "' called on a value that is not a vector");
+                return funcName == "size" ? ConstantInt::get(*context, APInt(32, 0, true)) : nullptr;
+            }
+            return generateVectorCall(vec, funcName, node);
+        }
+
+        // i8(x) ... f64(x), unless the program defines a function of that name
+        if (Type* castType = getCastBuiltinType(funcName)) {
+            auto userFunc = functions.find(funcName);
+            if (userFunc == functions.end() || !userFunc->second) {
+                if (node->children.size() != 1) {
+                    CAX_ERROR(diag::CAT_IRGEN, funcName << "() takes one argument (line " << node->line << ")");
+                    return nullptr;
+                }
+                Value* value = generateExpression(node->children[0]);
+                if (!value) return nullptr;
+                if (!isNumericType(value->getType())) {
+                    CAX_ERROR(diag::CAT_IRGEN, funcName << "() needs a number (line " << node->line << ")");
+                    return nullptr;
+                }
+                return convertValue(value, castType);
+            }
+        }
+
+        // delete(obj), unless the program defines a function of that name
+        if (funcName == "delete") {
+            auto userFunc = functions.find(funcName);
+            if (userFunc == functions.end() || !userFunc->second) return generateDelete(node);
+        }
+
+        // obj.method() / method() inside a method: direct call
+        shared_ptr<ASTNode> object;
+        if (Function* method = resolveMethod(node, object)) {
+            return generateMethodCall(node, method, object);
+        }
+
+        // Name() of a class: allocate an instance
+        if (const ClassInfo* info = findClass(funcName)) {
+            auto userFunc = functions.find(funcName);
+            if ((userFunc == functions.end() || !userFunc->second) && node->children.empty()) {
+                return generateConstructor(*info, node);
+            }
         }
 
         // Regular function call
         Function* func = functions[funcName];
         if (!func) {
-            cerr << "Error: Unknown function: " << funcName << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Unknown function: " << funcName);
             return nullptr;
         }
 
@@ -869,6 +2303,7 @@ public:
 
         // Do NOT give calls to void-valued functions a name
         CallInst* call = builder->CreateCall(func, args);
+        call->setCallingConv(func->getCallingConv());
 
         if (func->getReturnType()->isVoidTy()) {
             // Statement-only call, nothing to return as a value
@@ -879,130 +2314,2727 @@ public:
         }
     }
 
+    // Returns a pointer to the literal's storage. Nested literals become
+    // one contiguous row-major array ([R x [C x T]]), so m[i][j] is a
+    // single GEP. All-constant literals become one pooled read-only global;
+    // anything else is built in a stack temporary with one store per element.
     Value* generateArrayLiteral(shared_ptr<ASTNode> node) {
         if (node->children.empty()) {
             // Empty array - return null pointer
             return ConstantInt::get(*context, APInt(32, 0, true));
         }
 
+        // Shape (one extent per dimension) and elements in row-major order
+        vector<uint64_t> shape;
+        vector<shared_ptr<ASTNode>> leaves;
+        size_t leafDepth = SIZE_MAX;
+        if (!collectArrayShape(node, 0, shape, leaves, leafDepth)) {
+            CAX_WARN(diag::CAT_IRGEN, "Array literal on line " << node->line
+                     << " is not rectangular; every row must have the same length");
+            return ConstantInt::get(*context, APInt(32, 0, true));
+        }
+        if (leaves.empty()) {
+            return ConstantInt::get(*context, APInt(32, 0, true));
+        }
+
         // Get all element values
-        vector<Constant*> elements;
-        Type* elemType = nullptr;
-        bool hasMixedTypes = false;
+        vector<Value*> elements;
+        StaticType elemStatic;
 
-        for (auto& child : node->children) {
-            Value* elemVal = generateExpression(child);
-            if (!elemVal) continue;
+        for (auto& leaf : leaves) {
+            Value* elemVal = generateExpression(leaf);
+            if (!elemVal) return ConstantInt::get(*context, APInt(32, 0, true));
 
-            if (!elemType) {
-                elemType = elemVal->getType();
-            } else if (elemType != elemVal->getType()) {
-                // Mixed types detected
-                hasMixedTypes = true;
+            // Elements share their common type (see TYPE INFERENCE)
+            StaticType joined = joinStatic(elemStatic, {elemVal->getType(), isNumericLiteral(leaf)});
+            if (joined.type) elemStatic = joined;
+            elements.push_back(elemVal);
+        }
+        Type* elemType = elemStatic.type;
+
+        bool allConstant = true;
+        for (auto*& elem : elements) {
+            if (elem->getType() != elemType) {
+                Value* converted = convertValue(elem, elemType);
+                if (!converted || converted->getType() != elemType) {
+                    CAX_WARN(diag::CAT_IRGEN, "Array element type mismatch (line " << node->line << ")");
+                    converted = Constant::getNullValue(elemType);
+                }
+                elem = converted;
             }
+            if (!isa<Constant>(elem)) allConstant = false;
+        }
 
-            if (Constant* constVal = dyn_cast<Constant>(elemVal)) {
-                elements.push_back(constVal);
-            } else {
-                // Non-constant element - can't create constant array
-                return ConstantInt::get(*context, APInt(32, 0, true));
+        Type* arrayType = elemType;
+        for (auto extent = shape.rbegin(); extent != shape.rend(); ++extent) {
+            arrayType = ArrayType::get(arrayType, *extent);
+        }
+
+        if (allConstant) {
+            size_t next = 0;
+            return getConstantArray(buildConstantArray(cast<ArrayType>(arrayType), elements, next));
+        }
+
+        AllocaInst* temp = createEntryBlockAlloca(currentFunction, "array", arrayType);
+        if (MDNode* shapeInfo = getShapeMetadata(cast<ArrayType>(arrayType))) {
+            temp->setMetadata("cax.shape", shapeInfo);
+        }
+        emitLifetime(true, temp);
+        statementTemporaries.push_back(temp);
+
+        vector<Value*> indices(shape.size() + 1, builder->getInt64(0));
+        for (size_t flat = 0; flat < elements.size(); flat++) {
+            size_t rest = flat;
+            for (size_t dim = shape.size(); dim-- > 0;) {
+                indices[dim + 1] = builder->getInt64(rest % shape[dim]);
+                rest /= shape[dim];
+            }
+            Value* elemPtr = builder->CreateInBoundsGEP(arrayType, temp, indices, "arrayinit");
+            builder->CreateStore(elements[flat], elemPtr);
+        }
+        return temp;
+    }
+
+    // Walk a (possibly nested) array literal. Every literal at the same depth
+    // must have the same length and all scalars must sit at the same depth.
+    bool collectArrayShape(shared_ptr<ASTNode> node, size_t depth, vector<uint64_t>& shape,
+                           vector<shared_ptr<ASTNode>>& leaves, size_t& leafDepth) {
+        if (depth == shape.size()) {
+            shape.push_back(node->children.size());
+        } else if (shape[depth] != node->children.size()) {
+            return false;
+        }
+
+        for (auto& child : node->children) {
+            if (child->type == NodeType::ARRAY_LITERAL) {
+                if (depth + 1 > leafDepth) return false;
+                if (!collectArrayShape(child, depth + 1, shape, leaves, leafDepth)) return false;
+            } else {
+                if (leafDepth == SIZE_MAX) leafDepth = depth;
+                if (leafDepth != depth || shape.size() != depth + 1) return false;
+                leaves.push_back(child);
+            }
+        }
+        return true;
+    }
+
+    // Nested ConstantArray for `type` from row-major `elements`
+    Constant* buildConstantArray(ArrayType* type, const vector<Value*>& elements, size_t& next) {
+        vector<Constant*> items;
+        for (uint64_t i = 0; i < type->getNumElements(); i++) {
+            if (auto* inner = dyn_cast<ArrayType>(type->getElementType())) {
+                items.push_back(buildConstantArray(inner, elements, next));
+            } else {
+                items.push_back(cast<Constant>(elements[next++]));
             }
         }
+        return ConstantArray::get(type, items);
+    }
+
+    // !cax.shape !{i64 R, i64 C, ...} on multi-dimensional array storage
+    MDNode* getShapeMetadata(ArrayType* type) {
+        vector<Metadata*> extents;
+        Type* level = type;
+        while (auto* array = dyn_cast<ArrayType>(level)) {
+            extents.push_back(ConstantAsMetadata::get(builder->getInt64(array->getNumElements())));
+            level = array->getElementType();
+        }
+        if (extents.size() < 2) return nullptr;
+        return MDNode::get(*context, extents);
+    }
+
+    // Private unnamed_addr constant holding `init`, shared by identical literals
+    GlobalVariable* getConstantArray(Constant* init) {
+        auto it = constantArrayPool.find(init);
+        if (it != constantArrayPool.end()) {
+            return it->second;
+        }
+
+        auto* global = new GlobalVariable(*module, init->getType(), true,
+                                          GlobalValue::PrivateLinkage, init, ".arr");
+        global->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        Type* elemType = getArrayLeafType(cast<ArrayType>(init->getType()));
+        global->setAlignment(module->getDataLayout().getABITypeAlign(elemType));
+        if (MDNode* shapeInfo = getShapeMetadata(cast<ArrayType>(init->getType()))) {
+            global->setMetadata("cax.shape", shapeInfo);
+        }
+
+        constantArrayPool[init] = global;
+        return global;
+    }
+
+    Value* generateArrayAccess(shared_ptr<ASTNode> node) {
+        if (node->children.size() < 2) {
+            return ConstantInt::get(*context, APInt(32, 0, true));
+        }
+
+        if (ObjectVector* vec = lookupObjectVector(node->children[0])) {
+            CAX_ERROR(diag::CAT_IRGEN, "Elements of vector<" << vec->cls->node->value << "> are used through "
+                      << node->children[0]->value << "[i].field or " << node->children[0]->value
+                      << "[i].method() (line " << node->line << ")");
+            return nullptr;
+        }
+
+        // Vector element: v[i]
+        if (VectorRef vec = lookupVector(node->children[0])) {
+            Value* index = generateExpression(node->children[1]);
+            if (!index) return ConstantInt::get(*context, APInt(32, 0, true));
+            index = convertValue(index, getInt64Type());
+            return builder->CreateCall(getVectorHelper(vec.type, "get"), {vec.storage, index}, "vecval");
+        }
+
+        // m[i][j] parses as (m[i])[j]; collect the indices, outermost first
+        vector<shared_ptr<ASTNode>> indexNodes;
+        shared_ptr<ASTNode> base = node;
+        while (base->type == NodeType::ARRAY_ACCESS && base->children.size() >= 2) {
+            indexNodes.insert(indexNodes.begin(), base->children[1]);
+            base = base->children[0];
+        }
 
-        if (elements.empty() || !elemType) {
+        Value* array = generateExpression(base);
+        if (!array) {
             return ConstantInt::get(*context, APInt(32, 0, true));
         }
 
-        // If mixed types, just use the first element's type and ignore incompatible elements
-        // This is a simplified approach - in production you'd want proper type coercion
-        if (hasMixedTypes) {
-            // Create array with only compatible elements
-            vector<Constant*> compatibleElements;
+        // Array storage (stack slot or read-only global): one GEP, then load
+        ArrayType* arrayType = base->type == NodeType::IDENTIFIER ? staticArrayTypeOf(base)
+                                                                  : getArrayStorageType(array);
+        if (arrayType) {
+            Value* elemPtr = generateArrayElementPtr(array, arrayType, indexNodes, base->value);
+            if (!elemPtr) {
+                return ConstantInt::get(*context, APInt(32, 0, true));
+            }
+            return builder->CreateLoad(getArrayLeafType(arrayType), elemPtr, "arrayval");
+        }
 
-            for (auto* elem : elements) {
-                if (elem->getType() == elemType) {
-                    compatibleElements.push_back(elem);
-                } else {
-                    // Skip incompatible types or add a zero/default value
-                    if (elemType->isIntegerTy()) {
-                        compatibleElements.push_back(
-                            ConstantInt::get(elemType, 0)
-                        );
-                    } else if (elemType->isFloatingPointTy()) {
-                        compatibleElements.push_back(
-                            ConstantFP::get(elemType, 0.0)
-                        );
-                    } else if (elemType->isPointerTy()) {
-                        compatibleElements.push_back(
-                            ConstantPointerNull::get(cast<PointerType>(elemType))
-                        );
+        // Fallback: return 0
+        return ConstantInt::get(*context, APInt(32, 0, true));
+    }
+
+    // Address of array[i0][i1]... with one index per dimension. Each index
+    // is checked against its own extent (see generateArrayIndex).
+    Value* generateArrayElementPtr(Value* array, ArrayType* arrayType,
+                                   const vector<shared_ptr<ASTNode>>& indexNodes, const string& arrayName) {
+        vector<Value*> indices;
+        indices.push_back(ConstantInt::get(*context, APInt(32, 0)));
+
+        Type* level = arrayType;
+        for (auto& indexNode : indexNodes) {
+            auto* dimension = dyn_cast<ArrayType>(level);
+            if (!dimension) {
+                CAX_ERROR(diag::CAT_IRGEN, "Too many indices for '" << arrayName << "' on line " << indexNode->line);
+                return nullptr;
+            }
+            Value* index = generateExpression(indexNode);
+            if (!index) return nullptr;
+            indices.push_back(generateArrayIndex(indexNode, index, dimension, arrayName));
+            level = dimension->getElementType();
+        }
+
+        if (level->isArrayTy()) {
+            CAX_WARN(diag::CAT_IRGEN, "'" << arrayName << "' needs one index per dimension; "
+                     << "row values are not supported yet");
+            return nullptr;
+        }
+
+        return builder->CreateInBoundsGEP(arrayType, array, indices, "arrayelem");
+    }
+
+    void generateIndexedAssignment(shared_ptr<ASTNode> node) {
+        string varName = node->value;
+
+        if (isField(varName)) {
+            Type* type = fieldType(varName);
+            if (auto* arrayType = dyn_cast<ArrayType>(type)) {
+                generateArrayElementAssignment(node, fieldAddress(varName), arrayType);
+            } else if (isVectorType(type) && node->children.size() == 2) {
+                generateVectorElementAssignment(node, {fieldAddress(varName), cast<StructType>(type)});
+            } else {
+                CAX_WARN(diag::CAT_IRGEN, "Indexed assignment to field '" << varName << "' is not supported");
+            }
+            return;
+        }
+
+        auto boundIt = boundArrays.find(varName);
+        if (boundIt != boundArrays.end()) {
+            generateArrayElementAssignment(node, boundIt->second.storage, boundIt->second.type);
+            return;
+        }
+
+        auto it = namedValues.find(varName);
+        AllocaInst* var = it != namedValues.end() ? it->second : nullptr;
+        if (!var) {
+            CAX_ERROR(diag::CAT_IRGEN, "Unknown variable: " << varName);
+            return;
+        }
+
+        if (ArrayType* arrayType = dyn_cast<ArrayType>(var->getAllocatedType())) {
+            generateArrayElementAssignment(node, var, arrayType);
+            return;
+        }
+
+        if (!isVectorSlot(var) || node->children.size() > 2) {
+            CAX_WARN(diag::CAT_IRGEN, "Indexed assignment to '" << varName << "' is not supported yet");
+            return;
+        }
+        generateVectorElementAssignment(node, {var, cast<StructType>(var->getAllocatedType())});
+    }
+
+    // v[i] = value / v[i] op= value
+    void generateVectorElementAssignment(shared_ptr<ASTNode> node, VectorRef vec) {
+        StructType* vecType = vec.type;
+        Type* elemType = getVectorElementOf(vecType);
+
+        Value* index = generateExpression(node->children[0]);
+        Value* value = generateExpression(node->children[1]);
+        if (!index || !value) return;
+
+        index = convertValue(index, getInt64Type());
+        value = convertValue(value, elemType);
+
+        auto opIt = node->attributes.find("operator");
+        if (opIt != node->attributes.end()) {
+            Value* current = builder->CreateCall(getVectorHelper(vecType, "get"), {vec.storage, index}, "vecval");
+            value = createArithmetic(opIt->second.substr(0, 1), current, value);
+            if (!value) return;
+        }
+
+        builder->CreateCall(getVectorHelper(vecType, "set"), {vec.storage, index, value});
+    }
+
+    // name[i]... = value / name[i]... op= value on a local array copy
+    void generateArrayElementAssignment(shared_ptr<ASTNode> node, Value* var, ArrayType* arrayType) {
+        Type* elemType = getArrayLeafType(arrayType);
+
+        vector<shared_ptr<ASTNode>> indexNodes(node->children.begin(), node->children.end() - 1);
+        Value* elemPtr = generateArrayElementPtr(var, arrayType, indexNodes, node->value);
+        if (!elemPtr) return;
+
+        Value* value = generateExpression(node->children.back());
+        if (!value) return;
+        value = convertValue(value, elemType);
+
+        auto opIt = node->attributes.find("operator");
+        if (opIt != node->attributes.end()) {
+            Value* current = builder->CreateLoad(elemType, elemPtr, "arrayval");
+            value = createArithmetic(opIt->second.substr(0, 1), current, value);
+            if (!value) return;
+        }
+
+        builder->CreateStore(value, elemPtr);
+    }
+
+    // ============================================
+    // ARRAY BOUNDS CHECKS
+    // ============================================
+    // Array lengths are static, so in `auto` mode an index whose value
+    // range is known at compile time (constants, counted-loop induction
+    // variables and +,-,* over them) needs no run-time check.
+
+    // Widen an array index to i64 and check it against the array length
+    Value* generateArrayIndex(shared_ptr<ASTNode> indexNode, Value* index,
+                              ArrayType* arrayType, const string& arrayName) {
+        index = convertValue(index, getInt64Type());
+        if (boundsCheckMode == BoundsCheckMode::Off) return index;
+
+        int64_t length = arrayType->getNumElements();
+        boundsCheckSites++;
+
+        IndexRange range;
+        if (indexRangeOf(indexNode, range)) {
+            if (range.lo >= 0 && range.hi < length) {
+                if (boundsCheckMode == BoundsCheckMode::Auto) {
+                    boundsChecksElided++;
+                    CAX_DEBUG(diag::CAT_IRGEN, "Bounds check removed: " << arrayName << "[...] on line "
+                              << indexNode->line << " stays within [" << range.lo << ", " << range.hi << "]");
+                    return index;
+                }
+            } else if (range.lo == range.hi) {
+                CAX_WARN(diag::CAT_IRGEN, "Index " << range.lo << " is out of range for '" << arrayName
+                         << "' (length " << length << ") on line " << indexNode->line);
+            }
+        }
+
+        emitBoundsCheck(currentFunction, index, builder->getInt64(length));
+        return index;
+    }
+
+    // Compile-time range of an integer index expression, if known
+    bool indexRangeOf(shared_ptr<ASTNode> node, IndexRange& range) {
+        switch (node->type) {
+            case NodeType::LITERAL: {
+                const string& text = node->value;
+                size_t digits = !text.empty() && text[0] == '-' ? 1 : 0;
+                if (text.size() <= digits || text.size() > 18 ||
+                    text.find_first_not_of("0123456789", digits) != string::npos) return false;
+                int64_t value = stoll(text);
+                range = {value, value};
+                return true;
+            }
+            case NodeType::IDENTIFIER:
+                for (auto it = inductionRanges.rbegin(); it != inductionRanges.rend(); ++it) {
+                    if (it->first == node->value) {
+                        range = it->second;
+                        return true;
                     }
                 }
+                return false;
+            case NodeType::FUNCTION_CALL: {
+                // len(array) of a fixed-length array
+                if (node->value != "len" || node->children.empty()) return false;
+                ArrayType* arrayType = staticArrayTypeOf(node->children[0]);
+                if (!arrayType) return false;
+                int64_t length = arrayType->getNumElements();
+                range = {length, length};
+                return true;
+            }
+            case NodeType::UNARY_OP: {
+                IndexRange operand;
+                if (node->value != "-" || node->children.empty() || !indexRangeOf(node->children[0], operand)) {
+                    return false;
+                }
+                range = {-operand.hi, -operand.lo};
+                return true;
             }
+            case NodeType::BINARY_OP: {
+                if (node->children.size() < 2) return false;
+                IndexRange lhs, rhs;
+                if (!indexRangeOf(node->children[0], lhs) || !indexRangeOf(node->children[1], rhs)) return false;
+                const string& op = node->value;
+                if (op == "+") {
+                    range = {lhs.lo + rhs.lo, lhs.hi + rhs.hi};
+                } else if (op == "-") {
+                    range = {lhs.lo - rhs.hi, lhs.hi - rhs.lo};
+                } else if (op == "*") {
+                    int64_t products[] = {lhs.lo * rhs.lo, lhs.lo * rhs.hi, lhs.hi * rhs.lo, lhs.hi * rhs.hi};
+                    range = {*min_element(begin(products), end(products)),
+                             *max_element(begin(products), end(products))};
+                } else {
+                    return false;
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
 
-            if (compatibleElements.empty()) {
-                return ConstantInt::get(*context, APInt(32, 0, true));
+    // Range of the induction variable inside the body of a counted loop
+    //   for (i = lo, i < hi, i++)   /   for (i = hi, i >= lo, i--)
+    // with the variable not written in the body. Returns the variable name,
+    // or "" when the loop is not of that shape.
+    string findInductionRange(shared_ptr<ASTNode> node, IndexRange& range) {
+        auto init = node->children[0];
+        auto cond = node->children[1];
+        auto update = node->children[2];
+
+        if (init->type != NodeType::ASSIGNMENT || init->children.size() != 1 ||
+            init->attributes.count("operator")) return "";
+        const string& var = init->value;
+
+        if (update->type != NodeType::UNARY_OP || update->children.empty() ||
+            update->children[0]->type != NodeType::IDENTIFIER || update->children[0]->value != var) return "";
+        bool increasing = update->value == "++post" || update->value == "++";
+
+        if (cond->type != NodeType::BINARY_OP || cond->children.size() < 2 ||
+            cond->children[0]->type != NodeType::IDENTIFIER || cond->children[0]->value != var) return "";
+
+        IndexRange start, limit;
+        if (!indexRangeOf(init->children[0], start) || !indexRangeOf(cond->children[1], limit)) return "";
+
+        const string& op = cond->value;
+        if (increasing && (op == "<" || op == "<=")) {
+            range = {start.lo, op == "<" ? limit.hi - 1 : limit.hi};
+        } else if (!increasing && (op == ">" || op == ">=")) {
+            range = {op == ">" ? limit.lo + 1 : limit.lo, start.hi};
+        } else {
+            return "";
+        }
+
+        if (writesVariable(node->children[3], var)) return "";
+        return var;
+    }
+
+    bool writesVariable(shared_ptr<ASTNode> node, const string& var) {
+        if ((node->type == NodeType::ASSIGNMENT || node->type == NodeType::RANGE_FOR) && node->value == var) return true;
+        if (node->type == NodeType::UNARY_OP && !node->children.empty() &&
+            node->children[0]->type == NodeType::IDENTIFIER && node->children[0]->value == var &&
+            node->value != "-" && node->value != "!") return true;
+        for (auto& child : node->children) {
+            if (writesVariable(child, var)) return true;
+        }
+        return false;
+    }
+
+    // ============================================
+    // PARALLEL LOOPS
+    // ============================================
+    // Under exec(threads=N, fraction) a counted loop
+    //   for (i = a, i < b, i++) { ... }      (or i <= b)
+    // whose iterations are independent is outlined into an internal
+    // function body(begin, end, env) running iterations [begin, end), and
+    // the loop becomes one cax_parallel_for call (runtime/cax_parallel.c).
+    // env is an array of pointers to the variables the body reads. Outer
+    // scalars are copied in (the body never writes them); arrays are used
+    // in place through boundArrays.
+
+    // Loops with fewer iterations than this (when known) stay serial
+    static constexpr int64_t PARALLEL_MIN_TRIP_COUNT = 64;
+
+    // exec(threads=N, fraction) and exec(cpu=C, weight); other resources
+    // are not supported yet
+    void readExecDirective(shared_ptr<ASTNode> node) {
+        string resource;
+        double amount = 0;
+        double fraction = 1.0;
+
+        for (auto& child : node->children) {
+            bool named = child->type == NodeType::ASSIGNMENT;
+            shared_ptr<ASTNode> valueNode = named ? (child->children.empty() ? nullptr : child->children[0]) : child;
+            double value = 0;
+            if (!valueNode || valueNode->type != NodeType::LITERAL || !parseNumber(valueNode->value, value)) {
+                CAX_WARN(diag::CAT_IRGEN, "exec parameter on line " << node->line << " is not a number; ignored");
+                continue;
+            }
+            if (named) {
+                resource = child->value;
+                amount = value;
+            } else {
+                fraction = value;
             }
+        }
+
+        if (resource != "threads" && resource != "cpu") {
+            CAX_INFO(diag::CAT_IRGEN, "exec(" << (resource.empty() ? "?" : resource) << "=...) on line "
+                     << node->line << " is not supported yet; ignored");
+            return;
+        }
+        if (fraction <= 0.0 || fraction > 1.0) {
+            CAX_WARN(diag::CAT_IRGEN, "exec " << (resource == "cpu" ? "weight " : "chunk fraction ") << fraction
+                     << " on line " << node->line << " is outside (0, 1]; using 1.0");
+            fraction = 1.0;
+        }
+        if (resource == "cpu") {
+            execCpus = max(0, (int)amount);
+            execWeight = fraction;
+        } else {
+            execThreads = max(1, (int)amount);
+            execFraction = fraction;
+        }
+    }
+
+    // Whether the pool can have more than one thread: exec(threads=N > 1),
+    // or a CPU budget alone (sized at run time) that is not a single CPU
+    bool parallelLoopsEnabled() const {
+        if (execThreads > 0) return execThreads > 1;
+        return execCpus == 0 || execCpus > 1;
+    }
 
-            // Create array with compatible elements
-            ArrayType* arrayType = ArrayType::get(elemType, compatibleElements.size());
-            Constant* arrayConstant = ConstantArray::get(arrayType, compatibleElements);
+    static bool parseNumber(const string& text, double& value) {
+        try {
+            size_t used = 0;
+            value = stod(text, &used);
+            return used == text.size();
+        } catch (...) {
+            return false;
+        }
+    }
 
-            AllocaInst* arrayAlloca = builder->CreateAlloca(arrayType, nullptr, "array");
-            builder->CreateStore(arrayConstant, arrayAlloca);
+    // Outline a counted loop whose init has just been generated. Returns
+    // false (generating nothing) when the loop must stay serial.
+    bool generateParallelFor(shared_ptr<ASTNode> node) {
+        auto init = node->children[0];
+        auto cond = node->children[1];
+        auto update = node->children[2];
+        auto body = node->children[3];
+
+        if (init->type != NodeType::ASSIGNMENT || init->children.size() != 1 ||
+            init->attributes.count("operator")) return false;
+        const string& var = init->value;
+        if (update->type != NodeType::UNARY_OP || (update->value != "++post" && update->value != "++") ||
+            update->children.empty() || update->children[0]->type != NodeType::IDENTIFIER ||
+            update->children[0]->value != var) return false;
+        if (cond->type != NodeType::BINARY_OP || (cond->value != "<" && cond->value != "<=") ||
+            cond->children.size() < 2 || cond->children[0]->type != NodeType::IDENTIFIER ||
+            cond->children[0]->value != var) return false;
+
+        if (!isScalarVariable(var) || !scalarTypes[var]->isIntegerTy()) return false;
+
+        IndexRange start, limit;
+        if (indexRangeOf(init->children[0], start) && indexRangeOf(cond->children[1], limit) &&
+            limit.hi - start.lo + (cond->value == "<=" ? 1 : 0) < PARALLEL_MIN_TRIP_COUNT) {
+            CAX_DEBUG(diag::CAT_IRGEN, "Loop on line " << node->line << " stays serial: too few iterations");
+            return false;
+        }
 
-            return arrayAlloca;
+        vector<string> captures;
+        string reason = findLoopDependence(body, var, cond, captures);
+        if (!reason.empty()) {
+            CAX_DEBUG(diag::CAT_IRGEN, "Loop on line " << node->line << " stays serial: " << reason);
+            return false;
         }
 
-        // Uniform type array
-        ArrayType* arrayType = ArrayType::get(elemType, elements.size());
-        Constant* arrayConstant = ConstantArray::get(arrayType, elements);
+        // Bounds, evaluated once (the body cannot change them)
+        Type* i64 = getInt64Type();
+        Type* inductionType = scalarTypes[var];
+        Value* begin = builder->CreateSExt(readVariable(var), i64, "begin");
+        Value* end = generateExpression(cond->children[1]);
+        if (!end) return false;
+        end = convertValue(end, i64);
+        if (cond->value == "<=") {
+            end = builder->CreateAdd(end, builder->getInt64(1), "end", false, true);
+        }
 
-        // Allocate space for array and store it
-        AllocaInst* arrayAlloca = builder->CreateAlloca(arrayType, nullptr, "array");
-        builder->CreateStore(arrayConstant, arrayAlloca);
+        IndexRange inductionRange;
+        bool rangeKnown = !findInductionRange(node, inductionRange).empty();
+        emitParallelFor(node, body, var, inductionType, begin, end, captures,
+                        rangeKnown ? &inductionRange : nullptr);
 
-        // Return pointer to array
-        return arrayAlloca;
+        // Leave the induction variable where the serial loop would have
+        Value* ran = builder->CreateICmpSLT(begin, end, "ran");
+        Value* last = builder->CreateSelect(ran, end, begin, "last");
+        writeVariable(var, builder->CreateTrunc(last, inductionType));
+        return true;
     }
 
-    Value* generateArrayAccess(shared_ptr<ASTNode> node) {
-        if (node->children.size() < 2) {
-            return ConstantInt::get(*context, APInt(32, 0, true));
+    // Outline `body` (iterations [begin, end) of `var`) and run it with
+    // cax_parallel_for. `range` is the induction variable's known range.
+    void emitParallelFor(shared_ptr<ASTNode> node, shared_ptr<ASTNode> body, const string& var,
+                         Type* inductionType, Value* begin, Value* end,
+                         const vector<string>& captures, const IndexRange* range) {
+        Type* i64 = getInt64Type();
+        Type* ptr = getPtrType();
+
+        // Pointers to everything the body reads
+        ArrayType* envType = ArrayType::get(ptr, max<size_t>(captures.size(), 1));
+        AllocaInst* env = createEntryBlockAlloca(currentFunction, "parfor.env", envType);
+        vector<Type*> captureTypes;
+        for (size_t i = 0; i < captures.size(); i++) {
+            Value* storage;
+            auto boundIt = boundArrays.find(captures[i]);
+            if (boundIt != boundArrays.end()) {
+                storage = boundIt->second.storage;
+                captureTypes.push_back(boundIt->second.type);
+            } else if (isScalarVariable(captures[i])) {
+                // Scalars are passed through a stack copy of their current value
+                Type* type = scalarTypes[captures[i]];
+                storage = createEntryBlockAlloca(currentFunction, captures[i] + ".capture", type);
+                builder->CreateStore(readVariable(captures[i]), storage);
+                captureTypes.push_back(type);
+            } else {
+                storage = namedValues[captures[i]];
+                captureTypes.push_back(namedValues[captures[i]]->getAllocatedType());
+            }
+            builder->CreateStore(storage, builder->CreateConstInBoundsGEP2_32(envType, env, 0, i));
         }
 
-        // Get array and index
-        Value* array = generateExpression(node->children[0]);
-        Value* index = generateExpression(node->children[1]);
+        Function* bodyFunc = generateParallelBody(node, body, var, inductionType, captures, captureTypes,
+                                                  envType, range);
 
-        if (!array || !index) {
-            return ConstantInt::get(*context, APInt(32, 0, true));
+        Function* parallelFor = getRuntimeFunction("cax_parallel_for", getVoidType(), {i64, i64, ptr, ptr});
+        builder->CreateCall(parallelFor, {begin, end, bodyFunc, env});
+        countParallelTrips(node, begin, end);
+
+        parallelLoops++;
+        CAX_DEBUG(diag::CAT_IRGEN, "Loop on line " << node->line << " runs in parallel as "
+                  << bodyFunc->getName().str());
+    }
+
+    // void <function>.parfor(i64 begin, i64 end, ptr env): the loop body for
+    // iterations [begin, end), generated with the normal statement code
+    Function* generateParallelBody(shared_ptr<ASTNode> node, shared_ptr<ASTNode> body, const string& var,
+                                   Type* inductionType, const vector<string>& captures,
+                                   const vector<Type*>& captureTypes, ArrayType* envType,
+                                   const IndexRange* range) {
+        Type* i64 = getInt64Type();
+        FunctionType* bodyType = FunctionType::get(getVoidType(), {i64, i64, getPtrType()}, false);
+        Function* bodyFunc = Function::Create(bodyType, Function::InternalLinkage,
+                                              currentFunction->getName() + ".parfor", module.get());
+        bodyFunc->setDoesNotThrow();
+        Argument* beginArg = bodyFunc->getArg(0);
+        Argument* endArg = bodyFunc->getArg(1);
+        Argument* envArg = bodyFunc->getArg(2);
+        beginArg->setName("begin");
+        endArg->setName("end");
+        envArg->setName("env");
+        envArg->addAttr(Attribute::NoAlias);
+
+        // Generate it as a function of its own
+        IRBuilderBase::InsertPoint savedIP = builder->saveIP();
+        Function* savedFunction = currentFunction;
+        map<string, AllocaInst*> savedValues;
+        savedValues.swap(namedValues);
+        map<string, Type*> savedScalars;
+        savedScalars.swap(scalarTypes);
+        map<string, BoundArray> savedArrays = boundArrays;
+        vector<AllocaInst*> savedTemporaries;
+        savedTemporaries.swap(statementTemporaries);
+        currentFunction = bodyFunc;
+        inParallelBody = true;
+
+        BasicBlock* entryBB = BasicBlock::Create(*context, "entry", bodyFunc);
+        builder->SetInsertPoint(entryBB);
+
+        for (size_t i = 0; i < captures.size(); i++) {
+            Value* storage = builder->CreateLoad(getPtrType(),
+                builder->CreateConstInBoundsGEP2_32(envType, envArg, 0, i), captures[i] + ".ptr");
+            if (auto* arrayType = dyn_cast<ArrayType>(captureTypes[i])) {
+                boundArrays[captures[i]] = {storage, arrayType};
+            } else {
+                scalarTypes[captures[i]] = captureTypes[i];
+                writeVariable(captures[i], builder->CreateLoad(captureTypes[i], storage, captures[i]));
+            }
+        }
+        scalarTypes[var] = inductionType;
+
+        BasicBlock* condBB = BasicBlock::Create(*context, "forcond", bodyFunc);
+        BasicBlock* loopBB = BasicBlock::Create(*context, "forbody", bodyFunc);
+        BasicBlock* afterBB = BasicBlock::Create(*context, "afterfor");
+        builder->CreateBr(condBB);
+
+        beginLoopHeader(condBB);
+        builder->SetInsertPoint(condBB);
+        PHINode* iv = builder->CreatePHI(i64, 2, "iv");
+        iv->addIncoming(beginArg, entryBB);
+        createProfiledCondBr(node, "for", builder->CreateICmpSLT(iv, endArg, "forcond"), loopBB, afterBB);
+
+        builder->SetInsertPoint(loopBB);
+        writeVariable(var, builder->CreateTrunc(iv, inductionType));
+
+        if (range) {
+            inductionRanges.push_back({var, *range});
+        }
+        generateBlock(body);
+        if (range) {
+            inductionRanges.pop_back();
+        }
+
+        Value* next = builder->CreateAdd(iv, builder->getInt64(1), "next", false, true);
+        iv->addIncoming(next, builder->GetInsertBlock());
+        attachLoopMetadata(builder->CreateBr(condBB), node, true);
+        sealBlock(condBB);
+
+        bodyFunc->insert(bodyFunc->end(), afterBB);
+        builder->SetInsertPoint(afterBB);
+        builder->CreateRetVoid();
+
+        inParallelBody = false;
+        currentFunction = savedFunction;
+        namedValues.swap(savedValues);
+        scalarTypes.swap(savedScalars);
+        boundArrays = savedArrays;
+        statementTemporaries.swap(savedTemporaries);
+        builder->restoreIP(savedIP);
+        return bodyFunc;
+    }
+
+    // Why the iterations of a counted loop over `var` may not run in any
+    // order, or "" when they may. The body may only write
+    //  - elements of outer arrays whose first index is `var` itself (reads
+    //    of those arrays must use the same first index)
+    //  - private locals: referenced nowhere outside the body, and first
+    //    assigned by a plain assignment that runs on every iteration before
+    //    any other use
+    // and may not print, return, use vectors or call functions other than
+    // len(), range() and the read-only tensor reductions. `captures` receives the
+    // outer variables the body reads.
+    string findLoopDependence(shared_ptr<ASTNode> body, const string& var, shared_ptr<ASTNode> bound,
+                              vector<string>& captures) {
+        set<string> privates;
+        set<string> candidates;
+        function<void(const ASTNode*)> collect = [&](const ASTNode* n) {
+            if (n->type == NodeType::ASSIGNMENT || n->type == NodeType::IDENTIFIER ||
+                n->type == NodeType::RANGE_FOR) candidates.insert(n->value);
+            for (auto& child : n->children) collect(child.get());
+        };
+        collect(body.get());
+        for (const string& name : candidates) {
+            // The outlined body has no `this`
+            if (isField(name)) return "it uses field '" + name + "'";
+            if (name != var && isLoopPrivate(body, name)) privates.insert(name);
+        }
+
+        // Outer arrays written by the body
+        set<string> written;
+        string reason;
+        function<void(const ASTNode*)> findWrites = [&](const ASTNode* n) {
+            if (n->type == NodeType::ASSIGNMENT && n->attributes.count("member")) {
+                reason = "it writes elements of '" + n->value + "'";
+            } else if (n->type == NodeType::ASSIGNMENT && n->children.size() >= 2 && !privates.count(n->value)) {
+                written.insert(n->value);
+                const ASTNode* first = n->children[0].get();
+                if (first->type != NodeType::IDENTIFIER || first->value != var) {
+                    reason = "'" + n->value + "' is written at an index other than " + var;
+                }
+            }
+            for (auto& child : n->children) findWrites(child.get());
+        };
+        findWrites(body.get());
+        if (!reason.empty()) return reason;
+
+        set<string> captured;
+        function<void(const ASTNode*, const ASTNode*)> check = [&](const ASTNode* n, const ASTNode* parent) {
+            if (!reason.empty()) return;
+            switch (n->type) {
+                case NodeType::PRINT_STMT:
+                    reason = "it prints";
+                    return;
+                case NodeType::RETURN_STMT:
+                    reason = "it returns";
+                    return;
+                case NodeType::VECTOR_DECL:
+                    reason = "it declares a vector";
+                    return;
+                case NodeType::FUNCTION_CALL:
+                    if (n->value != "len" && n->value != "range" && !getCastBuiltinType(n->value) &&
+                        !(isTensorBuiltin(n->value) && tensorOutputArg(n->value) < 0 && !functions.count(n->value))) {
+                        reason = "it calls " + n->value + "()";
+                        return;
+                    }
+                    break;
+                case NodeType::ASSIGNMENT:
+                case NodeType::RANGE_FOR:
+                    if (n->value == var) {
+                        reason = "it assigns " + var;
+                        return;
+                    }
+                    if ((n->type == NodeType::RANGE_FOR || n->children.size() == 1) && !privates.count(n->value)) {
+                        reason = "it assigns outer variable '" + n->value + "'";
+                        return;
+                    }
+                    break;
+                case NodeType::UNARY_OP:
+                    if ((n->value == "++post" || n->value == "--post" || n->value == "++" || n->value == "--") &&
+                        !n->children.empty() && !privates.count(n->children[0]->value)) {
+                        reason = "it increments outer variable '" + n->children[0]->value + "'";
+                        return;
+                    }
+                    break;
+                case NodeType::ARRAY_ACCESS: {
+                    // m[i][j] is (m[i])[j]: the innermost access holds the first index
+                    const ASTNode* inner = n;
+                    while (inner->children[0]->type == NodeType::ARRAY_ACCESS) inner = inner->children[0].get();
+                    const ASTNode* base = inner->children[0].get();
+                    if (base->type == NodeType::IDENTIFIER && written.count(base->value) && inner == n &&
+                        (inner->children[1]->type != NodeType::IDENTIFIER || inner->children[1]->value != var)) {
+                        reason = "'" + base->value + "' is read at an index other than " + var;
+                        return;
+                    }
+                    break;
+                }
+                case NodeType::IDENTIFIER: {
+                    const string& name = n->value;
+                    if (name == var || privates.count(name)) break;
+                    auto boundIt = boundArrays.find(name);
+                    if (boundIt != boundArrays.end() && isa<GlobalVariable>(boundIt->second.storage)) break;
+                    bool indexed = parent && parent->type == NodeType::ARRAY_ACCESS && parent->children[0].get() == n;
+                    bool measured = parent && parent->type == NodeType::FUNCTION_CALL && parent->value == "len";
+                    if (written.count(name) && !indexed && !measured) {
+                        reason = "written array '" + name + "' is used whole";
+                        return;
+                    }
+                    if (captured.insert(name).second) captures.push_back(name);
+                    break;
+                }
+                case NodeType::BLOCK: case NodeType::IF_STMT: case NodeType::WHILE_STMT:
+                case NodeType::FOR_STMT: case NodeType::BINARY_OP: case NodeType::LITERAL:
+                case NodeType::ARRAY_LITERAL:
+                    break;
+                default:
+                    reason = "it contains an unsupported statement";
+                    return;
+            }
+            for (auto& child : n->children) check(child.get(), n);
+        };
+        check(body.get(), nullptr);
+
+        // Written arrays are captured through ASSIGNMENT nodes, not identifiers
+        for (const string& name : written) {
+            if (captured.insert(name).second) captures.push_back(name);
+        }
+        if (!reason.empty()) return reason;
+
+        // The bound is evaluated once up front, so it must not depend on the body
+        function<bool(const ASTNode*)> invariant = [&](const ASTNode* n) {
+            if (n->type == NodeType::FUNCTION_CALL) return n->value == "len";   // Array lengths are static
+            if (n->type == NodeType::UNARY_OP && n->value != "-" && n->value != "!") return false;
+            if (n->type == NodeType::IDENTIFIER && written.count(n->value)) return false;
+            for (auto& child : n->children) {
+                if (!invariant(child.get())) return false;
+            }
+            return true;
+        };
+        if (bound && !invariant(bound.get())) return "its bound may change inside the loop";
+
+        // Everything captured must be a plain local or an array
+        for (const string& name : captures) {
+            if (boundArrays.count(name) || isScalarVariable(name)) continue;
+            if (objectVectors.count(name)) return "it uses vector '" + name + "'";
+            auto it = namedValues.find(name);
+            if (it == namedValues.end() || !it->second) return "'" + name + "' is not defined before the loop";
+            if (isVectorSlot(it->second)) return "it uses vector '" + name + "'";
+        }
+        return "";
+    }
+
+    // See findLoopDependence: `name` lives only inside one iteration of `body`
+    bool isLoopPrivate(shared_ptr<ASTNode> body, const string& name) {
+        function<int(const ASTNode*)> references = [&](const ASTNode* n) {
+            int count = (n->type == NodeType::ASSIGNMENT || n->type == NodeType::IDENTIFIER ||
+                         n->type == NodeType::VECTOR_DECL || n->type == NodeType::RANGE_FOR) && n->value == name;
+            for (auto& child : n->children) count += references(child.get());
+            return count;
+        };
+        if (!currentFunctionNode || references(currentFunctionNode) != references(body.get())) return false;
+
+        // First reference in source order, with the path of nodes leading to it
+        vector<const ASTNode*> path;
+        function<bool(const ASTNode*)> findFirst = [&](const ASTNode* n) {
+            path.push_back(n);
+            if ((n->type == NodeType::ASSIGNMENT || n->type == NodeType::IDENTIFIER ||
+                 n->type == NodeType::RANGE_FOR) && n->value == name) return true;
+            for (auto& child : n->children) {
+                if (findFirst(child.get())) return true;
+            }
+            path.pop_back();
+            return false;
+        };
+        if (!findFirst(body.get())) return false;
+
+        // A plain assignment, or the variable of a nested range loop
+        const ASTNode* def = path.back();
+        if (def->type == NodeType::IDENTIFIER || def->children.size() != 1 || def->attributes.count("operator")) {
+            return false;
+        }
+        function<bool(const ASTNode*)> mentions = [&](const ASTNode* n) {
+            if (n->type == NodeType::IDENTIFIER && n->value == name) return true;
+            for (auto& child : n->children) {
+                if (mentions(child.get())) return true;
+            }
+            return false;
+        };
+        if (mentions(def->children[0].get())) return false;
+
+        // Runs on every iteration: reached only through blocks, or as the
+        // init (or range) of a nested for loop
+        for (size_t i = 0; i + 1 < path.size(); i++) {
+            const ASTNode* step = path[i];
+            if (step->type == NodeType::BLOCK) continue;
+            if (step->type == NodeType::FOR_STMT && step->children[0].get() == path[i + 1]) continue;
+            return false;
+        }
+        return true;
+    }
+
+    // ============================================
+    // TENSOR BUILTINS
+    // ============================================
+    //   dot(x, y)                 sum(x)  vmax(x)  vmin(x)
+    //   axpy(alpha, x, y)         y += alpha * x
+    //   vadd/vsub/vmul/vdiv(x, y, out)
+    //   matmul(a, b, c)           c = a * b for 2-D float arrays
+    //   matmul(a, b, c, m, k, n)  same on flat operands with explicit sizes
+    // Operands are float arrays (used as flat row-major buffers) or
+    // vector<float>. The kernels live in runtime/cax_tensor.c.
+
+    struct TensorOperand {
+        Value* data;
+        Value* length;           // Element count (i64)
+        ArrayType* arrayType;    // Static shape; null for vectors
+    };
+
+    static bool isTensorBuiltin(const string& name) {
+        return name == "dot" || name == "sum" || name == "vmax" || name == "vmin" ||
+               tensorOutputArg(name) >= 0;
+    }
+
+    // Index of the argument a kernel writes to, or -1
+    static int tensorOutputArg(const string& name) {
+        if (name == "axpy" || name == "matmul" || name == "vadd" ||
+            name == "vsub" || name == "vmul" || name == "vdiv") return 2;
+        return -1;
+    }
+
+    bool getTensorOperand(const string& funcName, shared_ptr<ASTNode> node, TensorOperand& operand) {
+        if (VectorRef vec = lookupVector(node)) {
+            StructType* vecType = vec.type;
+            if (getVectorElementOf(vecType)->isDoubleTy()) {
+                operand.data = builder->CreateLoad(getPtrType(), builder->CreateStructGEP(vecType, vec.storage, 0), "data");
+                operand.length = builder->CreateLoad(getInt64Type(), builder->CreateStructGEP(vecType, vec.storage, 1), "size");
+                operand.arrayType = nullptr;
+                return true;
+            }
+        } else if (ArrayType* arrayType = staticArrayTypeOf(node)) {
+            if (node->type == NodeType::IDENTIFIER && getArrayLeafType(arrayType)->isDoubleTy()) {
+                const DataLayout& layout = module->getDataLayout();
+                operand.data = generateExpression(node);
+                operand.length = builder->getInt64(layout.getTypeAllocSize(arrayType) / sizeof(double));
+                operand.arrayType = arrayType;
+                return true;
+            }
         }
 
-        // If array is an alloca (pointer to array), load element
-        if (AllocaInst* allocaInst = dyn_cast<AllocaInst>(array)) {
-            Type* allocatedType = allocaInst->getAllocatedType();
+        CAX_ERROR(diag::CAT_IRGEN, "'" << funcName << "' expects float arrays or vector<float> operands (line "
+                  << node->line << ")");
+        return false;
+    }
+
+    Value* generateTensorCall(const string& funcName, shared_ptr<ASTNode> node) {
+        bool reduction = funcName == "sum" || funcName == "vmax" || funcName == "vmin";
+        bool isAxpy = funcName == "axpy";
+        size_t firstOperand = isAxpy ? 1 : 0;
+        size_t operandCount = reduction ? 1 : (funcName == "dot" || isAxpy) ? 2 : 3;
+
+        bool explicitShape = funcName == "matmul" && node->children.size() == 6;
+        if (node->children.size() != firstOperand + operandCount && !explicitShape) {
+            CAX_ERROR(diag::CAT_IRGEN, "Wrong number of arguments to '" << funcName << "' (line " << node->line << ")");
+            return nullptr;
+        }
+
+        vector<TensorOperand> operands(operandCount);
+        for (size_t i = 0; i < operandCount; i++) {
+            if (!getTensorOperand(funcName, node->children[firstOperand + i], operands[i])) return nullptr;
+        }
+
+        Type* f64 = getDoubleType();
+        Type* i64 = getInt64Type();
+        Type* ptr = getPtrType();
+
+        if (funcName == "matmul") {
+            return generateMatmul(node, operands, explicitShape);
+        }
+
+        // Element count: static lengths must agree; otherwise the shortest wins
+        Value* count = operands[0].length;
+        bool allStatic = true;
+        for (auto& operand : operands) {
+            if (!operand.arrayType) allStatic = false;
+        }
+        if (allStatic) {
+            for (auto& operand : operands) {
+                if (operand.length != count) {
+                    CAX_ERROR(diag::CAT_IRGEN, "'" << funcName << "' operands differ in length (line "
+                              << node->line << ")");
+                    return nullptr;
+                }
+            }
+        } else {
+            for (size_t i = 1; i < operands.size(); i++) {
+                Value* shorter = builder->CreateICmpULT(operands[i].length, count, "shorter");
+                count = builder->CreateSelect(shorter, operands[i].length, count, "count");
+            }
+        }
+
+        if (reduction) {
+            string name = funcName == "sum" ? "cax_sum_f64" : funcName == "vmax" ? "cax_max_f64" : "cax_min_f64";
+            Function* kernel = getRuntimeFunction(name, f64, {ptr, i64});
+            return builder->CreateCall(kernel, {operands[0].data, count}, funcName);
+        }
+        if (funcName == "dot") {
+            Function* kernel = getRuntimeFunction("cax_dot_f64", f64, {ptr, ptr, i64});
+            return builder->CreateCall(kernel, {operands[0].data, operands[1].data, count}, "dot");
+        }
+        if (isAxpy) {
+            Value* alpha = generateExpression(node->children[0]);
+            if (!alpha) return nullptr;
+            Function* kernel = getRuntimeFunction("cax_axpy_f64", getVoidType(), {i64, f64, ptr, ptr});
+            builder->CreateCall(kernel, {count, convertValue(alpha, f64), operands[0].data, operands[1].data});
+            return nullptr;
+        }
 
-            if (ArrayType* arrayType = dyn_cast<ArrayType>(allocatedType)) {
-                // GEP to get pointer to element
-                vector<Value*> indices;
-                indices.push_back(ConstantInt::get(*context, APInt(32, 0)));
-                indices.push_back(index);
+        // vadd / vsub / vmul / vdiv
+        string name = "cax_" + funcName.substr(1) + "_f64";
+        Function* kernel = getRuntimeFunction(name, getVoidType(), {ptr, ptr, ptr, i64});
+        builder->CreateCall(kernel, {operands[0].data, operands[1].data, operands[2].data, count});
+        return nullptr;
+    }
 
-                Value* elemPtr = builder->CreateInBoundsGEP(
-                    arrayType,
-                    array,
-                    indices,
-                    "arrayelem"
-                );
+    Value* generateMatmul(shared_ptr<ASTNode> node, vector<TensorOperand>& operands, bool explicitShape) {
+        Type* i64 = getInt64Type();
+        Value *m, *k, *n;
 
-                // Load the element
-                return builder->CreateLoad(arrayType->getElementType(), elemPtr, "arrayval");
+        if (explicitShape) {
+            Value* dims[3];
+            for (int i = 0; i < 3; i++) {
+                dims[i] = generateExpression(node->children[3 + i]);
+                if (!dims[i]) return nullptr;
+                dims[i] = convertValue(dims[i], i64);
+            }
+            m = dims[0];
+            k = dims[1];
+            n = dims[2];
+
+            // Each operand must hold its m*k, k*n and m*n elements
+            Value* needed[3] = {builder->CreateMul(m, k), builder->CreateMul(k, n), builder->CreateMul(m, n)};
+            for (int i = 0; i < 3; i++) {
+                emitShapeCheck(needed[i], operands[i].length);
+            }
+        } else {
+            // c[M][N] = a[M][K] * b[K][N], all from the static shapes
+            uint64_t shape[3][2];
+            for (int i = 0; i < 3; i++) {
+                ArrayType* rows = operands[i].arrayType;
+                ArrayType* cols = rows ? dyn_cast<ArrayType>(rows->getElementType()) : nullptr;
+                if (!cols || cols->getElementType()->isArrayTy()) {
+                    CAX_ERROR(diag::CAT_IRGEN, "matmul(a, b, c) needs 2-D float arrays; pass m, k, n for "
+                              << "other operands (line " << node->line << ")");
+                    return nullptr;
+                }
+                shape[i][0] = rows->getNumElements();
+                shape[i][1] = cols->getNumElements();
+            }
+            if (shape[0][1] != shape[1][0] || shape[2][0] != shape[0][0] || shape[2][1] != shape[1][1]) {
+                CAX_ERROR(diag::CAT_IRGEN, "matmul shapes do not match: [" << shape[0][0] << "x" << shape[0][1]
+                          << "] * [" << shape[1][0] << "x" << shape[1][1] << "] -> [" << shape[2][0] << "x"
+                          << shape[2][1] << "] (line " << node->line << ")");
+                return nullptr;
+            }
+            m = builder->getInt64(shape[0][0]);
+            k = builder->getInt64(shape[0][1]);
+            n = builder->getInt64(shape[1][1]);
+        }
+
+        Type* ptr = getPtrType();
+        Function* kernel = getRuntimeFunction("cax_matmul_f64", getVoidType(), {ptr, ptr, ptr, i64, i64, i64});
+        builder->CreateCall(kernel, {operands[0].data, operands[1].data, operands[2].data, m, k, n});
+        return nullptr;
+    }
+
+    // Abort when an operand holds fewer than `needed` elements
+    void emitShapeCheck(Value* needed, Value* available) {
+        Function* failFunc = getRuntimeFunction("cax_tensor_shape_fail", getVoidType(),
+                                                {getInt64Type(), getInt64Type()});
+        failFunc->setDoesNotReturn();
+        failFunc->addFnAttr(Attribute::Cold);
+
+        BasicBlock* failBB = BasicBlock::Create(*context, "badshape", currentFunction);
+        BasicBlock* okBB = BasicBlock::Create(*context, "shapeok", currentFunction);
+
+        MDBuilder weights(*context);
+        Value* fits = builder->CreateICmpULE(needed, available, "fits");
+        builder->CreateCondBr(fits, okBB, failBB, weights.createBranchWeights(2000, 1));
+
+        builder->SetInsertPoint(failBB);
+        builder->CreateCall(failFunc, {needed, available});
+        builder->CreateUnreachable();
+
+        builder->SetInsertPoint(okBB);
+    }
+
+    // ============================================
+    // VECTOR SUPPORT
+    // ============================================
+    // vector<T> lives in a stack slot laid out as
+    //   %cax.vec.<T> = type { ptr data, i64 size, i64 capacity, [N x T] inline }
+    // i.e. CaxVector (runtime/cax_runtime.h) followed by its small buffer.
+    // data points at the inline buffer until cax_vec_grow first moves the
+    // elements to the heap. push/pop/get/set/size are emitted once per
+    // element type as internal alwaysinline helpers, so the fast path is
+    // inlined at every call site; only growth and bounds failures call out.
+
+    static constexpr uint64_t VECTOR_INLINE_BYTES = 64;  // CAX_VEC_INLINE_BYTES
+
+    Type* getVectorElementType(const string& typeName) {
+        if (Type* type = vectorElementTypeNamed(typeName)) return type;
+
+        CAX_WARN(diag::CAT_IRGEN, "Unknown vector element type '" << typeName << "', using int");
+        return getInt32Type();
+    }
+
+    Type* vectorElementTypeNamed(const string& typeName) {
+        if (typeName == "int" || typeName == "integer") return getInt32Type();
+        // Float literals are generated as double, so float vectors hold doubles
+        if (typeName == "float" || typeName == "double") return getDoubleType();
+        if (typeName == "char") return getInt8Type();
+        if (typeName == "string") return getPtrType();
+        if (typeName == "bool" || typeName == "boolean") return getBoolType();
+        // Explicit widths: vector<i64>, vector<f32> ...
+        if (Type* type = getCastBuiltinType(typeName)) return type;
+        return nullptr;
+    }
+
+    string getTypeSuffix(Type* type) {
+        if (type->isIntegerTy()) return "i" + to_string(type->getIntegerBitWidth());
+        if (type->isDoubleTy()) return "f64";
+        if (type->isFloatTy()) return "f32";
+        if (type->isPointerTy()) return "str";
+        return "any";
+    }
+
+    StructType* getVectorType(Type* elemType) {
+        string name = "cax.vec." + getTypeSuffix(elemType);
+        auto it = structTypes.find(name);
+        if (it != structTypes.end()) {
+            return cast<StructType>(it->second);
+        }
+
+        uint64_t elemSize = module->getDataLayout().getTypeAllocSize(elemType);
+        uint64_t inlineCount = max<uint64_t>(1, VECTOR_INLINE_BYTES / elemSize);
+
+        StructType* vecType = StructType::create(
+            *context,
+            {getPtrType(), getInt64Type(), getInt64Type(), ArrayType::get(elemType, inlineCount)},
+            name
+        );
+        structTypes[name] = vecType;
+        return vecType;
+    }
+
+    static bool isVectorType(Type* type) {
+        auto* structType = dyn_cast_or_null<StructType>(type);
+        return structType && structType->hasName() && structType->getName().substr(0, 8) == "cax.vec.";
+    }
+
+    bool isVectorSlot(AllocaInst* slot) { return isVectorType(slot->getAllocatedType()); }
+
+    Type* getVectorElementOf(StructType* vecType) {
+        return cast<ArrayType>(vecType->getElementType(3))->getElementType();
+    }
+
+    VectorRef lookupVector(shared_ptr<ASTNode> node) {
+        if (!node || node->type != NodeType::IDENTIFIER) return {};
+        if (isField(node->value)) {
+            Type* type = fieldType(node->value);
+            if (!isVectorType(type)) return {};
+            return {fieldAddress(node->value), cast<StructType>(type)};
+        }
+        auto it = namedValues.find(node->value);
+        if (it == namedValues.end() || !it->second || !isVectorSlot(it->second)) return {};
+        return {it->second, cast<StructType>(it->second->getAllocatedType())};
+    }
+
+    // Vector slots are initialized (empty, pointing at the inline buffer)
+    // right after their alloca in the entry block, so cleanup on return is
+    // valid even if the declaration itself was never reached.
+    AllocaInst* createVectorSlot(const string& varName, StructType* vecType) {
+        BasicBlock& entry = currentFunction->getEntryBlock();
+        IRBuilder<> tmpBuilder(&entry, entry.begin());
+
+        AllocaInst* slot = tmpBuilder.CreateAlloca(vecType, nullptr, varName);
+        initVectorHeader(tmpBuilder, vecType, slot, varName);
+        return slot;
+    }
+
+    // Empty vector using its inline buffer
+    void initVectorHeader(IRBuilderBase& init, StructType* vecType, Value* vec, const string& name) {
+        ArrayType* inlineType = cast<ArrayType>(vecType->getElementType(3));
+
+        Value* inlineBuf = init.CreateStructGEP(vecType, vec, 3, name + ".inline");
+        init.CreateStore(inlineBuf, init.CreateStructGEP(vecType, vec, 0));
+        init.CreateStore(ConstantInt::get(getInt64Type(), 0), init.CreateStructGEP(vecType, vec, 1));
+        init.CreateStore(ConstantInt::get(getInt64Type(), inlineType->getNumElements()),
+                         init.CreateStructGEP(vecType, vec, 2));
+    }
+
+    void emitVectorCleanup() {
+        emitObjectVectorCleanup();
+        emitStackObjectCleanup();
+        for (AllocaInst* slot : functionVectors) {
+            emitVectorFree(cast<StructType>(slot->getAllocatedType()), slot);
+        }
+    }
+
+    // Frees a vector's heap storage and leaves it empty on its inline
+    // buffer again, capacity included, so a later push stays in bounds
+    void emitVectorFree(StructType* vecType, Value* vec) {
+        Function* freeFunc = getRuntimeFunction("cax_vec_free", getVoidType(), {getPtrType(), getInt64Type()});
+        uint64_t inlineCount = cast<ArrayType>(vecType->getElementType(3))->getNumElements();
+        builder->CreateCall(freeFunc, {vec, builder->getInt64(inlineCount)});
+    }
+
+    Value* generateVectorCall(VectorRef vec, const string& method, shared_ptr<ASTNode> node) {
+        StructType* vecType = vec.type;
+
+        if (method == "size") {
+            Value* size = builder->CreateCall(getVectorHelper(vecType, "size"), {vec.storage}, "size");
+            return builder->CreateTrunc(size, getInt32Type(), "size32");
+        }
+        if (method == "pop") {
+            return builder->CreateCall(getVectorHelper(vecType, "pop"), {vec.storage}, "popped");
+        }
+
+        // push(value)
+        if (node->children.size() < 2) {
+            CAX_ERROR(diag::CAT_IRGEN, "push() needs a value");
+            return nullptr;
+        }
+        shared_ptr<ASTNode> arg = node->children[1];
+        Value* value = generateExpression(arg);
+        if (!value) return nullptr;
+
+        Type* elemType = getVectorElementOf(vecType);
+        // "a" lexes as a char literal; a string vector wants the string
+        if (elemType->isPointerTy() && value->getType()->isIntegerTy(8) && arg->type == NodeType::LITERAL) {
+            value = getStringPtr(arg->value);
+        }
+        value = convertValue(value, elemType);
+        if (value->getType() != elemType) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot push a " << getTypeSuffix(value->getType()) << " value into vector<"
+                      << getTypeSuffix(elemType) << "> on line " << node->line);
+            return nullptr;
+        }
+        builder->CreateCall(getVectorHelper(vecType, "push"), {vec.storage, value});
+        return nullptr;
+    }
+
+    // Branch when `index` is not below `size`; only taken on a bug
+    void emitBoundsCheck(Function* func, Value* index, Value* size) {
+        Function* failFunc = getRuntimeFunction("cax_bounds_fail", getVoidType(),
+                                                {getInt64Type(), getInt64Type()});
+        failFunc->setDoesNotReturn();
+        failFunc->addFnAttr(Attribute::Cold);
+
+        BasicBlock* failBB = BasicBlock::Create(*context, "oob", func);
+        BasicBlock* okBB = BasicBlock::Create(*context, "inbounds", func);
+
+        MDBuilder weights(*context);
+        Value* inRange = builder->CreateICmpULT(index, size, "inrange");
+        builder->CreateCondBr(inRange, okBB, failBB, weights.createBranchWeights(2000, 1));
+
+        builder->SetInsertPoint(failBB);
+        builder->CreateCall(failFunc, {index, size});
+        builder->CreateUnreachable();
+
+        builder->SetInsertPoint(okBB);
+    }
+
+    Function* getVectorHelper(StructType* vecType, const string& op) {
+        string name = vecType->getName().str() + "." + op;   // e.g. cax.vec.i32.push
+        if (Function* existing = module->getFunction(name)) {
+            return existing;
+        }
+
+        Type* elemType = getVectorElementOf(vecType);
+        Type* i64 = getInt64Type();
+        uint64_t elemSize = module->getDataLayout().getTypeAllocSize(elemType);
+
+        FunctionType* funcType;
+        if (op == "push") {
+            funcType = FunctionType::get(getVoidType(), {getPtrType(), elemType}, false);
+        } else if (op == "pop") {
+            funcType = FunctionType::get(elemType, {getPtrType()}, false);
+        } else if (op == "get") {
+            funcType = FunctionType::get(elemType, {getPtrType(), i64}, false);
+        } else if (op == "set") {
+            funcType = FunctionType::get(getVoidType(), {getPtrType(), i64, elemType}, false);
+        } else {
+            funcType = FunctionType::get(i64, {getPtrType()}, false);   // size
+        }
+
+        Function* func = Function::Create(funcType, Function::InternalLinkage, name, module.get());
+        func->addFnAttr(Attribute::AlwaysInline);
+        func->setDoesNotThrow();
+
+        IRBuilderBase::InsertPointGuard guard(*builder);
+        builder->SetInsertPoint(BasicBlock::Create(*context, "entry", func));
+
+        Value* vec = func->getArg(0);
+        Value* sizePtr = builder->CreateStructGEP(vecType, vec, 1, "sizeptr");
+        Value* size = builder->CreateLoad(i64, sizePtr, "size");
+        MDBuilder weights(*context);
+
+        if (op == "size") {
+            builder->CreateRet(size);
+            return func;
+        }
+
+        if (op == "push") {
+            Value* capacity = builder->CreateLoad(i64, builder->CreateStructGEP(vecType, vec, 2), "capacity");
+            BasicBlock* growBB = BasicBlock::Create(*context, "grow", func);
+            BasicBlock* storeBB = BasicBlock::Create(*context, "store", func);
+
+            Value* full = builder->CreateICmpUGE(size, capacity, "full");
+            builder->CreateCondBr(full, growBB, storeBB, weights.createBranchWeights(1, 2000));
+
+            builder->SetInsertPoint(growBB);
+            Function* growFunc = getRuntimeFunction("cax_vec_grow", getVoidType(),
+                                                    {getPtrType(), i64, i64});
+            builder->CreateCall(growFunc, {vec, ConstantInt::get(i64, elemSize),
+                                           builder->CreateAdd(size, ConstantInt::get(i64, 1))});
+            builder->CreateBr(storeBB);
+
+            builder->SetInsertPoint(storeBB);
+            Value* data = builder->CreateLoad(getPtrType(), builder->CreateStructGEP(vecType, vec, 0), "data");
+            Value* slot = builder->CreateInBoundsGEP(elemType, data, size, "slot");
+            builder->CreateStore(func->getArg(1), slot);
+            builder->CreateStore(builder->CreateNUWAdd(size, ConstantInt::get(i64, 1)), sizePtr);
+            builder->CreateRetVoid();
+            return func;
+        }
+
+        if (op == "pop") {
+            BasicBlock* emptyBB = BasicBlock::Create(*context, "empty", func);
+            BasicBlock* popBB = BasicBlock::Create(*context, "pop", func);
+
+            Value* empty = builder->CreateICmpEQ(size, ConstantInt::get(i64, 0), "isempty");
+            builder->CreateCondBr(empty, emptyBB, popBB, weights.createBranchWeights(1, 2000));
+
+            // Popping an empty vector is an error when checked, a no-op otherwise
+            builder->SetInsertPoint(emptyBB);
+            if (boundsCheckMode != BoundsCheckMode::Off) {
+                emitBoundsCheck(func, ConstantInt::get(i64, 0), size);
+            }
+            builder->CreateRet(Constant::getNullValue(elemType));
+
+            builder->SetInsertPoint(popBB);
+            Value* newSize = builder->CreateSub(size, ConstantInt::get(i64, 1), "newsize");
+            builder->CreateStore(newSize, sizePtr);
+            Value* data = builder->CreateLoad(getPtrType(), builder->CreateStructGEP(vecType, vec, 0), "data");
+            Value* slot = builder->CreateInBoundsGEP(elemType, data, newSize, "slot");
+            builder->CreateRet(builder->CreateLoad(elemType, slot, "value"));
+            return func;
+        }
+
+        // get / set
+        Value* index = func->getArg(1);
+        if (boundsCheckMode != BoundsCheckMode::Off) {
+            emitBoundsCheck(func, index, size);
+        }
+        Value* data = builder->CreateLoad(getPtrType(), builder->CreateStructGEP(vecType, vec, 0), "data");
+        Value* slot = builder->CreateInBoundsGEP(elemType, data, index, "slot");
+
+        if (op == "get") {
+            builder->CreateRet(builder->CreateLoad(elemType, slot, "value"));
+        } else {
+            builder->CreateStore(func->getArg(2), slot);
+            builder->CreateRetVoid();
+        }
+        return func;
+    }
+
+    // ============================================
+    // CLASSES
+    // ============================================
+    // class() = "Name" { object: fields ... } becomes a named struct
+    //   %class.Name = type { field, field, ... }
+    // Fields carry no declared type: each gets the join of the values the
+    // class's methods assign to it (see TYPE INFERENCE); an array literal
+    // makes it an inline array, `vector<T> field` an inline vector.
+    //
+    // Fields are stored by decreasing alignment, then size, which removes
+    // the padding between them; class(Ordered) keeps declaration order
+    // (e.g. for a layout shared with C). Name() allocates a zeroed
+    // instance on the heap.
+    //
+    // Methods are plain functions named Class::method taking the object as
+    // a `this` pointer, and obj.method() is a direct call to the one the
+    // object's static class defines: there are no vtables, so the inliner
+    // sees through every member call. Inside a method, field names refer
+    // to the fields of `this`.
+
+    struct ClassInfo {
+        shared_ptr<ASTNode> node;
+        StructType* type = nullptr;
+        vector<string> fields;                   // In layout order
+        map<string, unsigned> fieldIndex;
+        map<string, Function*> methods;
+        map<string, string> returnClasses;       // Method -> class of the object it returns
+    };
+
+    map<string, ClassInfo> classes;
+    map<string, string> objectClasses;           // Local -> class of the object it holds
+    bool layoutReport = false;                   // --layout-report
+
+    // Method being generated
+    const ClassInfo* currentClass = nullptr;
+    Value* thisPtr = nullptr;
+
+    void setLayoutReport(bool enabled) { layoutReport = enabled; }
+
+    const ClassInfo* findClass(const string& name) {
+        auto it = classes.find(name);
+        return it == classes.end() ? nullptr : &it->second;
+    }
+
+    // Class of the object an expression produces: Name(), a local holding
+    // an object, or a method returning one ("" if not an object)
+    string objectClassOf(shared_ptr<ASTNode> node) {
+        if (node->type == NodeType::FUNCTION_CALL) {
+            if (findClass(node->value) && node->children.empty()) return node->value;
+            if (node->children.empty()) return "";
+            const ClassInfo* receiver = classOf(node->children[0]);
+            if (!receiver) return "";
+            auto it = receiver->returnClasses.find(node->value);
+            return it == receiver->returnClasses.end() ? "" : it->second;
+        }
+        if (node->type == NodeType::IDENTIFIER) {
+            auto it = objectClasses.find(node->value);
+            return it == objectClasses.end() ? "" : it->second;
+        }
+        return "";
+    }
+
+    // Class of the object an expression refers to, if known statically
+    const ClassInfo* classOf(shared_ptr<ASTNode> node) {
+        // c[i] of a vector of objects
+        if (node->type == NodeType::ARRAY_ACCESS && !node->children.empty() &&
+            node->children[0]->type == NodeType::IDENTIFIER) {
+            auto it = vectorClasses.find(node->children[0]->value);
+            return it == vectorClasses.end() ? nullptr : findClass(it->second);
+        }
+        if (node->type != NodeType::IDENTIFIER) return nullptr;
+        auto it = objectClasses.find(node->value);
+        return it == objectClasses.end() ? nullptr : findClass(it->second);
+    }
+
+    // Type of a field: the join over every method that assigns it
+    Type* inferFieldType(ClassInfo& info, const string& field) {
+        Type* fieldType = nullptr;
+        StaticType scalar;
+        for (auto& section : info.node->children) {
+            if (section->type != NodeType::MEMBER_SECTION) continue;
+            for (auto& method : section->children) {
+                inferLocalTypes(method);
+                auto it = localTypes.find(field);
+                if (it != localTypes.end()) {
+                    StaticType joined = joinStatic(scalar, it->second);
+                    if (joined.type) scalar = joined;
+                }
+
+                function<void(shared_ptr<ASTNode>)> visit = [&](shared_ptr<ASTNode> node) {
+                    if (node->type == NodeType::VECTOR_DECL && node->value == field) {
+                        auto typeIt = node->attributes.find("elementType");
+                        if (typeIt != node->attributes.end() && !findClass(typeIt->second)) {
+                            fieldType = getVectorType(getVectorElementType(typeIt->second));
+                        }
+                    } else if (node->type == NodeType::ASSIGNMENT && node->value == field &&
+                               node->children.size() == 1 &&
+                               node->children[0]->type == NodeType::ARRAY_LITERAL) {
+                        vector<uint64_t> shape;
+                        vector<shared_ptr<ASTNode>> leaves;
+                        size_t leafDepth = SIZE_MAX;
+                        Type* leaf = arrayLiteralType(node->children[0]).type;
+                        if (leaf && collectArrayShape(node->children[0], 0, shape, leaves, leafDepth)) {
+                            Type* arrayType = leaf;
+                            for (auto extent = shape.rbegin(); extent != shape.rend(); ++extent) {
+                                arrayType = ArrayType::get(arrayType, *extent);
+                            }
+                            fieldType = arrayType;
+                        }
+                    }
+                    for (auto& child : node->children) visit(child);
+                };
+                visit(method);
+            }
+        }
+        if (fieldType) return fieldType;
+        if (scalar.type) return scalar.type;
+
+        CAX_WARN(diag::CAT_IRGEN, "Field '" << field << "' of class " << info.node->value
+                 << " is never assigned; using int");
+        return getInt32Type();
+    }
+
+    void declareClass(shared_ptr<ASTNode> node) {
+        const string& name = node->value;
+        if (classes.count(name)) {
+            CAX_ERROR(diag::CAT_IRGEN, "Class " << name << " is declared twice");
+            return;
+        }
+        ClassInfo& info = classes[name];
+        info.node = node;
+
+        vector<pair<string, Type*>> fields;
+        for (auto& section : node->children) {
+            if (section->type != NodeType::OBJECT_SECTION) continue;
+            for (auto& field : section->children) {
+                fields.push_back({field->value, inferFieldType(info, field->value)});
+            }
+        }
+        localTypes.clear();
+        elementTypes.clear();
+        objectClasses.clear();
+
+        vector<Type*> declared;
+        for (auto& field : fields) declared.push_back(field.second);
+
+        bool keepOrder = hasAnnotation(node, "Ordered");
+        if (!keepOrder) {
+            const DataLayout& layout = module->getDataLayout();
+            stable_sort(fields.begin(), fields.end(), [&](const pair<string, Type*>& a, const pair<string, Type*>& b) {
+                Align alignA = layout.getABITypeAlign(a.second);
+                Align alignB = layout.getABITypeAlign(b.second);
+                if (alignA != alignB) return alignA > alignB;
+                return layout.getTypeAllocSize(a.second) > layout.getTypeAllocSize(b.second);
+            });
+        }
+
+        vector<Type*> body;
+        for (auto& field : fields) {
+            info.fieldIndex[field.first] = info.fields.size();
+            info.fields.push_back(field.first);
+            body.push_back(field.second);
+        }
+        info.type = StructType::create(*context, body, "class." + name);
+        structTypes[info.type->getName().str()] = info.type;
+
+        if (layoutReport) {
+            printClassLayout(info, keepOrder ? nullptr : StructType::get(*context, declared));
+        }
+    }
+
+    // Size, padding and cache-line span of a class, and where each field
+    // sits. `declared` is the declaration-order layout, to show the saving.
+    void printClassLayout(const ClassInfo& info, StructType* declared) {
+        static constexpr uint64_t CACHE_LINE = 64;
+        const DataLayout& layout = module->getDataLayout();
+        const StructLayout* structLayout = layout.getStructLayout(info.type);
+
+        uint64_t size = structLayout->getSizeInBytes();
+        uint64_t payload = 0;
+        for (Type* field : info.type->elements()) payload += layout.getTypeStoreSize(field);
+        uint64_t lines = size == 0 ? 0 : (size + CACHE_LINE - 1) / CACHE_LINE;
+
+        cout << "Class " << info.node->value << ": " << size << " bytes, align "
+             << structLayout->getAlignment().value() << ", " << (size - payload) << " bytes padding, "
+             << lines << " cache line" << (lines == 1 ? "" : "s");
+        if (declared) {
+            cout << " (declaration order: " << layout.getStructLayout(declared)->getSizeInBytes() << " bytes)\n";
+        } else {
+            cout << " (declaration order kept)\n";
+        }
+
+        for (unsigned i = 0; i < info.fields.size(); i++) {
+            Type* fieldType = info.type->getElementType(i);
+            uint64_t offset = structLayout->getElementOffset(i);
+            uint64_t fieldSize = layout.getTypeStoreSize(fieldType);
+            string typeName;
+            raw_string_ostream typeStream(typeName);
+            fieldType->print(typeStream, false, true);
+
+            cout << "  +" << offset << "\t" << fieldSize << "\t" << info.fields[i] << ": " << typeStream.str();
+            if (fieldSize > 0 && offset / CACHE_LINE != (offset + fieldSize - 1) / CACHE_LINE) {
+                cout << "  [crosses a cache line]";
+            }
+            cout << "\n";
+        }
+    }
+
+    // Class::method(ptr this), returning the join of its return values
+    void declareMethods(ClassInfo& info) {
+        currentClass = &info;
+        for (auto& section : info.node->children) {
+            if (section->type != NodeType::MEMBER_SECTION) continue;
+            for (auto& method : section->children) {
+                const string& name = method->value;
+                if (!isReachable(method.get())) continue;
+                if (info.methods.count(name)) {
+                    CAX_ERROR(diag::CAT_IRGEN, "Method " << info.node->value << "::" << name << " is declared twice");
+                    continue;
+                }
+                if (hasAnnotation(method, "Main")) {
+                    CAX_WARN(diag::CAT_IRGEN, "Method " << info.node->value << "::" << name
+                             << " cannot be the program entry point; ignoring Main");
+                }
+
+                inferLocalTypes(method);
+                StaticType result;
+                function<void(shared_ptr<ASTNode>)> visit = [&](shared_ptr<ASTNode> node) {
+                    if (node->type == NodeType::RETURN_STMT && !node->children.empty()) {
+                        StaticType joined = joinStatic(result, typeOf(node->children[0]));
+                        if (joined.type) result = joined;
+                        string objectClass = objectClassOf(node->children[0]);
+                        if (!objectClass.empty()) info.returnClasses[name] = objectClass;
+                    }
+                    for (auto& child : node->children) visit(child);
+                };
+                visit(method);
+
+                Type* returnType = result.type && !result.type->isAggregateType() ? result.type : getVoidType();
+                FunctionType* methodType = FunctionType::get(returnType, {getPtrType()}, false);
+                string mangled = info.node->value + "::" + name;
+                Function* func = createFunction(method, mangled, methodType, false);
+                func->getArg(0)->setName("this");
+                func->addParamAttr(0, Attribute::NonNull);
+                info.methods[name] = func;
+                functions[mangled] = func;
+                CAX_INFO(diag::CAT_IRGEN, "Declaring method: " << mangled);
+            }
+        }
+        currentClass = nullptr;
+    }
+
+    void generateMethods(const ClassInfo& info) {
+        for (auto& entry : info.methods) {
+            for (auto& section : info.node->children) {
+                if (section->type != NodeType::MEMBER_SECTION) continue;
+                for (auto& method : section->children) {
+                    if (method->value != entry.first) continue;
+                    currentClass = &info;
+                    thisPtr = entry.second->getArg(0);
+                    generateFunctionBody(method, entry.second, false);
+                    currentClass = nullptr;
+                    thisPtr = nullptr;
+                    break;
+                }
+            }
+        }
+    }
+
+    // obj.method() and, inside a method, method() on `this`. Returns
+    // nullptr if the call is not a member call.
+    Function* resolveMethod(shared_ptr<ASTNode> node, shared_ptr<ASTNode>& object) {
+        object = nullptr;
+        if (!node->children.empty()) {
+            if (const ClassInfo* info = classOf(node->children[0])) {
+                auto it = info->methods.find(node->value);
+                if (it != info->methods.end()) {
+                    object = node->children[0];
+                    return it->second;
+                }
+            }
+        }
+        if (currentClass) {
+            auto it = currentClass->methods.find(node->value);
+            if (it != currentClass->methods.end()) return it->second;
+        }
+        return nullptr;
+    }
+
+    Value* generateMethodCall(shared_ptr<ASTNode> node, Function* method, shared_ptr<ASTNode> object) {
+        size_t explicitArgs = node->children.size() - (object ? 1 : 0);
+        if (explicitArgs > 0) {
+            CAX_ERROR(diag::CAT_IRGEN, method->getName().str() << " takes no arguments (line " << node->line << ")");
+            return nullptr;
+        }
+        shared_ptr<ASTNode> indexNode;
+        if (ObjectVector* vec = object ? lookupObjectElement(object, indexNode) : nullptr) {
+            return generateElementMethodCall(*vec, indexNode, method);
+        }
+        Value* self = object ? generateExpression(object) : thisPtr;
+        if (!self || !self->getType()->isPointerTy()) return nullptr;
+
+        CallInst* call = builder->CreateCall(method, {self});
+        call->setCallingConv(method->getCallingConv());
+        return method->getReturnType()->isVoidTy() ? nullptr : call;
+    }
+
+    // Field of `this` inside a method
+    bool isField(const string& name) {
+        return currentClass && thisPtr && currentClass->fieldIndex.count(name);
+    }
+
+    Type* fieldType(const string& name) {
+        return currentClass->type->getElementType(currentClass->fieldIndex.at(name));
+    }
+
+    Value* fieldAddress(const string& name) {
+        return builder->CreateStructGEP(currentClass->type, thisPtr, currentClass->fieldIndex.at(name),
+                                        name + ".addr");
+    }
+
+    // Name(): a zeroed instance, in a stack slot of its own when escape
+    // analysis proved it cannot outlive the function, else from the
+    // class's slab pool. Vector fields start empty, on their inline buffer.
+    Value* generateConstructor(const ClassInfo& info, shared_ptr<ASTNode> site) {
+        Value* object;
+        if (stackObjects.count(site.get())) {
+            Value* size = ConstantExpr::getSizeOf(info.type);
+            Align align = module->getDataLayout().getABITypeAlign(info.type);
+            AllocaInst* slot = createEntryBlockAlloca(currentFunction, info.node->value + ".obj", info.type);
+            slot->setAlignment(align);
+            if (hasVectorFields(info)) {
+                // Zeroed on entry so the cleanup on return is safe even if
+                // the constructor never ran; a constructor in a loop frees
+                // the previous instance's vectors before reusing the slot
+                IRBuilder<> entry(slot->getParent(), std::next(slot->getIterator()));
+                entry.CreateMemSet(slot, entry.getInt8(0), size, align);
+                emitVectorFieldsFree(info, slot);
+                stackObjectSlots.push_back({slot, &info});
+            }
+            builder->CreateMemSet(slot, builder->getInt8(0), size, align);
+            object = slot;
+        } else {
+            Function* alloc = getRuntimeFunction("cax_slab_alloc", getPtrType(), {getPtrType()});
+            object = builder->CreateCall(alloc, {getClassPool(info)}, info.node->value + ".obj");
+        }
+
+        for (unsigned i = 0; i < info.fields.size(); i++) {
+            auto* vecType = dyn_cast<StructType>(info.type->getElementType(i));
+            if (vecType && isVectorType(vecType)) {
+                Value* vec = builder->CreateStructGEP(info.type, object, i, info.fields[i]);
+                initVectorHeader(*builder, vecType, vec, info.fields[i]);
+            }
+        }
+        return object;
+    }
+
+    bool hasVectorFields(const ClassInfo& info) {
+        for (Type* field : info.type->elements()) {
+            if (isVectorType(field)) return true;
+        }
+        return false;
+    }
+
+    void emitVectorFieldsFree(const ClassInfo& info, Value* object) {
+        for (unsigned i = 0; i < info.fields.size(); i++) {
+            Type* field = info.type->getElementType(i);
+            if (isVectorType(field)) {
+                emitVectorFree(cast<StructType>(field), builder->CreateStructGEP(info.type, object, i, info.fields[i]));
+            }
+        }
+    }
+
+    // class.<Name>.pool: the CaxSlabPool heap instances of the class come
+    // from (runtime/cax_slab.c); the runtime fills in its state on first use
+    GlobalVariable* getClassPool(const ClassInfo& info) {
+        string name = "class." + info.node->value + ".pool";
+        if (GlobalVariable* existing = module->getNamedGlobal(name)) return existing;
+
+        StructType* poolType = StructType::getTypeByName(*context, "cax.slabpool");
+        if (!poolType) poolType = StructType::create(*context, {getInt64Type(), getPtrType()}, "cax.slabpool");
+        Constant* init = ConstantStruct::get(poolType, {ConstantExpr::getSizeOf(info.type),
+                                                        ConstantPointerNull::get(getPtrType())});
+        return new GlobalVariable(*module, poolType, false, GlobalValue::InternalLinkage, init, name);
+    }
+
+    // Name::~Name(ptr this): frees the vector fields, then returns the
+    // instance to the class's pool
+    Function* getDestructor(const ClassInfo& info) {
+        string name = info.node->value + "::~" + info.node->value;
+        if (Function* existing = module->getFunction(name)) return existing;
+
+        FunctionType* type = FunctionType::get(getVoidType(), {getPtrType()}, false);
+        Function* func = Function::Create(type, Function::InternalLinkage, name, module.get());
+        func->setCallingConv(CallingConv::Fast);
+        func->setDoesNotThrow();
+        func->getArg(0)->setName("this");
+
+        IRBuilderBase::InsertPointGuard guard(*builder);
+        builder->SetInsertPoint(BasicBlock::Create(*context, "entry", func));
+        emitVectorFieldsFree(info, func->getArg(0));
+        Function* release = getRuntimeFunction("cax_slab_free", getVoidType(), {getPtrType(), getPtrType()});
+        builder->CreateCall(release, {getClassPool(info), func->getArg(0)});
+        builder->CreateRetVoid();
+        return func;
+    }
+
+    // delete(obj): runs the destructor of a heap instance. Escape analysis
+    // already keeps anything passed here off the stack.
+    Value* generateDelete(shared_ptr<ASTNode> node) {
+        const ClassInfo* info = node->children.size() == 1 ? findClass(objectClassOf(node->children[0])) : nullptr;
+        if (!info) {
+            CAX_ERROR(diag::CAT_IRGEN, "delete() needs an object (line " << node->line << ")");
+            return nullptr;
+        }
+        Value* object = generateExpression(node->children[0]);
+        if (!object || !object->getType()->isPointerTy()) return nullptr;
+
+        Function* destructor = getDestructor(*info);
+        CallInst* call = builder->CreateCall(destructor, {object});
+        call->setCallingConv(destructor->getCallingConv());
+        return nullptr;
+    }
+
+    // Vectors held by stack instances are freed with the function's own
+    void emitStackObjectCleanup() {
+        for (auto& entry : stackObjectSlots) emitVectorFieldsFree(*entry.second, entry.first);
+    }
+
+    // object.field: scalars are loaded, arrays and vectors give their address
+    Value* generateMemberAccess(shared_ptr<ASTNode> node) {
+        if (node->children.empty()) return nullptr;
+        const ClassInfo* info = classOf(node->children[0]);
+        if (!info) {
+            CAX_ERROR(diag::CAT_IRGEN, "'." << node->value << "' on a value that is not an object (line "
+                      << node->line << ")");
+            return nullptr;
+        }
+        auto fieldIt = info->fieldIndex.find(node->value);
+        if (fieldIt == info->fieldIndex.end()) {
+            CAX_ERROR(diag::CAT_IRGEN, "Class " << info->node->value << " has no field '" << node->value
+                      << "' (line " << node->line << ")");
+            return nullptr;
+        }
+
+        Type* fieldType = info->type->getElementType(fieldIt->second);
+        Value* fieldPtr;
+        shared_ptr<ASTNode> indexNode;
+        if (ObjectVector* vec = lookupObjectElement(node->children[0], indexNode)) {
+            Value* index = generateObjectIndex(*vec, indexNode);
+            if (!index) return nullptr;
+            fieldPtr = elementFieldAddress(*vec, index, fieldIt->second);
+        } else {
+            Value* object = generateExpression(node->children[0]);
+            if (!object || !object->getType()->isPointerTy()) return nullptr;
+            fieldPtr = builder->CreateStructGEP(info->type, object, fieldIt->second, node->value + ".addr");
+        }
+        if (fieldType->isAggregateType()) return fieldPtr;
+        return builder->CreateLoad(fieldType, fieldPtr, node->value);
+    }
+
+    // ============================================
+    // ESCAPE ANALYSIS
+    // ============================================
+    // An object can only outlive the function that creates it through a
+    // pointer copied somewhere else. A local assigned Name() keeps its
+    // object local as long as the variable is only ever used as obj.field
+    // or as the receiver of a method call: methods cannot leak `this`
+    // (the language has no way to name it), and an outlined parallel loop
+    // finishes before the function continues. Each such constructor site
+    // gets its own stack slot, which SROA breaks into scalars once the
+    // methods are inlined. Everything else (returned, assigned or stored
+    // elsewhere, passed on, constructed as a temporary, or held in a field)
+    // stays on the heap.
+
+    set<const ASTNode*> stackObjects;            // Constructor calls of the current function
+    vector<pair<AllocaInst*, const ClassInfo*>> stackObjectSlots;   // Stack instances with vector fields
+    int objectSites = 0;
+    int stackObjectSites = 0;
+
+    bool isConstructorCall(shared_ptr<ASTNode> node) {
+        if (node->type != NodeType::FUNCTION_CALL || !node->children.empty() || !findClass(node->value)) return false;
+        auto userFunc = functions.find(node->value);
+        return userFunc == functions.end() || !userFunc->second;
+    }
+
+    void findStackObjects(shared_ptr<ASTNode> funcNode) {
+        stackObjects.clear();
+        stackObjectSlots.clear();
+        map<string, vector<const ASTNode*>> sites;   // Local -> constructor calls assigned to it
+        map<string, string> escapes;                 // Local -> why its objects escape
+        vector<pair<const ASTNode*, string>> temporaries;
+
+        // c.push(x) on a vector of objects copies x (or zero-fills for Name())
+        auto pushedToVector = [&](const ASTNode* node, const ASTNode* parent) {
+            return parent && parent->type == NodeType::FUNCTION_CALL && parent->value == "push" &&
+                   parent->children.size() == 2 && parent->children[1].get() == node &&
+                   parent->children[0]->type == NodeType::IDENTIFIER && vectorClasses.count(parent->children[0]->value);
+        };
+
+        function<void(shared_ptr<ASTNode>, const ASTNode*)> visit = [&](shared_ptr<ASTNode> node, const ASTNode* parent) {
+            if (isConstructorCall(node) && pushedToVector(node.get(), parent)) {
+                // Not an allocation
+            } else if (isConstructorCall(node)) {
+                objectSites++;
+                bool bound = parent && parent->type == NodeType::ASSIGNMENT && parent->children.size() == 1 &&
+                             !parent->attributes.count("operator");
+                if (!bound) {
+                    temporaries.push_back({node.get(), "it is not assigned to a local"});
+                } else if (isField(parent->value)) {
+                    temporaries.push_back({node.get(), "it is stored in field '" + parent->value + "'"});
+                } else {
+                    sites[parent->value].push_back(node.get());
+                }
+            } else if (node->type == NodeType::IDENTIFIER && !escapes.count(node->value)) {
+                bool fieldAccess = parent && parent->type == NodeType::MEMBER_ACCESS &&
+                                   parent->children[0].get() == node.get();
+                bool receiver = false;
+                if (parent && parent->type == NodeType::FUNCTION_CALL && parent->children[0].get() == node.get()) {
+                    const ClassInfo* info = classOf(node);
+                    receiver = info && info->methods.count(parent->value);
+                }
+                if (!fieldAccess && !receiver && !pushedToVector(node.get(), parent)) {
+                    escapes[node->value] = "'" + node->value + "' is used as a value (line " + to_string(node->line) + ")";
+                }
+            }
+            for (auto& child : node->children) visit(child, node.get());
+        };
+        visit(funcNode, nullptr);
+
+        for (auto& entry : sites) {
+            auto escape = escapes.find(entry.first);
+            for (const ASTNode* site : entry.second) {
+                if (escape == escapes.end()) {
+                    stackObjects.insert(site);
+                    stackObjectSites++;
+                } else {
+                    temporaries.push_back({site, escape->second});
+                }
+            }
+        }
+        for (auto& heap : temporaries) {
+            CAX_DEBUG(diag::CAT_IRGEN, heap.first->value << "() on line " << heap.first->line
+                      << " is heap-allocated: " << heap.second);
+        }
+    }
+
+    // ============================================
+    // VECTORS OF OBJECTS
+    // ============================================
+    // vector<Name> of a class holds its instances by value, in heap columns
+    // managed by the runtime (CaxColumns in runtime/cax_runtime.h):
+    //   %cax.objvec.<Name> = type { i64 size, i64 capacity, [K x ptr] columns }
+    // By default there is a single column of %class.Name records (array of
+    // structs). vector<soa Name>, or any vector of a class(SoA) class, gets
+    // one column per field instead (structure of arrays): a loop reading
+    // c[i].age walks one contiguous, cache-line aligned array with unit
+    // stride and vectorizes.
+    //
+    // c[i].field reads and writes the column directly. c[i].method() runs
+    // on the record in place, or for SoA on a stack copy gathered from the
+    // columns and scattered back afterwards (SROA removes the copy once the
+    // method is inlined). Elements move when the vector grows, so they are
+    // only used through c[i].field and c[i].method(), never as values.
+
+    struct ObjectVector {
+        AllocaInst* slot = nullptr;
+        const ClassInfo* cls = nullptr;
+        StructType* type = nullptr;
+        bool soa = false;
+
+        unsigned columns() const { return soa ? cls->fields.size() : 1; }
+    };
+
+    map<string, ObjectVector> objectVectors;    // Locals of the current function
+    map<string, string> vectorClasses;           // Local -> element class (from type inference)
+
+    bool isSoALayout(shared_ptr<ASTNode> decl, const ClassInfo& cls) {
+        auto layout = decl->attributes.find("layout");
+        return (layout != decl->attributes.end() && layout->second == "soa") || hasAnnotation(cls.node, "SoA");
+    }
+
+    StructType* getObjectVectorType(const ClassInfo& cls, bool soa) {
+        string name = "cax.objvec." + string(soa ? "soa." : "") + cls.node->value;
+        auto it = structTypes.find(name);
+        if (it != structTypes.end()) return cast<StructType>(it->second);
+
+        unsigned columns = soa ? cls.fields.size() : 1;
+        StructType* type = StructType::create(
+            *context,
+            {getInt64Type(), getInt64Type(), ArrayType::get(getPtrType(), max(columns, 1u))},
+            name
+        );
+        structTypes[name] = type;
+        return type;
+    }
+
+    Type* getColumnType(const ObjectVector& vec, unsigned column) {
+        return vec.soa ? vec.cls->type->getElementType(column) : vec.cls->type;
+    }
+
+    // Bytes per element of each column, for cax_columns_grow
+    GlobalVariable* getColumnSizes(const ObjectVector& vec) {
+        string name = vec.type->getName().str() + ".sizes";
+        if (GlobalVariable* existing = module->getNamedGlobal(name)) return existing;
+
+        vector<Constant*> sizes;
+        for (unsigned k = 0; k < vec.columns(); k++) {
+            sizes.push_back(ConstantExpr::getSizeOf(getColumnType(vec, k)));
+        }
+        if (sizes.empty()) sizes.push_back(builder->getInt64(1));
+        ArrayType* type = ArrayType::get(getInt64Type(), sizes.size());
+        auto* global = new GlobalVariable(*module, type, true, GlobalValue::PrivateLinkage,
+                                          ConstantArray::get(type, sizes), name);
+        global->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        return global;
+    }
+
+    ObjectVector* lookupObjectVector(shared_ptr<ASTNode> node) {
+        if (!node || node->type != NodeType::IDENTIFIER) return nullptr;
+        auto it = objectVectors.find(node->value);
+        return it == objectVectors.end() ? nullptr : &it->second;
+    }
+
+    // c[i] with c a vector of objects: the vector and the index node
+    ObjectVector* lookupObjectElement(shared_ptr<ASTNode> node, shared_ptr<ASTNode>& indexNode) {
+        if (node->type != NodeType::ARRAY_ACCESS || node->children.size() != 2) return nullptr;
+        indexNode = node->children[1];
+        return lookupObjectVector(node->children[0]);
+    }
+
+    // Slots live in the entry block, zeroed (empty, no columns), so the
+    // cleanup on return is valid even if the declaration was never reached
+    void generateObjectVectorDecl(shared_ptr<ASTNode> node, const ClassInfo& cls) {
+        const string& name = node->value;
+        if (isField(name)) {
+            CAX_ERROR(diag::CAT_IRGEN, "Field '" << name << "' cannot be a vector of objects (line " << node->line << ")");
+            return;
+        }
+        for (Type* field : cls.type->elements()) {
+            if (isVectorType(field)) {
+                CAX_ERROR(diag::CAT_IRGEN, "vector<" << cls.node->value << "> is not supported: the class has a "
+                          << "vector field (line " << node->line << ")");
+                return;
+            }
+        }
+
+        bool soa = isSoALayout(node, cls);
+        StructType* type = getObjectVectorType(cls, soa);
+        auto it = objectVectors.find(name);
+        if (it == objectVectors.end() || it->second.type != type) {
+            BasicBlock& entry = currentFunction->getEntryBlock();
+            IRBuilder<> tmpBuilder(&entry, entry.begin());
+            AllocaInst* slot = tmpBuilder.CreateAlloca(type, nullptr, name);
+            tmpBuilder.CreateStore(Constant::getNullValue(type), slot);
+            objectVectors[name] = {slot, &cls, type, soa};
+            it = objectVectors.find(name);
+        }
+
+        // (Re)declaring empties the vector but keeps its columns
+        builder->CreateStore(builder->getInt64(0), builder->CreateStructGEP(type, it->second.slot, 0, "sizeptr"));
+    }
+
+    void emitObjectVectorCleanup() {
+        if (objectVectors.empty()) return;
+        Function* freeFunc = getRuntimeFunction("cax_columns_free", getVoidType(), {getPtrType(), getInt32Type()});
+        for (auto& entry : objectVectors) {
+            builder->CreateCall(freeFunc, {entry.second.slot, builder->getInt32(entry.second.columns())});
+        }
+    }
+
+    Value* loadColumn(const ObjectVector& vec, unsigned column) {
+        Value* columnPtr = builder->CreateInBoundsGEP(vec.type, vec.slot,
+                                                      {builder->getInt32(0), builder->getInt32(2), builder->getInt32(column)});
+        return builder->CreateLoad(getPtrType(), columnPtr, "column");
+    }
+
+    Value* objectVectorSize(const ObjectVector& vec) {
+        return builder->CreateLoad(getInt64Type(), builder->CreateStructGEP(vec.type, vec.slot, 0), "size");
+    }
+
+    Value* generateObjectIndex(const ObjectVector& vec, shared_ptr<ASTNode> indexNode) {
+        Value* index = generateExpression(indexNode);
+        if (!index) return nullptr;
+        index = convertValue(index, getInt64Type());
+        if (boundsCheckMode != BoundsCheckMode::Off) {
+            emitBoundsCheck(currentFunction, index, objectVectorSize(vec));
+        }
+        return index;
+    }
+
+    // Address of field `field` of element `index`
+    Value* elementFieldAddress(const ObjectVector& vec, Value* index, unsigned field) {
+        const string& name = vec.cls->fields[field];
+        if (vec.soa) {
+            return builder->CreateInBoundsGEP(vec.cls->type->getElementType(field), loadColumn(vec, field), index,
+                                              name + ".addr");
+        }
+        return builder->CreateInBoundsGEP(vec.cls->type, loadColumn(vec, 0), {index, builder->getInt32(field)},
+                                          name + ".addr");
+    }
+
+    // Copy one field between memory locations (scalars by value, arrays by memcpy)
+    void copyField(Type* type, Value* dst, Value* src) {
+        if (type->isAggregateType()) {
+            const DataLayout& layout = module->getDataLayout();
+            Align align = layout.getABITypeAlign(type);
+            builder->CreateMemCpy(dst, align, src, align, ConstantExpr::getSizeOf(type));
+            return;
+        }
+        builder->CreateStore(builder->CreateLoad(type, src), dst);
+    }
+
+    Value* generateObjectVectorCall(ObjectVector& vec, const string& method, shared_ptr<ASTNode> node) {
+        if (method == "size") {
+            return builder->CreateTrunc(objectVectorSize(vec), getInt32Type(), "size32");
+        }
+        if (method != "push") {
+            CAX_ERROR(diag::CAT_IRGEN, method << "() is not supported on vector<" << vec.cls->node->value << ">");
+            return nullptr;
+        }
+
+        // push(Name()) appends a zeroed instance, push(obj) a copy of obj
+        const string& className = vec.cls->node->value;
+        shared_ptr<ASTNode> arg = node->children.size() == 2 ? node->children[1] : nullptr;
+        Value* source = nullptr;
+        if (!arg || (!(isConstructorCall(arg) && arg->value == className) && objectClassOf(arg) != className)) {
+            CAX_ERROR(diag::CAT_IRGEN, "push() on vector<" << className << "> takes " << className << "() or a "
+                      << className << " object (line " << node->line << ")");
+            return nullptr;
+        }
+        if (!isConstructorCall(arg)) {
+            source = generateExpression(arg);
+            if (!source) return nullptr;
+        }
+
+        Value* size = objectVectorSize(vec);
+        Value* capacity = builder->CreateLoad(getInt64Type(), builder->CreateStructGEP(vec.type, vec.slot, 1), "capacity");
+        BasicBlock* growBB = BasicBlock::Create(*context, "objvec.grow", currentFunction);
+        BasicBlock* storeBB = BasicBlock::Create(*context, "objvec.store", currentFunction);
+        MDBuilder weights(*context);
+        builder->CreateCondBr(builder->CreateICmpUGE(size, capacity, "full"), growBB, storeBB,
+                              weights.createBranchWeights(1, 64));
+
+        builder->SetInsertPoint(growBB);
+        Function* grow = getRuntimeFunction("cax_columns_grow", getVoidType(),
+                                            {getPtrType(), getInt32Type(), getPtrType(), getInt64Type()});
+        builder->CreateCall(grow, {vec.slot, builder->getInt32(vec.columns()), getColumnSizes(vec),
+                                   builder->CreateAdd(size, builder->getInt64(1))});
+        builder->CreateBr(storeBB);
+
+        builder->SetInsertPoint(storeBB);
+        for (unsigned k = 0; k < vec.columns(); k++) {
+            Type* type = getColumnType(vec, k);
+            Value* dst = builder->CreateInBoundsGEP(type, loadColumn(vec, k), size, "slot");
+            if (!source) {
+                Align align = module->getDataLayout().getABITypeAlign(type);
+                builder->CreateMemSet(dst, builder->getInt8(0), ConstantExpr::getSizeOf(type), align);
+            } else if (vec.soa) {
+                copyField(type, dst, builder->CreateStructGEP(vec.cls->type, source, k));
+            } else {
+                copyField(type, dst, source);
+            }
+        }
+        builder->CreateStore(builder->CreateAdd(size, builder->getInt64(1), "newsize"),
+                             builder->CreateStructGEP(vec.type, vec.slot, 0));
+        return nullptr;
+    }
+
+    // c[i].field (op)= value
+    void generateElementFieldAssignment(shared_ptr<ASTNode> node) {
+        const string& field = node->attributes["member"];
+        auto it = objectVectors.find(node->value);
+        if (it == objectVectors.end() || node->children.size() != 2) {
+            CAX_ERROR(diag::CAT_IRGEN, "'" << node->value << "[...]." << field << "' needs a vector of objects (line "
+                      << node->line << ")");
+            return;
+        }
+        ObjectVector& vec = it->second;
+        auto fieldIt = vec.cls->fieldIndex.find(field);
+        if (fieldIt == vec.cls->fieldIndex.end()) {
+            CAX_ERROR(diag::CAT_IRGEN, "Class " << vec.cls->node->value << " has no field '" << field << "' (line "
+                      << node->line << ")");
+            return;
+        }
+        Type* type = vec.cls->type->getElementType(fieldIt->second);
+        if (type->isAggregateType()) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign to array field '" << field << "' on line " << node->line);
+            return;
+        }
+
+        Value* index = generateObjectIndex(vec, node->children[0]);
+        Value* value = generateExpression(node->children[1]);
+        if (!index || !value) return;
+        Value* addr = elementFieldAddress(vec, index, fieldIt->second);
+
+        auto opIt = node->attributes.find("operator");
+        if (opIt != node->attributes.end() && opIt->second != "=") {
+            Value* current = builder->CreateLoad(type, addr, field);
+            value = createArithmetic(opIt->second.substr(0, 1), current, convertValue(value, type));
+            if (!value) return;
+        }
+        value = convertValue(value, type);
+        if (value->getType() != type) {
+            CAX_ERROR(diag::CAT_IRGEN, "Cannot assign a " << getTypeSuffix(value->getType()) << " value to field '"
+                      << field << "' (" << getTypeSuffix(type) << ") on line " << node->line);
+            return;
+        }
+        builder->CreateStore(value, addr);
+    }
+
+    // c[i].method(): on the record itself, or on a gathered copy for SoA
+    Value* generateElementMethodCall(ObjectVector& vec, shared_ptr<ASTNode> indexNode, Function* method) {
+        Value* index = generateObjectIndex(vec, indexNode);
+        if (!index) return nullptr;
+
+        if (!vec.soa) {
+            Value* self = builder->CreateInBoundsGEP(vec.cls->type, loadColumn(vec, 0), index, "element");
+            CallInst* call = builder->CreateCall(method, {self});
+            call->setCallingConv(method->getCallingConv());
+            return method->getReturnType()->isVoidTy() ? nullptr : call;
+        }
+
+        AllocaInst* copy = createEntryBlockAlloca(currentFunction, vec.cls->node->value + ".element", vec.cls->type);
+        copy->setAlignment(module->getDataLayout().getABITypeAlign(vec.cls->type));
+        vector<Value*> addresses;
+        for (unsigned k = 0; k < vec.columns(); k++) {
+            addresses.push_back(elementFieldAddress(vec, index, k));
+            copyField(vec.cls->type->getElementType(k), builder->CreateStructGEP(vec.cls->type, copy, k), addresses[k]);
+        }
+
+        CallInst* call = builder->CreateCall(method, {copy});
+        call->setCallingConv(method->getCallingConv());
+
+        for (unsigned k = 0; k < vec.columns(); k++) {
+            copyField(vec.cls->type->getElementType(k), addresses[k], builder->CreateStructGEP(vec.cls->type, copy, k));
+        }
+        return method->getReturnType()->isVoidTy() ? nullptr : call;
+    }
+
+    // ============================================
+    // PROFILE-GUIDED OPTIMIZATION
+    // ============================================
+    // --profile-generate[=file]: every function counts its entries and
+    // every if/while/for condition counts how often it was false and true;
+    // main registers the counters with the runtime (cax_profile.c), which
+    // adds them to the profile file at exit.
+    //
+    // --profile-use=file: the counts become what LLVM's optimizer reads
+    // from a profile: function entry counts, branch weights and the module
+    // profile summary that tells hot from cold. The inliner, block
+    // placement and hot/cold splitting take it from there; on top of that
+    // functions that never ran are marked cold and placed in .text.unlikely,
+    // hot ones get an inline hint and .text.hot, and the module lists
+    // functions hottest first so they end up next to each other.
+    //
+    // Sites are named "<function>:entry" and "<function>:<kind>@<line>.<n>",
+    // so counts from an older version of the source only apply where the
+    // code has not moved; the rest is ignored. The file separates fields
+    // with whitespace and function names are free-form strings, so the
+    // function part is escaped (see profileSiteName).
+
+    struct ProfileSite {
+        string name;
+        GlobalVariable* counts;
+        int edges;
+    };
+    string profileGeneratePath;                  // Non-empty: instrument
+    vector<ProfileSite> profileSites;
+    GlobalVariable* profileTable = nullptr;      // CaxProfile registered by main
+    string profileFunction;                      // Function whose sites are being emitted
+    map<string, int> profileLineSites;           // "<function>:<kind>@<line>" -> sites so far
+
+    bool profileUse = false;                     // --profile-use
+    map<string, vector<uint64_t>> profileCounts;
+    map<string, uint64_t> profileHeat;           // Function -> largest count among its sites
+    int profileSitesMatched = 0;
+    int profileSitesMissing = 0;
+
+    void setProfileGenerate(const string& path) { profileGeneratePath = path; }
+
+    // Reads a profile written by an instrumented build
+    bool loadProfile(const string& path) {
+        ifstream in(path);
+        if (!in.is_open()) {
+            CAX_ERROR(diag::CAT_IRGEN, "Could not open profile: " << path);
+            return false;
+        }
+        string line;
+        int lineNumber = 0;
+        while (getline(in, line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#') continue;
+            stringstream fields(line);
+            string name, field;
+            vector<uint64_t> counts;
+            fields >> name;
+            bool malformed = false;
+            while (fields >> field) {
+                size_t used = 0;
+                try {
+                    counts.push_back(stoull(field, &used));
+                } catch (...) {}
+                if (used != field.size() || !isdigit((unsigned char)field[0])) malformed = true;
+            }
+            if (malformed || counts.empty() || counts.size() > 2) {
+                CAX_WARN(diag::CAT_IRGEN, "Ignoring malformed line " << lineNumber << " of profile " << path
+                         << ": " << line);
+                continue;
+            }
+            profileCounts[name] = counts;
+        }
+        profileUse = true;
+        CAX_INFO(diag::CAT_IRGEN, "Profile: " << profileCounts.size() << " sites read from " << path);
+        return true;
+    }
+
+    bool profiling() const { return !profileGeneratePath.empty() || profileUse; }
+
+    StructType* getProfileType() {
+        StructType* type = StructType::getTypeByName(*context, "cax.profile");
+        if (!type) type = StructType::create(*context, {getInt64Type(), getPtrType(), getPtrType()}, "cax.profile");
+        return type;
+    }
+
+    const vector<uint64_t>* findProfileCounts(const string& site, size_t edges) {
+        auto it = profileCounts.find(site);
+        if (it == profileCounts.end() || it->second.size() != edges) {
+            profileSitesMissing++;
+            return nullptr;
+        }
+        profileSitesMatched++;
+        uint64_t& heat = profileHeat[profileFunction];
+        for (uint64_t count : it->second) heat = max(heat, count);
+        return &it->second;
+    }
+
+    GlobalVariable* addProfileSite(const string& site, int edges) {
+        ArrayType* type = ArrayType::get(getInt64Type(), edges);
+        auto* counts = new GlobalVariable(*module, type, false, GlobalValue::InternalLinkage,
+                                          ConstantAggregateZero::get(type), "prof." + site);
+        profileSites.push_back({site, counts, edges});
+        return counts;
+    }
+
+    // counts[index] += 1; atomically in outlined parallel bodies
+    void emitCounterIncrement(GlobalVariable* counts, Value* index) {
+        Value* counter = builder->CreateInBoundsGEP(counts->getValueType(), counts,
+                                                    {builder->getInt64(0), index}, "prof.counter");
+        if (inParallelBody) {
+            builder->CreateAtomicRMW(AtomicRMWInst::Add, counter, builder->getInt64(1), MaybeAlign(8),
+                                     AtomicOrdering::Monotonic);
+        } else {
+            Value* count = builder->CreateLoad(getInt64Type(), counter, "prof.count");
+            builder->CreateStore(builder->CreateAdd(count, builder->getInt64(1)), counter);
+        }
+    }
+
+    // At the top of a function body: register the counters (main), count
+    // the entry, or set the entry count recorded for it
+    void beginFunctionProfile(Function* func, bool isMain) {
+        profileFunction = func->getName().str();
+        if (!profiling()) return;
+        string site = profileSiteName("entry");
+
+        if (!profileGeneratePath.empty()) {
+            if (isMain) {
+                if (!profileTable) {
+                    profileTable = new GlobalVariable(*module, getProfileType(), false,
+                                                      GlobalValue::InternalLinkage, nullptr, "cax.profile");
+                }
+                Function* registerProfile = getRuntimeFunction("cax_profile_register", getVoidType(), {getPtrType()});
+                builder->CreateCall(registerProfile, {profileTable});
+            }
+            emitCounterIncrement(addProfileSite(site, 1), builder->getInt64(0));
+        }
+        if (profileUse) {
+            if (const vector<uint64_t>* counts = findProfileCounts(site, 1)) {
+                func->setEntryCount((*counts)[0]);
+            }
+        }
+    }
+
+    // "<function>:<what>" as one token of the profile file: bytes of the
+    // function name outside printable ASCII, and the '%', ':' and '#' the
+    // format gives a meaning, are written as %XX
+    string profileSiteName(const string& what) {
+        string name;
+        for (unsigned char c : profileFunction) {
+            if (c > ' ' && c < 0x7f && c != '%' && c != ':' && c != '#') {
+                name += (char)c;
+            } else {
+                static const char hex[] = "0123456789ABCDEF";
+                name += '%';
+                name += hex[c >> 4];
+                name += hex[c & 15];
+            }
+        }
+        return name + ":" + what;
+    }
+
+    // The conditional branch of an if/while/for condition, counted or
+    // weighted by its profile
+    BranchInst* createProfiledCondBr(shared_ptr<ASTNode> node, const string& kind, Value* cond,
+                                     BasicBlock* trueBB, BasicBlock* falseBB) {
+        if (!profiling() || profileFunction.empty()) return builder->CreateCondBr(cond, trueBB, falseBB);
+
+        string line = profileSiteName(kind + "@" + to_string(node->line));
+        string site = line + "." + to_string(profileLineSites[line]++);
+        if (!profileGeneratePath.empty()) {
+            emitCounterIncrement(addProfileSite(site, 2), builder->CreateZExt(cond, getInt64Type()));
+        }
+        BranchInst* branch = builder->CreateCondBr(cond, trueBB, falseBB);
+        if (profileUse) {
+            if (const vector<uint64_t>* counts = findProfileCounts(site, 2)) {
+                // Weights are 32-bit: scale both down by the same factor
+                uint64_t falseCount = (*counts)[0], trueCount = (*counts)[1];
+                uint64_t scale = max(falseCount, trueCount) / UINT32_MAX + 1;
+                branch->setMetadata(LLVMContext::MD_prof, MDBuilder(*context).createBranchWeights(
+                    uint32_t(trueCount / scale), uint32_t(falseCount / scale)));
+            }
+        }
+        return branch;
+    }
+
+    // After all code is generated: fill in the counter table, or apply
+    // the profile to the module as a whole
+    void finishProfile() {
+        if (profileTable) {
+            StructType* siteType = StructType::getTypeByName(*context, "cax.profile.site");
+            if (!siteType) {
+                siteType = StructType::create(*context, {getPtrType(), getPtrType(), getInt64Type()},
+                                              "cax.profile.site");
+            }
+            vector<Constant*> sites;
+            for (auto& site : profileSites) {
+                sites.push_back(ConstantStruct::get(siteType, {createGlobalString(site.name), site.counts,
+                                                               builder->getInt64(site.edges)}));
+            }
+            ArrayType* tableType = ArrayType::get(siteType, sites.size());
+            auto* table = new GlobalVariable(*module, tableType, true, GlobalValue::InternalLinkage,
+                                             ConstantArray::get(tableType, sites), "cax.profile.sites");
+            profileTable->setInitializer(ConstantStruct::get(getProfileType(), {
+                builder->getInt64(sites.size()), table, createGlobalString(profileGeneratePath)}));
+            CAX_INFO(diag::CAT_IRGEN, "Profile instrumentation: " << profileSites.size()
+                     << " counter sites, written to " << profileGeneratePath << " at exit");
+        }
+        if (profileUse) {
+            applyProfileSummary();
+        }
+    }
+
+    // LLVM's detailed summary: for each cutoff (parts per million of all
+    // counts), the smallest count among the hottest counters covering it
+    static vector<ProfileSummaryEntry> detailedSummary(vector<uint64_t> counts, uint64_t total) {
+        static const uint32_t cutoffs[] = {10000, 100000, 200000, 300000, 400000, 500000, 600000, 700000,
+                                           800000, 900000, 950000, 990000, 999000, 999900, 999990, 999999};
+        std::sort(counts.begin(), counts.end(), greater<uint64_t>());
+        vector<ProfileSummaryEntry> entries;
+        size_t used = 0;
+        uint64_t covered = 0;
+        for (uint32_t cutoff : cutoffs) {
+            long double wanted = (long double)total * cutoff / ProfileSummary::Scale;
+            while (used < counts.size() && covered < wanted) covered += counts[used++];
+            entries.push_back({cutoff, used ? counts[used - 1] : 0, used});
+        }
+        return entries;
+    }
+
+    void applyProfileSummary() {
+        vector<uint64_t> counts;
+        uint64_t total = 0, maxCount = 0, maxInternal = 0, maxFunction = 0;
+        vector<Function*> defined;
+        for (Function& func : *module) {
+            if (func.isDeclaration()) continue;
+            defined.push_back(&func);
+            auto entry = func.getEntryCount();
+            if (entry) maxFunction = max(maxFunction, entry->getCount());
+        }
+        for (auto& entry : profileCounts) {
+            bool isEntry = entry.first.size() > 6 && entry.first.compare(entry.first.size() - 6, 6, ":entry") == 0;
+            for (uint64_t count : entry.second) {
+                counts.push_back(count);
+                total += count;
+                maxCount = max(maxCount, count);
+                if (!isEntry) maxInternal = max(maxInternal, count);
+            }
+        }
+        if (counts.empty() || total == 0) {
+            CAX_WARN(diag::CAT_IRGEN, "Profile has no counts; ignoring it");
+            return;
+        }
+
+        vector<ProfileSummaryEntry> summary = detailedSummary(counts, total);
+        ProfileSummary profileSummary(ProfileSummary::PSK_Instr, summary, total, maxCount, maxInternal,
+                                      maxFunction, counts.size(), defined.size());
+        module->setProfileSummary(profileSummary.getMD(*context), ProfileSummary::PSK_Instr);
+
+        // Hot: a site of the function ran at least as often as the smallest
+        // count among those covering 99% of the total (LLVM's hot cutoff)
+        uint64_t hotCount = 0;
+        for (auto& entry : summary) {
+            if (entry.Cutoff == 990000) hotCount = max<uint64_t>(entry.MinCount, 1);
+        }
+        int hot = 0, cold = 0;
+        for (Function* func : defined) {
+            auto entry = func->getEntryCount();
+            if (!entry) continue;
+            if (entry->getCount() == 0) {
+                func->addFnAttr(Attribute::Cold);
+                func->addFnAttr(Attribute::OptimizeForSize);
+                func->setSectionPrefix("unlikely");
+                cold++;
+            } else if (profileHeat[func->getName().str()] >= hotCount) {
+                if (!func->hasFnAttribute(Attribute::NoInline)) func->addFnAttr(Attribute::InlineHint);
+                func->setSectionPrefix("hot");
+                hot++;
+            }
+        }
+
+        // Function order: executed functions hottest first, then the ones
+        // the profile does not cover, then the ones that never ran
+        auto rank = [&](Function* func) {
+            auto entry = func->getEntryCount();
+            if (!entry) return make_pair(1, uint64_t(0));
+            if (entry->getCount() == 0) return make_pair(2, uint64_t(0));
+            return make_pair(0, UINT64_MAX - profileHeat[func->getName().str()]);
+        };
+        stable_sort(defined.begin(), defined.end(), [&](Function* a, Function* b) { return rank(a) < rank(b); });
+        for (Function* func : defined) {
+            func->removeFromParent();
+            module->getFunctionList().push_back(func);
+        }
+
+        CAX_INFO(diag::CAT_IRGEN, "Profile: " << profileSitesMatched << " sites matched, " << profileSitesMissing
+                 << " without counts; " << hot << " hot and " << cold << " cold functions");
+    }
+
+    // ============================================
+    // INSTRUMENTATION
+    // ============================================
+    // --instrument=functions: each function calls cax_func_enter(id) on
+    // entry and cax_func_exit(id) before every return, id indexing the
+    // table of functions that main registers with the runtime
+    // (cax_instrument.c). The runtime keeps call counts and inclusive /
+    // exclusive times per thread and reports them at exit. The calls stay
+    // in place through inlining, so times are per source function.
+    //
+    // --instrument=loops,branches: every while/for loop and if statement
+    // gets a counter block of its own, listed with its function and line
+    // in a second table main registers. A loop counts its iterations in a
+    // stack slot and passes the count to cax_loop_exit where it is left
+    // (runs left by a return are not counted); a parallel loop reports
+    // its whole iteration space at once. An if adds to its taken
+    // or not-taken counter inline, atomically in parallel loop bodies.
+
+    bool instrumentFunctions = false;
+    vector<pair<string, int>> instrumentedFunctions;   // Name, line; index = id
+    GlobalVariable* functionTable = nullptr;           // CaxFunctionTable registered by main
+    int currentFunctionId = -1;
+
+    struct InstrumentedSite {
+        string function;
+        int line;
+        int kind;                                      // SITE_LOOP / SITE_BRANCH
+        GlobalVariable* counts;
+    };
+    static constexpr int SITE_LOOP = 0;                // CAX_SITE_LOOP / CAX_SITE_BRANCH
+    static constexpr int SITE_BRANCH = 1;
+    bool instrumentLoops = false;
+    bool instrumentBranches = false;
+    vector<InstrumentedSite> instrumentedSites;
+    GlobalVariable* siteTable = nullptr;               // CaxSiteTable registered by main
+
+    // Iteration count of the loop being generated
+    struct LoopTrips {
+        GlobalVariable* counts = nullptr;
+        AllocaInst* trips = nullptr;
+    };
+
+    // --instrument=<kind>,<kind>...; false for an unknown kind
+    bool setInstrumentation(const string& kinds) {
+        stringstream list(kinds);
+        string kind;
+        while (getline(list, kind, ',')) {
+            if (kind == "functions") {
+                instrumentFunctions = true;
+            } else if (kind == "loops") {
+                instrumentLoops = true;
+            } else if (kind == "branches") {
+                instrumentBranches = true;
+            } else {
+                CAX_ERROR(diag::CAT_IRGEN, "Unknown --instrument kind '" << kind
+                          << "' (expected functions, loops or branches)");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // {count, entries}: CaxFunctionTable and CaxSiteTable
+    StructType* getInstrumentTableType() {
+        StructType* type = StructType::getTypeByName(*context, "cax.instrtable");
+        if (!type) type = StructType::create(*context, {getInt64Type(), getPtrType()}, "cax.instrtable");
+        return type;
+    }
+
+    void beginFunctionInstrumentation(Function* func, shared_ptr<ASTNode> node, bool isMain) {
+        currentFunctionId = -1;
+        if (isMain && (instrumentLoops || instrumentBranches)) {
+            if (!siteTable) {
+                siteTable = new GlobalVariable(*module, getInstrumentTableType(), false,
+                                               GlobalValue::InternalLinkage, nullptr, "cax.sitetable");
+            }
+            Function* registerSites = getRuntimeFunction("cax_instrument_sites", getVoidType(), {getPtrType()});
+            builder->CreateCall(registerSites, {siteTable});
+        }
+        if (!instrumentFunctions) return;
+
+        if (isMain) {
+            if (!functionTable) {
+                functionTable = new GlobalVariable(*module, getInstrumentTableType(), false,
+                                                   GlobalValue::InternalLinkage, nullptr, "cax.functable");
+            }
+            Function* registerTable = getRuntimeFunction("cax_instrument_functions", getVoidType(), {getPtrType()});
+            builder->CreateCall(registerTable, {functionTable});
+        }
+        currentFunctionId = instrumentedFunctions.size();
+        instrumentedFunctions.push_back({func->getName().str(), node->line});
+        Function* enter = getRuntimeFunction("cax_func_enter", getVoidType(), {getInt32Type()});
+        builder->CreateCall(enter, {builder->getInt32(currentFunctionId)});
+    }
+
+    // Before a return of the current function (not of an outlined loop body)
+    void emitFunctionExit() {
+        if (currentFunctionId < 0 || inParallelBody) return;
+        Function* exit = getRuntimeFunction("cax_func_exit", getVoidType(), {getInt32Type()});
+        builder->CreateCall(exit, {builder->getInt32(currentFunctionId)});
+    }
+
+    GlobalVariable* addInstrumentedSite(shared_ptr<ASTNode> node, int kind) {
+        ArrayType* type = ArrayType::get(getInt64Type(), kind == SITE_LOOP ? 4 : 2);
+        Constant* init = ConstantAggregateZero::get(type);
+        if (kind == SITE_LOOP) {
+            Constant* zero = builder->getInt64(0);
+            init = ConstantArray::get(type, {zero, zero, builder->getInt64(INT64_MAX), zero});
+        }
+        auto* counts = new GlobalVariable(*module, type, false, GlobalValue::InternalLinkage, init,
+                                          (kind == SITE_LOOP ? "loop." : "branch.") + profileFunction
+                                          + "." + to_string(node->line));
+        instrumentedSites.push_back({profileFunction, node->line, kind, counts});
+        return counts;
+    }
+
+    // if: taken / not-taken counts
+    void countBranch(shared_ptr<ASTNode> node, Value* cond) {
+        if (!instrumentBranches || profileFunction.empty()) return;
+        emitCounterIncrement(addInstrumentedSite(node, SITE_BRANCH), builder->CreateZExt(cond, getInt64Type()));
+    }
+
+    // Before the branch into a loop's header: trips = 0
+    LoopTrips beginLoopTrips(shared_ptr<ASTNode> node) {
+        LoopTrips loop;
+        if (!instrumentLoops || profileFunction.empty()) return loop;
+        loop.counts = addInstrumentedSite(node, SITE_LOOP);
+        loop.trips = createEntryBlockAlloca(currentFunction, "trips", getInt64Type());
+        builder->CreateStore(builder->getInt64(0), loop.trips);
+        return loop;
+    }
+
+    // At the top of the loop body
+    void countLoopTrip(const LoopTrips& loop) {
+        if (!loop.trips) return;
+        Value* trips = builder->CreateLoad(getInt64Type(), loop.trips, "trips");
+        builder->CreateStore(builder->CreateAdd(trips, builder->getInt64(1)), loop.trips);
+    }
+
+    // At the top of the block after the loop
+    void endLoopTrips(const LoopTrips& loop) {
+        if (!loop.trips) return;
+        emitLoopExit(loop.counts, builder->CreateLoad(getInt64Type(), loop.trips, "trips"));
+    }
+
+    void emitLoopExit(GlobalVariable* counts, Value* trips) {
+        Function* loopExit = getRuntimeFunction("cax_loop_exit", getVoidType(), {getPtrType(), getInt64Type()});
+        builder->CreateCall(loopExit, {counts, trips});
+    }
+
+    // A loop run by the parallel-for runtime: end - begin iterations
+    void countParallelTrips(shared_ptr<ASTNode> node, Value* begin, Value* end) {
+        if (!instrumentLoops || profileFunction.empty()) return;
+        Value* trips = builder->CreateSub(end, begin, "trips");
+        trips = builder->CreateSelect(builder->CreateICmpSGT(trips, builder->getInt64(0)), trips,
+                                      builder->getInt64(0), "trips");
+        emitLoopExit(addInstrumentedSite(node, SITE_LOOP), trips);
+    }
+
+    void finishInstrumentation() {
+        if (siteTable) {
+            // Listed in source order
+            stable_sort(instrumentedSites.begin(), instrumentedSites.end(),
+                        [](const InstrumentedSite& a, const InstrumentedSite& b) { return a.line < b.line; });
+            StructType* siteType = StructType::getTypeByName(*context, "cax.siteinfo");
+            if (!siteType) {
+                siteType = StructType::create(*context, {getPtrType(), getInt64Type(), getInt64Type(), getPtrType()},
+                                              "cax.siteinfo");
+            }
+            vector<Constant*> sites;
+            for (auto& site : instrumentedSites) {
+                sites.push_back(ConstantStruct::get(siteType, {createGlobalString(site.function),
+                                                               builder->getInt64(site.line),
+                                                               builder->getInt64(site.kind), site.counts}));
             }
+            ArrayType* sitesType = ArrayType::get(siteType, sites.size());
+            auto* sitesTable = new GlobalVariable(*module, sitesType, true, GlobalValue::InternalLinkage,
+                                                  ConstantArray::get(sitesType, sites), "cax.siteinfo");
+            siteTable->setInitializer(ConstantStruct::get(getInstrumentTableType(), {
+                builder->getInt64(sites.size()), sitesTable}));
+            CAX_INFO(diag::CAT_IRGEN, "Instrumentation: " << sites.size() << " loops and branches counted");
         }
-
-        // Fallback: return 0
-        return ConstantInt::get(*context, APInt(32, 0, true));
+        if (!functionTable) return;
+        StructType* entryType = StructType::getTypeByName(*context, "cax.funcinfo");
+        if (!entryType) entryType = StructType::create(*context, {getPtrType(), getInt64Type()}, "cax.funcinfo");
+        vector<Constant*> entries;
+        for (auto& [name, line] : instrumentedFunctions) {
+            entries.push_back(ConstantStruct::get(entryType, {createGlobalString(name), builder->getInt64(line)}));
+        }
+        ArrayType* entriesType = ArrayType::get(entryType, entries.size());
+        auto* entriesTable = new GlobalVariable(*module, entriesType, true, GlobalValue::InternalLinkage,
+                                                ConstantArray::get(entriesType, entries), "cax.funcinfo");
+        functionTable->setInitializer(ConstantStruct::get(getInstrumentTableType(), {
+            builder->getInt64(entries.size()), entriesTable}));
+        CAX_INFO(diag::CAT_IRGEN, "Instrumentation: " << entries.size() << " functions count calls and time");
     }
 
     // ============================================
@@ -1023,13 +5055,13 @@ public:
         raw_fd_ostream outFile(filename, ec);
 
         if (ec) {
-            cerr << "Error opening file: " << ec.message() << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Error opening file: " << ec.message());
             return;
         }
 
         module->print(outFile, nullptr);
         outFile.close();
-        cout << "IR written to: " << filename << endl;
+        CAX_INFO(diag::CAT_IRGEN, "IR written to: " << filename);
     }
 
     bool verify() {
@@ -1037,11 +5069,11 @@ public:
         raw_string_ostream errorStream(errorMsg);
 
         if (verifyModule(*module, &errorStream)) {
-            cerr << "Module verification failed:\n" << errorStream.str() << endl;
+            CAX_ERROR(diag::CAT_IRGEN, "Module verification failed:\n" << errorStream.str());
             return false;
         }
 
-        cout << "Module verification passed!" << endl;
+        CAX_INFO(diag::CAT_IRGEN, "Module verification passed!");
         return true;
     }
 };
@@ -1338,12 +5370,20 @@ private:
         return advance();
     }
 
+    static bool isCompoundAssign(TokenType type) {
+        return type == TokenType::PLUS_EQ || type == TokenType::MINUS_EQ ||
+               type == TokenType::MULT_EQ || type == TokenType::DIV_EQ;
+    }
+
     shared_ptr<ASTNode> parseProgram();
+    shared_ptr<ASTNode> parseExec();
     shared_ptr<ASTNode> parseFunction();
+    shared_ptr<ASTNode> parseClass();
     shared_ptr<ASTNode> parseBlock();
     shared_ptr<ASTNode> parseStatement();
     shared_ptr<ASTNode> parseAssignment();
     shared_ptr<ASTNode> parseFor();
+    void parseLoopAnnotations(shared_ptr<ASTNode> loop);
     shared_ptr<ASTNode> parseWhile();
     shared_ptr<ASTNode> parseIf();
     shared_ptr<ASTNode> parseReturn();
@@ -1386,56 +5426,113 @@ shared_ptr<ASTNode> Parser::parseProgram() {
                 advance(); // skip string
             }
         } else if (match(TokenType::EXEC)) {
-            // Skip exec for now
-            advance(); // (
-            while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
-                advance();
-            }
-            advance(); // )
+            program->addChild(parseExec());
         } else if (peek().type == TokenType::FUNC) {
             program->addChild(parseFunction());
         } else if (peek().type == TokenType::CLASS) {
-            // Skip a single class definition for now
+            program->addChild(parseClass());
+        } else {
+            advance();
+        }
+    }
+
+    return program;
+}
+
+// class(Annotations) = "Name" { object: fields  member: functions }, shaped
+// like parser.cpp: CLASS_DECL -> [OBJECT_SECTION (IDENTIFIER per field),
+// MEMBER_SECTION (FUNCTION_DECL per method)]
+shared_ptr<ASTNode> Parser::parseClass() {
+    Token classToken = expect(TokenType::CLASS, "Expected 'class'");
+    expect(TokenType::LPAREN, "Expected '(' after class");
+
+    string classType = "";
+    string annotations = "";
+    if (peek().type == TokenType::IDENTIFIER) {
+        classType = advance().value;
+        annotations = classType;
+        while (match(TokenType::COMMA)) {
+            annotations += "," + expect(TokenType::IDENTIFIER, "Expected class annotation").value;
+        }
+    }
+
+    expect(TokenType::RPAREN, "Expected ')' after class type");
+    expect(TokenType::ASSIGN, "Expected '=' after class()");
+
+    Token nameToken = expect(TokenType::STRING, "Expected class name");
+    auto node = make_shared<ASTNode>(NodeType::CLASS_DECL, nameToken.value, classToken.line);
+    if (!classType.empty()) {
+        node->setAttribute("type", classType);
+        node->setAttribute("annotations", annotations);
+    }
+
+    expect(TokenType::LBRACE, "Expected '{' after class declaration");
 
-            advance(); // consume 'class'
+    if (match(TokenType::OBJECT)) {
+        expect(TokenType::COLON, "Expected ':' after object");
+        auto objSection = make_shared<ASTNode>(NodeType::OBJECT_SECTION, "object");
+        while (peek().type == TokenType::IDENTIFIER) {
+            Token field = advance();
+            objSection->addChild(make_shared<ASTNode>(NodeType::IDENTIFIER, field.value, field.line));
+        }
+        node->addChild(objSection);
+    }
 
-            // Skip until we hit the opening '{' of the class body
-            while (peek().type != TokenType::LBRACE &&
-                   peek().type != TokenType::END_OF_FILE) {
+    if (match(TokenType::MEMBER)) {
+        expect(TokenType::COLON, "Expected ':' after member");
+        auto memSection = make_shared<ASTNode>(NodeType::MEMBER_SECTION, "member");
+        while (peek().type != TokenType::RBRACE && peek().type != TokenType::END_OF_FILE) {
+            if (peek().type == TokenType::FUNC) {
+                memSection->addChild(parseFunction());
+            } else {
                 advance();
-                   }
-
-            // Now skip the entire '{ ... }' block, including nested braces
-            if (peek().type == TokenType::LBRACE) {
-                int depth = 1;
-                advance(); // consume '{'
-
-                while (depth > 0 && peek().type != TokenType::END_OF_FILE) {
-                    if (peek().type == TokenType::LBRACE) {
-                        depth++;
-                    } else if (peek().type == TokenType::RBRACE) {
-                        depth--;
-                    }
-                    advance();
-                }
             }
+        }
+        node->addChild(memSection);
+    }
+
+    expect(TokenType::RBRACE, "Expected '}' after class body");
+    return node;
+}
 
-            // Done skipping ONE class; control returns to the main while loop.
+// exec(name=value, ..., fraction): named parameters become ASSIGNMENT
+// children, positional values plain expressions (same shape as parser.cpp)
+shared_ptr<ASTNode> Parser::parseExec() {
+    Token execToken = tokens[current - 1];
+    expect(TokenType::LPAREN, "Expected '(' after exec");
+
+    auto node = make_shared<ASTNode>(NodeType::EXEC_STMT, "exec", execToken.line);
+    while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
+        if (peek().type == TokenType::IDENTIFIER && peek(1).type == TokenType::ASSIGN) {
+            Token param = advance();
+            advance(); // =
+            auto paramNode = make_shared<ASTNode>(NodeType::ASSIGNMENT, param.value, param.line);
+            paramNode->addChild(parseExpression());
+            node->addChild(paramNode);
         } else {
-            advance();
+            size_t before = current;
+            node->addChild(parseExpression());
+            if (current == before) advance();
         }
+        if (!match(TokenType::COMMA)) break;
     }
-
-    return program;
+    expect(TokenType::RPAREN, "Expected ')' after exec parameters");
+    return node;
 }
 
 shared_ptr<ASTNode> Parser::parseFunction() {
     Token funcToken = expect(TokenType::FUNC, "Expected 'func'");
     expect(TokenType::LPAREN, "Expected '(' after func");
 
+    // func(Type) or a list of annotations: func(Export, NoInline)
     string funcType = "";
+    string annotations = "";
     if (peek().type == TokenType::IDENTIFIER) {
         funcType = advance().value;
+        annotations = funcType;
+        while (match(TokenType::COMMA)) {
+            annotations += "," + expect(TokenType::IDENTIFIER, "Expected function annotation").value;
+        }
     }
 
     expect(TokenType::RPAREN, "Expected ')' after func type");
@@ -1465,6 +5562,7 @@ shared_ptr<ASTNode> Parser::parseFunction() {
     );
     if (!funcType.empty()) {
         node->setAttribute("type", funcType);
+        node->setAttribute("annotations", annotations);
     }
 
     auto body = parseBlock();
@@ -1502,19 +5600,62 @@ shared_ptr<ASTNode> Parser::parseStatement() {
     } else if (peek().type == TokenType::VECTOR) {
         return parseVectorDecl();
     } else if (peek().type == TokenType::IDENTIFIER) {
-        if (peek(1).type == TokenType::ASSIGN) {
+        TokenType nextType = peek(1).type;
+        if (nextType == TokenType::ASSIGN || isCompoundAssign(nextType)) {
             return parseAssignment();
         }
+        if (nextType == TokenType::LBRACKET) {
+            // Indexed assignment like arr[0] = 5 or m[i][j] = 5: scan past
+            // each [...] group
+            size_t saved = current;
+            advance(); // identifier
+            while (peek().type == TokenType::LBRACKET) {
+                advance(); // [
+                int bracketDepth = 1;
+                while (bracketDepth > 0 && peek().type != TokenType::END_OF_FILE) {
+                    if (peek().type == TokenType::LBRACKET) bracketDepth++;
+                    else if (peek().type == TokenType::RBRACKET) bracketDepth--;
+                    advance();
+                }
+            }
+            TokenType afterBracket = peek().type;
+            // c[i].field = value
+            bool memberAssign = afterBracket == TokenType::DOT && peek(1).type == TokenType::IDENTIFIER &&
+                                (peek(2).type == TokenType::ASSIGN || isCompoundAssign(peek(2).type));
+            current = saved;
+
+            if (afterBracket == TokenType::ASSIGN || isCompoundAssign(afterBracket) || memberAssign) {
+                return parseAssignment();
+            }
+        }
         return parseExpression();
     }
 
     return parseExpression();
 }
 
+// Produces ASSIGNMENT nodes shaped like parser.cpp: children are [value] or,
+// for indexed targets, one index per dimension followed by the value
+// ([index, value], [row, column, value], ...); compound forms set "operator".
+// c[i].field = value adds a "member" attribute naming the field.
 shared_ptr<ASTNode> Parser::parseAssignment() {
     Token var = expect(TokenType::IDENTIFIER, "Expected identifier");
-    expect(TokenType::ASSIGN, "Expected '='");
-    auto node = make_shared<ASTNode>(NodeType::ASSIGNMENT, var.value);
+    auto node = make_shared<ASTNode>(NodeType::ASSIGNMENT, var.value, var.line);
+
+    while (match(TokenType::LBRACKET)) {
+        node->addChild(parseExpression());
+        expect(TokenType::RBRACKET, "Expected ']'");
+    }
+    if (!node->children.empty() && match(TokenType::DOT)) {
+        node->setAttribute("member", expect(TokenType::IDENTIFIER, "Expected field name").value);
+    }
+
+    if (isCompoundAssign(peek().type)) {
+        node->setAttribute("operator", advance().value);
+    } else {
+        expect(TokenType::ASSIGN, "Expected '='");
+    }
+
     node->addChild(parseExpression());
     return node;
 }
@@ -1530,10 +5671,11 @@ shared_ptr<ASTNode> Parser::parseFor() {
         Token var = advance();
         expect(TokenType::IN, "Expected 'in'");
 
-        auto rangeNode = make_shared<ASTNode>(NodeType::RANGE_FOR, var.value);
+        auto rangeNode = make_shared<ASTNode>(NodeType::RANGE_FOR, var.value, var.line);
         rangeNode->addChild(parseExpression());
         node->addChild(rangeNode);
 
+        parseLoopAnnotations(node);
         expect(TokenType::RPAREN, "Expected ')' after for");
         node->addChild(parseBlock());
         return node;
@@ -1551,12 +5693,29 @@ shared_ptr<ASTNode> Parser::parseFor() {
     node->addChild(parseExpression()); // condition
     expect(TokenType::COMMA, "Expected ',' in for");
     node->addChild(parseExpression()); // increment
+    parseLoopAnnotations(node);
     expect(TokenType::RPAREN, "Expected ')' after for");
 
     node->addChild(parseBlock());
     return node;
 }
 
+// Optional trailing `, unroll=N, vectorize=N` in a for header, kept as
+// attributes of the FOR_STMT
+void Parser::parseLoopAnnotations(shared_ptr<ASTNode> loop) {
+    while (match(TokenType::COMMA)) {
+        Token name = expect(TokenType::IDENTIFIER, "Expected loop annotation (unroll=N or vectorize=N)");
+        expect(TokenType::ASSIGN, "Expected '=' after loop annotation");
+        Token value = expect(TokenType::INTEGER, "Expected an integer loop annotation value");
+        if (name.value != "unroll" && name.value != "vectorize") {
+            errors.push_back("Line " + to_string(name.line) + ": Unknown loop annotation '" + name.value +
+                             "' (expected unroll or vectorize)");
+        } else {
+            loop->setAttribute(name.value, value.value);
+        }
+    }
+}
+
 shared_ptr<ASTNode> Parser::parseWhile() {
     Token whileToken = expect(TokenType::WHILE, "Expected 'while'");
     expect(TokenType::LPAREN, "Expected '('");
@@ -1600,14 +5759,22 @@ shared_ptr<ASTNode> Parser::parsePrint() {
     return node;
 }
 
+// vector<T> name, or vector<soa Name> for a structure-of-arrays vector of
+// class instances ("layout" attribute)
 shared_ptr<ASTNode> Parser::parseVectorDecl() {
     expect(TokenType::VECTOR, "Expected 'vector'");
     expect(TokenType::LT, "Expected '<'");
     Token type = expect(TokenType::IDENTIFIER, "Expected type");
+    bool soa = false;
+    if (type.value == "soa" && peek().type == TokenType::IDENTIFIER) {
+        soa = true;
+        type = advance();
+    }
     expect(TokenType::GT, "Expected '>'");
     Token name = expect(TokenType::IDENTIFIER, "Expected identifier");
-    auto node = make_shared<ASTNode>(NodeType::VECTOR_DECL, name.value);
+    auto node = make_shared<ASTNode>(NodeType::VECTOR_DECL, name.value, name.line);
     node->setAttribute("elementType", type.value);
+    if (soa) node->setAttribute("layout", "soa");
     return node;
 }
 
@@ -1714,7 +5881,7 @@ shared_ptr<ASTNode> Parser::parsePostfix() {
             if (peek().type == TokenType::LPAREN) {
                 // Method call
                 advance(); // (
-                auto callNode = make_shared<ASTNode>(NodeType::FUNCTION_CALL, member.value);
+                auto callNode = make_shared<ASTNode>(NodeType::FUNCTION_CALL, member.value, member.line);
                 callNode->addChild(expr); // Add object as first child
 
                 while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
@@ -1726,7 +5893,7 @@ shared_ptr<ASTNode> Parser::parsePostfix() {
                 expr = callNode;
             } else {
                 // Member access
-                auto node = make_shared<ASTNode>(NodeType::MEMBER_ACCESS, member.value);
+                auto node = make_shared<ASTNode>(NodeType::MEMBER_ACCESS, member.value, member.line);
                 node->addChild(expr);
                 expr = node;
             }
@@ -1740,7 +5907,7 @@ shared_ptr<ASTNode> Parser::parsePostfix() {
         } else if (peek().type == TokenType::LPAREN && expr->type == NodeType::IDENTIFIER) {
             // Function call
             advance(); // (
-            auto node = make_shared<ASTNode>(NodeType::FUNCTION_CALL, expr->value);
+            auto node = make_shared<ASTNode>(NodeType::FUNCTION_CALL, expr->value, expr->line);
 
             while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
                 node->addChild(parseExpression());
@@ -1770,9 +5937,10 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
         return make_shared<ASTNode>(NodeType::IDENTIFIER, id.value, id.line);
     }
 
-    if (match(TokenType::LBRACKET)) {
+    if (peek().type == TokenType::LBRACKET) {
         // Array literal
-        auto node = make_shared<ASTNode>(NodeType::ARRAY_LITERAL, "array");
+        Token open = advance();
+        auto node = make_shared<ASTNode>(NodeType::ARRAY_LITERAL, "array", open.line);
 
         while (peek().type != TokenType::RBRACKET && peek().type != TokenType::END_OF_FILE) {
             node->addChild(parseExpression());
@@ -1810,6 +5978,692 @@ shared_ptr<ASTNode> Parser::parsePrimary() {
     return make_shared<ASTNode>(NodeType::LITERAL, "0");
 }
 
+// ============================================
+// AST OPTIMIZATION PASSES
+// ============================================
+// Source-level rewrites run between parsing and IR generation, so the
+// generator (and LLVM after it) never sees work that is already decided
+// at compile time. The AST carries no types: every rewrite must leave the
+// type the generator would infer for the expression unchanged, which is
+// why the literal rules below mirror generateLiteralConstant and
+// joinStatic exactly.
+//
+// The pass manager runs the pipeline until nothing changes (folding can
+// expose a dead branch, simplification can expose another fold) and
+// keeps per-pass change counts and wall time for the -v report.
+
+class ASTPass {
+public:
+    virtual ~ASTPass() = default;
+    virtual const char* name() const = 0;
+    // Rewrites the program in place; returns the number of rewrites
+    virtual int run(shared_ptr<ASTNode> program) = 0;
+
+protected:
+    // A literal's value as the IR generator types it: i1, i32 (or i64 when
+    // it does not fit) and double. Strings, chars and null are opaque.
+    struct Constant {
+        enum Kind { None, Bool, Int32, Int64, Double } kind = None;
+        int64_t i = 0;
+        double d = 0;
+
+        bool isInt() const { return kind == Int32 || kind == Int64; }
+        bool isNumeric() const { return isInt() || kind == Double; }
+        double asDouble() const { return kind == Double ? d : (double)i; }
+        bool truthy() const { return kind == Double ? d != 0.0 : i != 0; }
+    };
+
+    static Constant literalConstant(const ASTNode& node) {
+        Constant c;
+        if (node.type != NodeType::LITERAL || node.value.empty()) return c;
+        const string& text = node.value;
+        if (text == "true" || text == "false") {
+            c.kind = Constant::Bool;
+            c.i = text == "true";
+            return c;
+        }
+        if (!isdigit((unsigned char)text[0]) && !(text.size() > 1 && text[0] == '-')) return c;
+
+        size_t used = 0;
+        try {
+            if (text.find('.') != string::npos) {
+                double value = stod(text, &used);
+                if (used == text.size()) {
+                    c.kind = Constant::Double;
+                    c.d = value;
+                }
+            } else {
+                long long value = stoll(text, &used);
+                if (used == text.size()) {
+                    c.kind = value >= INT32_MIN && value <= INT32_MAX ? Constant::Int32 : Constant::Int64;
+                    c.i = value;
+                }
+            }
+        } catch (...) {
+            c.kind = Constant::None;
+        }
+        return c;
+    }
+
+    // Literal text for `c`, or "" when no literal reads back as exactly
+    // this value and type
+    static string literalText(const Constant& c) {
+        string text;
+        if (c.kind == Constant::Bool) {
+            return c.i ? "true" : "false";
+        } else if (c.isInt()) {
+            text = to_string(c.i);
+        } else if (c.kind == Constant::Double) {
+            if (!std::isfinite(c.d)) return "";
+            char buffer[40];
+            snprintf(buffer, sizeof(buffer), "%.17g", c.d);
+            text = buffer;
+            size_t exponent = text.find('e');
+            if (text.find('.') == string::npos) {
+                text.insert(exponent == string::npos ? text.size() : exponent, ".0");
+            }
+        } else {
+            return "";
+        }
+
+        ASTNode check(NodeType::LITERAL, text);
+        Constant back = literalConstant(check);
+        if (back.kind != c.kind) return "";
+        if (c.kind == Constant::Double && memcmp(&back.d, &c.d, sizeof(double)) != 0) return "";
+        return text;
+    }
+
+    // Expressions whose evaluation changes nothing (no calls, no ++/--)
+    static bool isPure(const ASTNode& node) {
+        if (node.type == NodeType::FUNCTION_CALL) return false;
+        if (node.type == NodeType::UNARY_OP && node.value != "-" && node.value != "!") return false;
+        for (auto& child : node.children) {
+            if (!isPure(*child)) return false;
+        }
+        return true;
+    }
+
+    // Every function and method body of the program
+    static vector<shared_ptr<ASTNode>> functionBodies(shared_ptr<ASTNode> program) {
+        vector<shared_ptr<ASTNode>> bodies;
+        for (auto& decl : program->children) {
+            if (decl->type == NodeType::FUNCTION_DECL) {
+                bodies.push_back(decl);
+            } else if (decl->type == NodeType::CLASS_DECL) {
+                for (auto& section : decl->children) {
+                    if (section->type != NodeType::MEMBER_SECTION) continue;
+                    for (auto& method : section->children) bodies.push_back(method);
+                }
+            }
+        }
+        return bodies;
+    }
+
+    // Calls `rewrite` on every expression slot below `node`, children
+    // first, replacing the slot with its result
+    static void rewriteExpressions(shared_ptr<ASTNode>& node,
+                                   const function<shared_ptr<ASTNode>(shared_ptr<ASTNode>)>& rewrite) {
+        for (auto& child : node->children) rewriteExpressions(child, rewrite);
+        node = rewrite(node);
+    }
+};
+
+// ((10 + 5) * 2) - 3  =>  27, 1 < 2 => true, -(4) => -4
+class ConstantFoldPass : public ASTPass {
+public:
+    const char* name() const override { return "constant-fold"; }
+
+    int run(shared_ptr<ASTNode> program) override {
+        int changes = 0;
+        rewriteExpressions(program, [&](shared_ptr<ASTNode> node) {
+            shared_ptr<ASTNode> folded = fold(node);
+            if (folded != node) changes++;
+            return folded;
+        });
+        return changes;
+    }
+
+private:
+    shared_ptr<ASTNode> fold(shared_ptr<ASTNode> node) {
+        Constant result;
+        if (node->type == NodeType::BINARY_OP && node->children.size() == 2) {
+            result = foldBinary(node->value, literalConstant(*node->children[0]),
+                                literalConstant(*node->children[1]));
+        } else if (node->type == NodeType::UNARY_OP && node->children.size() == 1) {
+            result = foldUnary(node->value, literalConstant(*node->children[0]));
+        }
+        if (result.kind == Constant::None) return node;
+
+        string text = literalText(result);
+        if (text.empty()) return node;
+        return make_shared<ASTNode>(NodeType::LITERAL, text, node->line);
+    }
+
+    static Constant makeBool(bool value) {
+        Constant c;
+        c.kind = Constant::Bool;
+        c.i = value;
+        return c;
+    }
+
+    static Constant foldUnary(const string& op, Constant a) {
+        Constant none;
+        if (op == "!" && (a.kind == Constant::Bool || a.isNumeric())) return makeBool(!a.truthy());
+        if (op != "-" || !a.isNumeric()) return none;
+        if (a.kind == Constant::Double) {
+            a.d = -a.d;
+            return a;
+        }
+        // Negating the most negative value wraps in the IR; leave it alone
+        if (a.i == INT64_MIN) return none;
+        a.i = -a.i;
+        return a.kind == Constant::Int32 && (a.i < INT32_MIN || a.i > INT32_MAX) ? none : a;
+    }
+
+    static Constant foldBinary(const string& op, Constant a, Constant b) {
+        Constant none;
+        if (op == "&&" || op == "||") {
+            bool valid = (a.kind == Constant::Bool || a.isNumeric()) && (b.kind == Constant::Bool || b.isNumeric());
+            if (!valid) return none;
+            return makeBool(op == "&&" ? a.truthy() && b.truthy() : a.truthy() || b.truthy());
+        }
+        if (a.kind == Constant::Bool && b.kind == Constant::Bool) {
+            if (op == "==") return makeBool(a.i == b.i);
+            if (op == "!=") return makeBool(a.i != b.i);
+            return none;
+        }
+        if (!a.isNumeric() || !b.isNumeric()) return none;
+
+        // Both operands are converted to their common type first
+        if (a.kind == Constant::Double || b.kind == Constant::Double) {
+            double x = a.asDouble();
+            double y = b.asDouble();
+            if (op == "<") return makeBool(x < y);
+            if (op == ">") return makeBool(x > y);
+            if (op == "<=") return makeBool(x <= y);
+            if (op == ">=") return makeBool(x >= y);
+            if (op == "==") return makeBool(x == y);
+            if (op == "!=") return makeBool(x != y);
+
+            Constant c;
+            c.kind = Constant::Double;
+            if (op == "+") c.d = x + y;
+            else if (op == "-") c.d = x - y;
+            else if (op == "*") c.d = x * y;
+            else if (op == "/") c.d = x / y;
+            else if (op == "%") c.d = fmod(x, y);
+            else return none;
+            return c;
+        }
+
+        int64_t x = a.i;
+        int64_t y = b.i;
+        if (op == "<") return makeBool(x < y);
+        if (op == ">") return makeBool(x > y);
+        if (op == "<=") return makeBool(x <= y);
+        if (op == ">=") return makeBool(x >= y);
+        if (op == "==") return makeBool(x == y);
+        if (op == "!=") return makeBool(x != y);
+
+        // Results that would wrap, trap or change width stay at run time
+        Constant c;
+        c.kind = a.kind == Constant::Int64 || b.kind == Constant::Int64 ? Constant::Int64 : Constant::Int32;
+        bool overflow = false;
+        if (op == "+") overflow = __builtin_add_overflow(x, y, &c.i);
+        else if (op == "-") overflow = __builtin_sub_overflow(x, y, &c.i);
+        else if (op == "*") overflow = __builtin_mul_overflow(x, y, &c.i);
+        else if (op == "/" || op == "%") {
+            if (y == 0 || (x == INT64_MIN && y == -1)) return none;
+            c.i = op == "/" ? x / y : x % y;
+        } else {
+            return none;
+        }
+        if (overflow) return none;
+        if (c.kind == Constant::Int32 && (c.i < INT32_MIN || c.i > INT32_MAX)) return none;
+        return c;
+    }
+};
+
+// x * 1, 1 * x, x / 1, x - 0, x + 0, 0 + x  =>  x   (x of type i32 or wider)
+// -(-x) => x, !(!c) => c, c && true => c, c || false => c   (c a condition)
+class AlgebraicSimplifyPass : public ASTPass {
+public:
+    const char* name() const override { return "algebraic-simplify"; }
+
+    int run(shared_ptr<ASTNode> program) override {
+        int changes = 0;
+        set<string> fields;
+        for (auto& decl : program->children) {
+            if (decl->type != NodeType::CLASS_DECL) continue;
+            for (auto& section : decl->children) {
+                if (section->type != NodeType::OBJECT_SECTION) continue;
+                for (auto& field : section->children) fields.insert(field->value);
+            }
+        }
+
+        for (auto& body : functionBodies(program)) {
+            localsWhere(wideLocals, body.get(), fields, [&](const ASTNode& value) { return isWide(value); });
+            localsWhere(integerLocals, body.get(), fields, [&](const ASTNode& value) { return isInteger(value); });
+            shared_ptr<ASTNode> root = body;
+            rewriteExpressions(root, [&](shared_ptr<ASTNode> node) {
+                shared_ptr<ASTNode> simplified = simplify(node);
+                if (simplified != node) changes++;
+                return simplified;
+            });
+        }
+        return changes;
+    }
+
+private:
+    set<string> wideLocals;      // Locals every assignment gives i32, i64 or a float type
+    set<string> integerLocals;   // ... and of those, the ones that are never floating point
+
+    static bool isLiteral(const ASTNode& node) { return node.type == NodeType::LITERAL; }
+
+    static bool isIntLiteral(const ASTNode& node, int64_t value) {
+        Constant c = literalConstant(node);
+        return c.isInt() && c.i == value;
+    }
+
+    // An operand the generator types as i32, i64, f32 or f64. Next to such
+    // an operand an integer literal adopts its type, so x op 1 has the
+    // type of x; next to an i8 or a bool it would widen the result to i32.
+    bool isWide(const ASTNode& node) {
+        switch (node.type) {
+            case NodeType::LITERAL:
+                return literalConstant(node).isNumeric();
+            case NodeType::IDENTIFIER:
+                return wideLocals.count(node.value) > 0;
+            case NodeType::FUNCTION_CALL:
+                return node.value == "len" || node.value == "size" || node.value == "i32" ||
+                       node.value == "i64" || node.value == "f32" || node.value == "f64";
+            case NodeType::UNARY_OP:
+                return node.value != "!" && !node.children.empty() && isWide(*node.children[0]);
+            case NodeType::BINARY_OP: {
+                if (node.children.size() != 2) return false;
+                const string& op = node.value;
+                if (op != "+" && op != "-" && op != "*" && op != "/" && op != "%") return false;
+                const ASTNode& lhs = *node.children[0];
+                const ASTNode& rhs = *node.children[1];
+                bool wideL = isWide(lhs);
+                bool wideR = isWide(rhs);
+                return (wideL && wideR) || (wideL && !isLiteral(lhs)) || (wideR && !isLiteral(rhs));
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Fills `locals` with the locals every assigned value of which
+    // satisfies `holds`. `holds` may read `locals` itself: this is a
+    // greatest fixpoint, so x = x + 1 keeps x if its other values do.
+    void localsWhere(set<string>& locals, const ASTNode* body, const set<string>& fields,
+                     const function<bool(const ASTNode&)>& holds) {
+        vector<pair<string, const ASTNode*>> assignments;
+        locals.clear();
+        function<void(const ASTNode*)> collect = [&](const ASTNode* node) {
+            // x op= v joins v into x's type just like x = v
+            if (node->type == NodeType::ASSIGNMENT && node->children.size() == 1 &&
+                !node->attributes.count("member")) {
+                assignments.push_back({node->value, node->children[0].get()});
+                locals.insert(node->value);
+            } else if (node->type == NodeType::RANGE_FOR) {
+                locals.insert(node->value);   // i32 or i64 induction variable
+            }
+            for (auto& child : node->children) collect(child.get());
+        };
+        collect(body);
+        for (auto& field : fields) locals.erase(field);
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto& assignment : assignments) {
+                if (locals.count(assignment.first) && !holds(*assignment.second)) {
+                    locals.erase(assignment.first);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Comparisons and logic: always i1
+    static bool isCondition(const ASTNode& node) {
+        if (node.type == NodeType::UNARY_OP) return node.value == "!";
+        if (node.type != NodeType::BINARY_OP) return false;
+        const string& op = node.value;
+        return op == "<" || op == ">" || op == "<=" || op == ">=" || op == "==" || op == "!=" ||
+               op == "&&" || op == "||";
+    }
+
+    static bool isBoolLiteral(const ASTNode& node, bool value) {
+        Constant c = literalConstant(node);
+        return c.kind == Constant::Bool && (c.i != 0) == value;
+    }
+
+    shared_ptr<ASTNode> simplify(shared_ptr<ASTNode> node) {
+        if (node->type == NodeType::UNARY_OP && node->children.size() == 1) {
+            shared_ptr<ASTNode> inner = node->children[0];
+            bool sameOp = inner->type == NodeType::UNARY_OP && inner->value == node->value &&
+                          inner->children.size() == 1;
+            if (sameOp && node->value == "-") return inner->children[0];
+            if (sameOp && node->value == "!" && isCondition(*inner->children[0])) return inner->children[0];
+            return node;
+        }
+        if (node->type != NodeType::BINARY_OP || node->children.size() != 2) return node;
+
+        shared_ptr<ASTNode> lhs = node->children[0];
+        shared_ptr<ASTNode> rhs = node->children[1];
+        const string& op = node->value;
+
+        if (op == "&&" || op == "||") {
+            bool identity = op == "&&";   // true for &&, false for ||
+            if (isCondition(*lhs) && isBoolLiteral(*rhs, identity)) return lhs;
+            if (isCondition(*rhs) && isBoolLiteral(*lhs, identity)) return rhs;
+            // c && false => false, c || true => true when c has no effects
+            if (isPure(*lhs) && isBoolLiteral(*rhs, !identity) && (isCondition(*lhs) || isLiteral(*lhs))) return rhs;
+            return node;
+        }
+
+        // Integer identities; -0.0 + 0 is +0.0, so + is only dropped for
+        // operands that cannot be floating point
+        bool wideL = isWide(*lhs) && !isLiteral(*lhs);
+        bool wideR = isWide(*rhs) && !isLiteral(*rhs);
+        if (op == "*" && wideL && isIntLiteral(*rhs, 1)) return lhs;
+        if (op == "*" && wideR && isIntLiteral(*lhs, 1)) return rhs;
+        if (op == "/" && wideL && isIntLiteral(*rhs, 1)) return lhs;
+        if (op == "-" && wideL && isIntLiteral(*rhs, 0)) return lhs;
+        if (op == "+" && wideL && isIntLiteral(*rhs, 0) && isInteger(*lhs)) return lhs;
+        if (op == "+" && wideR && isIntLiteral(*lhs, 0) && isInteger(*rhs)) return rhs;
+        return node;
+    }
+
+    // Integer-valued for certain: len()/size(), integer casts, and
+    // arithmetic on those and integer literals
+    bool isInteger(const ASTNode& node) {
+        switch (node.type) {
+            case NodeType::LITERAL:
+                return literalConstant(node).isInt();
+            case NodeType::FUNCTION_CALL:
+                return node.value == "len" || node.value == "size" || node.value == "i32" || node.value == "i64";
+            case NodeType::IDENTIFIER:
+                return integerLocals.count(node.value) > 0;
+            case NodeType::UNARY_OP:
+                return node.value == "-" && !node.children.empty() && isInteger(*node.children[0]);
+            case NodeType::BINARY_OP:
+                return node.children.size() == 2 && isWide(node) &&
+                       isInteger(*node.children[0]) && isInteger(*node.children[1]);
+            default:
+                return false;
+        }
+    }
+};
+
+// if (true) { A } else { B }  =>  A      if (false) { A } else { B }  =>  B
+//
+// The taken branch is spliced into the enclosing block. A dropped branch
+// can still matter to type inference (x = 1.5 in it makes x a float
+// everywhere), so a branch is only dropped when the variables it assigns
+// are not used anywhere else. A taken branch that returns is left in
+// place: the statements after the if would follow a terminator.
+class DeadBranchPass : public ASTPass {
+public:
+    const char* name() const override { return "dead-branch"; }
+
+    int run(shared_ptr<ASTNode> program) override {
+        int changes = 0;
+        set<string> fields;
+        for (auto& decl : program->children) {
+            if (decl->type != NodeType::CLASS_DECL) continue;
+            for (auto& section : decl->children) {
+                if (section->type != NodeType::OBJECT_SECTION) continue;
+                for (auto& field : section->children) fields.insert(field->value);
+            }
+        }
+        for (auto& body : functionBodies(program)) {
+            changes += pruneBlocks(body.get(), body.get(), fields);
+        }
+        return changes;
+    }
+
+private:
+    static int pruneBlocks(ASTNode* node, const ASTNode* func, const set<string>& fields) {
+        int changes = 0;
+        for (auto& child : node->children) changes += pruneBlocks(child.get(), func, fields);
+        if (node->type != NodeType::BLOCK) return changes;
+
+        vector<shared_ptr<ASTNode>> statements;
+        for (auto& stmt : node->children) {
+            shared_ptr<ASTNode> taken;
+            shared_ptr<ASTNode> dropped;
+            if (!constantBranch(stmt, taken, dropped) ||
+                (dropped && assignsLiveName(*dropped, *func, fields)) ||
+                (taken && returnsDirectly(*taken))) {
+                statements.push_back(stmt);
+                continue;
+            }
+            if (taken) statements.insert(statements.end(), taken->children.begin(), taken->children.end());
+            changes++;
+        }
+        node->children = move(statements);
+        return changes;
+    }
+
+    // An if on a literal condition: the branch that runs and the one that
+    // cannot (either may be missing)
+    static bool constantBranch(shared_ptr<ASTNode> stmt, shared_ptr<ASTNode>& taken, shared_ptr<ASTNode>& dropped) {
+        if (stmt->type != NodeType::IF_STMT || stmt->children.size() < 2) return false;
+        Constant cond = literalConstant(*stmt->children[0]);
+        if (cond.kind != Constant::Bool && !cond.isNumeric()) return false;
+        shared_ptr<ASTNode> elseBlock = stmt->children.size() > 2 ? stmt->children[2] : nullptr;
+        taken = cond.truthy() ? stmt->children[1] : elseBlock;
+        dropped = cond.truthy() ? elseBlock : stmt->children[1];
+        return true;
+    }
+
+    static bool returnsDirectly(const ASTNode& block) {
+        for (auto& stmt : block.children) {
+            if (stmt->type == NodeType::RETURN_STMT) return true;
+        }
+        return false;
+    }
+
+    static void collectAssigned(const ASTNode& node, set<string>& names) {
+        if (node.type == NodeType::ASSIGNMENT || node.type == NodeType::VECTOR_DECL ||
+            node.type == NodeType::RANGE_FOR) {
+            names.insert(node.value);
+        }
+        for (auto& child : node.children) collectAssigned(*child, names);
+    }
+
+    static bool mentionsOutside(const ASTNode& node, const ASTNode& excluded, const set<string>& names) {
+        if (&node == &excluded) return false;
+        bool named = node.type == NodeType::IDENTIFIER || node.type == NodeType::ASSIGNMENT ||
+                     node.type == NodeType::VECTOR_DECL || node.type == NodeType::RANGE_FOR;
+        if (named && names.count(node.value)) return true;
+        for (auto& child : node.children) {
+            if (mentionsOutside(*child, excluded, names)) return true;
+        }
+        return false;
+    }
+
+    static bool assignsLiveName(const ASTNode& branch, const ASTNode& func, const set<string>& fields) {
+        set<string> names;
+        collectAssigned(branch, names);
+        for (auto& name : names) {
+            if (fields.count(name)) return true;   // Field types are inferred across methods
+        }
+        return mentionsOutside(func, branch, names);
+    }
+};
+
+// while (i < len(v)) / for (..., i < v.size(), ...) over a vector the loop
+// never resizes: the length is read once, into a local, before the loop.
+// Only vectors local to a free function qualify; a method call could
+// push to a vector field.
+class LoopInvariantLenPass : public ASTPass {
+public:
+    const char* name() const override { return "loop-invariant-len"; }
+
+    int run(shared_ptr<ASTNode> program) override {
+        int changes = 0;
+        for (auto& decl : program->children) {
+            if (decl->type != NodeType::FUNCTION_DECL) continue;
+            set<string> vectors;
+            findVectors(*decl, vectors);
+            changes += hoistInBlocks(decl.get(), vectors);
+        }
+        return changes;
+    }
+
+private:
+    int hoisted = 0;   // Numbers the hoisted locals
+
+    // Vectors declared in the function and never rebound to something else
+    static void findVectors(const ASTNode& func, set<string>& vectors) {
+        set<string> rebound;
+        function<void(const ASTNode&)> visit = [&](const ASTNode& node) {
+            if (node.type == NodeType::VECTOR_DECL) vectors.insert(node.value);
+            if (node.type == NodeType::ASSIGNMENT && node.children.size() == 1 && !node.attributes.count("member")) {
+                rebound.insert(node.value);
+            }
+            if (node.type == NodeType::RANGE_FOR) rebound.insert(node.value);
+            for (auto& child : node.children) visit(*child);
+        };
+        visit(func);
+        for (auto& name : rebound) vectors.erase(name);
+    }
+
+    // len(v) or v.size()
+    static bool isLengthOf(const ASTNode& node, string& vec) {
+        if (node.type != NodeType::FUNCTION_CALL || (node.value != "len" && node.value != "size") ||
+            node.children.size() != 1 || node.children[0]->type != NodeType::IDENTIFIER) return false;
+        vec = node.children[0]->value;
+        return true;
+    }
+
+    // Whether anything in the loop can change v's length: every use of v
+    // must be len(v), v.size(), an element read or an element store
+    static bool mayResize(const ASTNode& node, const ASTNode* parent, const string& vec) {
+        if (node.type == NodeType::VECTOR_DECL && node.value == vec) return true;
+        if (node.type == NodeType::ASSIGNMENT && node.value == vec && node.children.size() < 2 &&
+            !node.attributes.count("member")) return true;
+        if (node.type == NodeType::IDENTIFIER && node.value == vec) {
+            string measured;
+            bool length = parent && isLengthOf(*parent, measured);
+            bool element = parent && parent->type == NodeType::ARRAY_ACCESS && parent->children[0].get() == &node;
+            if (!length && !element) return true;
+        }
+        for (auto& child : node.children) {
+            if (mayResize(*child, &node, vec)) return true;
+        }
+        return false;
+    }
+
+    static void replaceLength(shared_ptr<ASTNode>& node, const string& vec, const string& local, int& replaced) {
+        string measured;
+        if (isLengthOf(*node, measured) && measured == vec) {
+            node = make_shared<ASTNode>(NodeType::IDENTIFIER, local, node->line);
+            replaced++;
+            return;
+        }
+        for (auto& child : node->children) replaceLength(child, vec, local, replaced);
+    }
+
+    int hoistInBlocks(ASTNode* node, const set<string>& vectors) {
+        int changes = 0;
+        for (auto& child : node->children) changes += hoistInBlocks(child.get(), vectors);
+        if (node->type != NodeType::BLOCK) return changes;
+
+        vector<shared_ptr<ASTNode>> statements;
+        for (auto& stmt : node->children) {
+            size_t condIndex;
+            if (stmt->type == NodeType::WHILE_STMT && stmt->children.size() >= 2) {
+                condIndex = 0;
+            } else if (stmt->type == NodeType::FOR_STMT && stmt->children.size() >= 4) {
+                condIndex = 1;
+            } else {
+                statements.push_back(stmt);
+                continue;
+            }
+
+            set<string> measured;
+            function<void(const ASTNode&)> findLengths = [&](const ASTNode& expr) {
+                string vec;
+                if (isLengthOf(expr, vec) && vectors.count(vec)) measured.insert(vec);
+                for (auto& child : expr.children) findLengths(*child);
+            };
+            findLengths(*stmt->children[condIndex]);
+
+            for (const string& vec : measured) {
+                if (mayResize(*stmt, nullptr, vec)) continue;
+                string local = "len." + vec + "." + to_string(hoisted++);
+                int replaced = 0;
+                replaceLength(stmt->children[condIndex], vec, local, replaced);
+
+                auto length = make_shared<ASTNode>(NodeType::FUNCTION_CALL, "len", stmt->line);
+                length->addChild(make_shared<ASTNode>(NodeType::IDENTIFIER, vec, stmt->line));
+                auto assignment = make_shared<ASTNode>(NodeType::ASSIGNMENT, local, stmt->line);
+                assignment->addChild(length);
+                statements.push_back(assignment);
+                changes += replaced;
+            }
+            statements.push_back(stmt);
+        }
+        node->children = move(statements);
+        return changes;
+    }
+};
+
+class ASTPassManager {
+public:
+    void add(unique_ptr<ASTPass> pass) {
+        entries.push_back({move(pass), 0, 0.0});
+    }
+
+    // Runs the pipeline until a round changes nothing (bounded, in case
+    // two passes ever undo each other)
+    void run(shared_ptr<ASTNode> program) {
+        static constexpr int MAX_ROUNDS = 8;
+        for (rounds = 1; rounds <= MAX_ROUNDS; rounds++) {
+            int changes = 0;
+            for (auto& entry : entries) {
+                auto start = chrono::steady_clock::now();
+                int passChanges = entry.pass->run(program);
+                entry.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                entry.changes += passChanges;
+                changes += passChanges;
+            }
+            if (changes == 0) break;
+        }
+        rounds = min(rounds, MAX_ROUNDS);
+    }
+
+    void report() const {
+        int total = 0;
+        double seconds = 0;
+        for (auto& entry : entries) {
+            total += entry.changes;
+            seconds += entry.seconds;
+        }
+        CAX_INFO(diag::CAT_IRGEN, "AST passes: " << total << " rewrites in " << rounds << " round"
+                 << (rounds == 1 ? "" : "s") << ", " << fixed << setprecision(3) << seconds * 1e3 << " ms");
+        for (auto& entry : entries) {
+            CAX_INFO(diag::CAT_IRGEN, "  " << left << setw(20) << entry.pass->name() << right << setw(6)
+                     << entry.changes << " rewrites  " << fixed << setprecision(3) << entry.seconds * 1e3 << " ms");
+        }
+    }
+
+private:
+    struct Entry {
+        unique_ptr<ASTPass> pass;
+        int changes;
+        double seconds;
+    };
+    vector<Entry> entries;
+    int rounds = 0;
+};
+
 // ============================================
 // MAIN
 // ============================================
@@ -1818,18 +6672,47 @@ int main(int argc, char** argv) {
     // Default filename or get from command line
     string filename = "SampleCode.cax";
 
-    if (argc > 1) {
-        filename = argv[1];
+    BoundsCheckMode boundsChecks = BoundsCheckMode::Off;
+    bool layoutReport = false;
+    bool astPasses = true;
+    string profileGenerate;
+    string profileUse;
+    string instrument;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (diag::parseOption(arg)) {
+            continue;
+        }
+        if (arg == "--bounds-check=on") {
+            boundsChecks = BoundsCheckMode::On;
+        } else if (arg == "--bounds-check=off") {
+            boundsChecks = BoundsCheckMode::Off;
+        } else if (arg == "--bounds-check=auto") {
+            boundsChecks = BoundsCheckMode::Auto;
+        } else if (arg == "--layout-report") {
+            layoutReport = true;
+        } else if (arg == "--no-ast-opt") {
+            astPasses = false;
+        } else if (arg == "--profile-generate") {
+            profileGenerate = "default.caxprof";
+        } else if (arg.rfind("--profile-generate=", 0) == 0) {
+            profileGenerate = arg.substr(strlen("--profile-generate="));
+        } else if (arg.rfind("--profile-use=", 0) == 0) {
+            profileUse = arg.substr(strlen("--profile-use="));
+        } else if (arg.rfind("--instrument=", 0) == 0) {
+            instrument = arg.substr(strlen("--instrument="));
+        } else {
+            filename = arg;
+        }
     }
 
-    cout << "C-ACCEL to LLVM IR Compiler\n";
-    cout << "============================\n\n";
-
-    cout << "Reading file: " << filename << "\n\n";
+    CAX_INFO(diag::CAT_IRGEN, "C-ACCEL to LLVM IR Compiler");
+    CAX_INFO(diag::CAT_IRGEN, "Reading file: " << filename);
 
     ifstream file(filename);
     if (!file.is_open()) {
-        cerr << "Error: Could not open file: " << filename << "\n";
+        CAX_ERROR(diag::CAT_IRGEN, "Could not open file: " << filename);
         return 1;
     }
 
@@ -1838,42 +6721,65 @@ int main(int argc, char** argv) {
     file.close();
     string source = buffer.str();
 
-    cout << "Tokenizing source code...\n";
+    CAX_INFO(diag::CAT_IRGEN, "Tokenizing source code...");
     Lexer lexer(source);
     vector<Token> tokens = lexer.tokenize();
-    cout << "Generated " << tokens.size() << " tokens\n\n";
+    CAX_INFO(diag::CAT_IRGEN, "Generated " << tokens.size() << " tokens");
 
-    cout << "Parsing tokens into AST...\n";
+    CAX_INFO(diag::CAT_IRGEN, "Parsing tokens into AST...");
     Parser parser(tokens);
     shared_ptr<ASTNode> ast = parser.parse();
 
     vector<string> errors = parser.getErrors();
     if (!errors.empty()) {
-        cout << "\nPARSE ERRORS DETECTED:\n";
+        CAX_ERROR(diag::CAT_PARSER, "PARSE ERRORS DETECTED:");
         for (const auto& error : errors) {
-            cout << error << "\n";
+            CAX_ERROR(diag::CAT_PARSER, error);
         }
         return 1;
     }
 
-    cout << "Parsing completed successfully!\n\n";
+    CAX_INFO(diag::CAT_IRGEN, "Parsing completed successfully!");
+
+    if (astPasses) {
+        ASTPassManager passes;
+        passes.add(make_unique<ConstantFoldPass>());
+        passes.add(make_unique<AlgebraicSimplifyPass>());
+        passes.add(make_unique<DeadBranchPass>());
+        passes.add(make_unique<LoopInvariantLenPass>());
+        passes.run(ast);
+        passes.report();
+    }
 
     // Generate LLVM IR
     IRGenerator gen("C-ACCEL-Module");
+    gen.setBoundsCheckMode(boundsChecks);
+    gen.setLayoutReport(layoutReport);
+    gen.setProfileGenerate(profileGenerate);
+    if (!gen.setInstrumentation(instrument)) {
+        return 1;
+    }
+    if (!profileUse.empty() && !gen.loadProfile(profileUse)) {
+        return 1;
+    }
     gen.generateProgram(ast);
 
-    cout << "\n" << string(60, '=') << "\n";
-    cout << "Generated LLVM IR:\n";
-    cout << string(60, '=') << "\n\n";
+    // Dumping the whole module dominates wall time on big inputs, so it
+    // is only done on request (-vv or --trace=irgen).
+    if (CAX_LOG_ENABLED(Debug, diag::CAT_IRGEN)) {
+        cout << "\n" << string(60, '=') << "\n";
+        cout << "Generated LLVM IR:\n";
+        cout << string(60, '=') << "\n\n";
 
-    gen.printIR();
+        gen.printIR();
 
-    cout << "\n" << string(60, '=') << "\n";
+        cout << "\n" << string(60, '=') << "\n";
+    }
     gen.verify();
 
     string outputFile = "irGenerator/output.ll";
     gen.writeIRToFile(outputFile);
 
-    cout << "\nCompilation completed successfully!\n";
+    CAX_INFO(diag::CAT_IRGEN, "Compilation completed successfully!");
     return 0;
-}
\ No newline at end of file
+}
@@ -11,6 +11,8 @@
 #include <iomanip>
 #include <functional>
 
+#include "diagnostics/diagnostics.h"
+
 using namespace std;
 
 
@@ -351,10 +353,11 @@ private:
     size_t current;
     vector<string> errors;
 
-    void debugToken(const string& where) {
-        const Token& t = peek();
-        cerr << "[DEBUG] " << where << " → Token("
-             << (int)t.type << ", '" << t.value << "', line " << t.line << ")\n";
+    // Compiled out entirely when CAX_MAX_LOG_LEVEL is below Trace; otherwise
+    // only formats the token when --trace=parser is given.
+    void debugToken(const char* where) {
+        CAX_TRACE(diag::CAT_PARSER, where << " → Token("
+                  << (int)peek().type << ", '" << peek().value << "', line " << peek().line << ")");
     }
 
     Token peek(int offset = 0) {
@@ -477,9 +480,15 @@ private:
         Token funcToken = expect(TokenType::FUNC, "Expected 'func'");
         expect(TokenType::LPAREN, "Expected '(' after func");
 
+        // func(Type) or a list of annotations: func(Export, NoInline)
         string funcType = "";
+        string annotations = "";
         if (peek().type == TokenType::IDENTIFIER) {
             funcType = advance().value;
+            annotations = funcType;
+            while (match(TokenType::COMMA)) {
+                annotations += "," + expect(TokenType::IDENTIFIER, "Expected function annotation").value;
+            }
         }
 
         expect(TokenType::RPAREN, "Expected ')' after func type");
@@ -500,6 +509,7 @@ private:
                                         funcToken.line);
         if (!funcType.empty()) {
             node->setAttribute("type", funcType);
+            node->setAttribute("annotations", annotations);
         }
 
         auto body = parseBlock();
@@ -512,9 +522,15 @@ private:
         Token classToken = expect(TokenType::CLASS, "Expected 'class'");
         expect(TokenType::LPAREN, "Expected '(' after class");
 
+        // class(Type) or a list of annotations: class(Ordered, SoA)
         string classType = "";
+        string annotations = "";
         if (peek().type == TokenType::IDENTIFIER) {
             classType = advance().value;
+            annotations = classType;
+            while (match(TokenType::COMMA)) {
+                annotations += "," + expect(TokenType::IDENTIFIER, "Expected class annotation").value;
+            }
         }
 
         expect(TokenType::RPAREN, "Expected ')' after class type");
@@ -526,6 +542,7 @@ private:
         auto node = make_shared<ASTNode>(NodeType::CLASS_DECL, className, classToken.line);
         if (!classType.empty()) {
             node->setAttribute("type", classType);
+            node->setAttribute("annotations", annotations);
         }
 
         expect(TokenType::LBRACE, "Expected '{' after class declaration");
@@ -619,20 +636,27 @@ private:
                 nextType == TokenType::DIV_EQ) {
                 return parseAssignment();
             } else if (nextType == TokenType::LBRACKET) {
-                // Could be array access assignment like arr[0] = 5
+                // Could be array access assignment like arr[0] = 5 or m[i][j] = 5
                 size_t saved = current;
                 advance(); // skip identifier
-                advance(); // skip [
 
-                // Skip to find ]
-                int bracketDepth = 1;
-                while (bracketDepth > 0 && peek().type != TokenType::END_OF_FILE) {
-                    if (peek().type == TokenType::LBRACKET) bracketDepth++;
-                    else if (peek().type == TokenType::RBRACKET) bracketDepth--;
-                    advance();
+                // Skip each [...] group
+                while (peek().type == TokenType::LBRACKET) {
+                    advance(); // skip [
+                    int bracketDepth = 1;
+                    while (bracketDepth > 0 && peek().type != TokenType::END_OF_FILE) {
+                        if (peek().type == TokenType::LBRACKET) bracketDepth++;
+                        else if (peek().type == TokenType::RBRACKET) bracketDepth--;
+                        advance();
+                    }
                 }
 
-                // Check if followed by assignment
+                // Check if followed by assignment, directly or to a field
+                // of an element (c[i].field = value)
+                if (peek().type == TokenType::DOT && peek(1).type == TokenType::IDENTIFIER) {
+                    advance(); // skip .
+                    advance(); // skip field name
+                }
                 TokenType afterBracket = peek().type;
                 current = saved; // restore position
 
@@ -661,10 +685,11 @@ private:
             Token var = advance();
             expect(TokenType::IN, "Expected 'in'");
 
-            auto rangeNode = make_shared<ASTNode>(NodeType::RANGE_FOR, var.value);
+            auto rangeNode = make_shared<ASTNode>(NodeType::RANGE_FOR, var.value, var.line);
             rangeNode->addChild(parseExpression());
             node->addChild(rangeNode);
 
+            parseLoopAnnotations(node);
             expect(TokenType::RPAREN, "Expected ')' after for");
             node->addChild(parseBlock());
             return node;
@@ -710,12 +735,28 @@ private:
 
         // INCREMENT (expression or unary)
         node->addChild(parseExpression());
+        parseLoopAnnotations(node);
         expect(TokenType::RPAREN, "Expected ')' after for");
 
         node->addChild(parseBlock());
         return node;
     }
 
+    // Optional trailing `, unroll=N, vectorize=N` in a for header
+    void parseLoopAnnotations(shared_ptr<ASTNode> loop) {
+        while (match(TokenType::COMMA)) {
+            Token name = expect(TokenType::IDENTIFIER, "Expected loop annotation (unroll=N or vectorize=N)");
+            expect(TokenType::ASSIGN, "Expected '=' after loop annotation");
+            Token value = expect(TokenType::INTEGER, "Expected an integer loop annotation value");
+            if (name.value != "unroll" && name.value != "vectorize") {
+                errors.push_back("Line " + to_string(name.line) + ": Unknown loop annotation '" + name.value +
+                                 "' (expected unroll or vectorize)");
+            } else {
+                loop->setAttribute(name.value, value.value);
+            }
+        }
+    }
+
     shared_ptr<ASTNode> parseWhile() {
         Token whileToken = expect(TokenType::WHILE, "Expected 'while'");
         expect(TokenType::LPAREN, "Expected '(' after while");
@@ -775,11 +816,18 @@ private:
         expect(TokenType::VECTOR, "Expected 'vector'");
         expect(TokenType::LT, "Expected '<' after vector");
         Token type = expect(TokenType::IDENTIFIER, "Expected type");
+        // vector<soa Name>: structure-of-arrays vector of class instances
+        bool soa = false;
+        if (type.value == "soa" && peek().type == TokenType::IDENTIFIER) {
+            soa = true;
+            type = advance();
+        }
         expect(TokenType::GT, "Expected '>' after type");
         Token name = expect(TokenType::IDENTIFIER, "Expected identifier");
 
         auto node = make_shared<ASTNode>(NodeType::VECTOR_DECL, name.value);
         node->setAttribute("elementType", type.value);
+        if (soa) node->setAttribute("layout", "soa");
 
         return node;
     }
@@ -788,9 +836,16 @@ private:
         Token var = expect(TokenType::IDENTIFIER, "Expected identifier");
 
         if (peek().type == TokenType::LBRACKET) {
-            advance();
-            auto indexNode = parseExpression();
-            expect(TokenType::RBRACKET, "Expected ']'");
+            // One index per dimension: arr[i] or m[i][j]
+            vector<shared_ptr<ASTNode>> indexNodes;
+            while (match(TokenType::LBRACKET)) {
+                indexNodes.push_back(parseExpression());
+                expect(TokenType::RBRACKET, "Expected ']'");
+            }
+            string member;
+            if (match(TokenType::DOT)) {
+                member = expect(TokenType::IDENTIFIER, "Expected field name").value;
+            }
 
             TokenType assignType = peek().type;
             if (assignType == TokenType::ASSIGN || assignType == TokenType::PLUS_EQ ||
@@ -799,7 +854,10 @@ private:
                 Token op = advance();
                 auto node = make_shared<ASTNode>(NodeType::ASSIGNMENT, var.value);
                 node->setAttribute("operator", op.value);
-                node->addChild(indexNode);
+                if (!member.empty()) node->setAttribute("member", member);
+                for (auto& indexNode : indexNodes) {
+                    node->addChild(indexNode);
+                }
                 node->addChild(parseExpression());
                 return node;
             }
@@ -937,12 +995,12 @@ private:
                 expr = node;
             } else if (match(TokenType::DOT)) {
                 Token member = expect(TokenType::IDENTIFIER, "Expected member name");
-                auto node = make_shared<ASTNode>(NodeType::MEMBER_ACCESS, member.value);
+                auto node = make_shared<ASTNode>(NodeType::MEMBER_ACCESS, member.value, member.line);
                 node->addChild(expr);
 
                 if (peek().type == TokenType::LPAREN) {
                     advance();
-                    auto callNode = make_shared<ASTNode>(NodeType::FUNCTION_CALL, member.value);
+                    auto callNode = make_shared<ASTNode>(NodeType::FUNCTION_CALL, member.value, member.line);
                     callNode->addChild(expr);
 
                     while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
@@ -963,7 +1021,7 @@ private:
                 expr = node;
             } else if (peek().type == TokenType::LPAREN && expr->type == NodeType::IDENTIFIER) {
                 advance();
-                auto node = make_shared<ASTNode>(NodeType::FUNCTION_CALL, expr->value);
+                auto node = make_shared<ASTNode>(NodeType::FUNCTION_CALL, expr->value, expr->line);
 
                 while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
                     node->addChild(parseExpression());
@@ -1193,7 +1251,13 @@ struct ParseStatistics {
 // ============================================
 
 int main(int argc, char* argv[]) {
-    string filename = (argc < 2) ? "../SampleCode.cax" : argv[1];
+    string filename = "../SampleCode.cax";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (!diag::parseOption(arg)) {
+            filename = arg;
+        }
+    }
 
     cout << "C-Accel Syntax Parser\n";
     cout << "=====================\n";
@@ -1278,15 +1342,15 @@ int main(int argc, char* argv[]) {
             if (!node) return;
 
             if (node->type == NodeType::FUNCTION_DECL) {
-                string type = node->attributes.count("type") ?
-                             " [" + node->attributes["type"] + "]" : "";
+                string type = node->attributes.count("annotations") ?
+                             " [" + node->attributes["annotations"] + "]" : "";
                 reportFile << "  Function: " << node->value << type
                           << " (line " << node->line << ")\n";
             }
 
             if (node->type == NodeType::CLASS_DECL) {
-                string type = node->attributes.count("type") ?
-                             " [" + node->attributes["type"] + "]" : "";
+                string type = node->attributes.count("annotations") ?
+                             " [" + node->attributes["annotations"] + "]" : "";
                 reportFile << "  Class: " << node->value << type
                           << " (line " << node->line << ")\n";
             }
@@ -0,0 +1,488 @@
+#define _POSIX_C_SOURCE 200809L   /* clock_gettime, sigaction */
+
+#include "cax_runtime.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CAX_USE_TSC 1
+#endif
+
+/* ============================================
+ * INSTRUMENTATION (--instrument=functions,loops,branches)
+ * ============================================
+ *
+ * Functions. Every instrumented function calls cax_func_enter(id) on
+ * entry and cax_func_exit(id) before it returns. Each thread keeps its
+ * own table (calls, inclusive and exclusive time per function) and a
+ * shadow stack of the calls in progress, so neither call takes a lock or
+ * an atomic read-modify-write. Time is read with rdtsc where available (converted to
+ * nanoseconds against CLOCK_MONOTONIC over the run) and with
+ * clock_gettime otherwise.
+ *
+ *   inclusive  time from entry to exit; for recursive functions only the
+ *              outermost call counts, so nothing is counted twice
+ *   exclusive  inclusive minus the time spent in instrumented callees
+ *
+ * Tables of exited threads are folded into a global one. The report
+ * reads the tables of running threads too: each one has a sequence
+ * number its thread makes odd while it updates the totals (a seqlock),
+ * and the report copies a table only when it saw the same even number
+ * before and after, so it gets a consistent snapshot without the
+ * updating thread ever waiting.
+ *
+ * Loops and branches. Each loop and if statement has counters of its own
+ * in the program's data, keyed by function and source line. An if adds
+ * to its taken or not-taken count inline. A loop counts its iterations
+ * in a local and hands the total to cax_loop_exit when it is left, which
+ * keeps the number of runs, total, minimum and maximum trip count (with
+ * atomics: loops also run on parallel-for worker threads).
+ *
+ * The report is written at exit and whenever the program gets SIGUSR1
+ * (by the next instrumented return or loop exit after the signal,
+ * outside the handler): functions sorted by exclusive time, then loops
+ * and branches in source order, on stderr or in the file named by
+ * CAX_INSTRUMENT_OUTPUT, as JSON if that name ends in ".json".
+ */
+
+typedef struct {
+    int64_t calls;
+    uint64_t inclusive;       /* ticks */
+    uint64_t exclusive;
+    int32_t active;           /* calls in progress (recursion depth) */
+} FunctionTotals;
+
+typedef struct {
+    int32_t id;
+    uint64_t start;
+    uint64_t children;        /* ticks spent in instrumented callees */
+} Frame;
+
+typedef struct ThreadTable {
+    FunctionTotals* totals;   /* calls/inclusive/exclusive are read by the report */
+    Frame* stack;
+    int32_t depth;
+    int32_t capacity;
+    uint64_t sequence;        /* odd while the owning thread updates totals */
+    struct ThreadTable* next;
+} ThreadTable;
+
+/* Totals fields shared with the report: written only by the owning
+ * thread, always with atomic accesses so reading them is not a race */
+#define SHARED_LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define SHARED_ADD(field, value) __atomic_store_n(&(field), (field) + (value), __ATOMIC_RELAXED)
+
+static inline void beginUpdate(ThreadTable* table) {
+    __atomic_store_n(&table->sequence, table->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void endUpdate(ThreadTable* table) {
+    __atomic_store_n(&table->sequence, table->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/* Copies another thread's totals once it is between updates */
+static void snapshotTotals(ThreadTable* table, FunctionTotals* copy, int64_t count) {
+    for (;;) {
+        uint64_t before = __atomic_load_n(&table->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        for (int64_t i = 0; i < count; i++) {
+            copy[i].calls = SHARED_LOAD(table->totals[i].calls);
+            copy[i].inclusive = SHARED_LOAD(table->totals[i].inclusive);
+            copy[i].exclusive = SHARED_LOAD(table->totals[i].exclusive);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&table->sequence, __ATOMIC_RELAXED) == before) return;
+    }
+}
+
+static CaxFunctionTable* functionTable = NULL;
+static CaxSiteTable* siteTable = NULL;
+static FunctionTotals* retired = NULL;      /* exited threads */
+static ThreadTable* liveTables = NULL;
+static int64_t threadCount = 0;
+static int reportRequested = 0;            /* set by SIGUSR1; taken by one thread */
+static _Thread_local ThreadTable* tlsTable = NULL;
+
+static uint64_t startTicks;
+static double startSeconds;
+
+static double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t ticks(void) {
+#ifdef CAX_USE_TSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Nanoseconds per tick, measured over the run so far */
+static double tickNanoseconds(void) {
+#ifdef CAX_USE_TSC
+    double seconds = monotonicSeconds() - startSeconds;
+    while (seconds < 0.01) seconds = monotonicSeconds() - startSeconds;   /* short runs: calibrate 10 ms */
+    uint64_t elapsed = ticks() - startTicks;
+    return elapsed ? seconds * 1e9 / (double)elapsed : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+static CAX_NORETURN void instrumentOutOfMemory(void) {
+    cax_flush();
+    fprintf(stderr, "C-Accel runtime: out of memory in instrumentation\n");
+    abort();
+}
+
+/* --------------------------------------------
+ * Thread tables
+ * -------------------------------------------- */
+
+#ifndef _WIN32
+static pthread_mutex_t tablesLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t tableKey;
+static pthread_once_t tableOnce = PTHREAD_ONCE_INIT;
+#define LOCK_TABLES() pthread_mutex_lock(&tablesLock)
+#define UNLOCK_TABLES() pthread_mutex_unlock(&tablesLock)
+
+static void retireAtThreadExit(void* data) {
+    ThreadTable* table = (ThreadTable*)data;
+    LOCK_TABLES();
+    for (ThreadTable** link = &liveTables; *link; link = &(*link)->next) {
+        if (*link == table) {
+            *link = table->next;
+            break;
+        }
+    }
+    for (int64_t i = 0; i < functionTable->count; i++) {
+        retired[i].calls += table->totals[i].calls;
+        retired[i].inclusive += table->totals[i].inclusive;
+        retired[i].exclusive += table->totals[i].exclusive;
+    }
+    UNLOCK_TABLES();
+    free(table->totals);
+    free(table->stack);
+    free(table);
+}
+
+static void initTableKey(void) {
+    pthread_key_create(&tableKey, retireAtThreadExit);
+}
+#else
+#define LOCK_TABLES()
+#define UNLOCK_TABLES()
+#endif
+
+static ThreadTable* threadTable(void) {
+    ThreadTable* table = tlsTable;
+    if (table) return table;
+
+    table = calloc(1, sizeof(ThreadTable));
+    if (!table) instrumentOutOfMemory();
+    table->totals = calloc((size_t)functionTable->count, sizeof(FunctionTotals));
+    if (!table->totals) instrumentOutOfMemory();
+
+    LOCK_TABLES();
+    table->next = liveTables;
+    liveTables = table;
+    threadCount++;
+    UNLOCK_TABLES();
+#ifndef _WIN32
+    pthread_once(&tableOnce, initTableKey);
+    pthread_setspecific(tableKey, table);
+#endif
+    tlsTable = table;
+    return table;
+}
+
+/* --------------------------------------------
+ * Report
+ * -------------------------------------------- */
+
+typedef struct {
+    int64_t id;
+    FunctionTotals totals;
+} ReportRow;
+
+static int byExclusiveTime(const void* a, const void* b) {
+    const ReportRow* x = (const ReportRow*)a;
+    const ReportRow* y = (const ReportRow*)b;
+    if (x->totals.exclusive != y->totals.exclusive) return x->totals.exclusive < y->totals.exclusive ? 1 : -1;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+/* A name as a JSON string: function names are free-form source strings */
+static void writeJsonString(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)text; *c; c++) {
+        switch (*c) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\r': fputs("\\r", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (*c < 0x20) {
+                    fprintf(out, "\\u%04x", *c);
+                } else {
+                    fputc(*c, out);
+                }
+        }
+    }
+    fputc('"', out);
+}
+
+/* JSON parts are written without a trailing newline; `parts` counts the
+ * ones already written, so the next knows to add the separator */
+static void writeFunctions(FILE* out, int json, int* parts) {
+    int64_t count = functionTable->count;
+    ReportRow* rows = calloc((size_t)count, sizeof(ReportRow));
+    FunctionTotals* snapshot = calloc((size_t)(count > 0 ? count : 1), sizeof(FunctionTotals));
+    if (!rows || !snapshot) instrumentOutOfMemory();
+
+    /* The lock keeps exiting threads from freeing their tables meanwhile */
+    LOCK_TABLES();
+    int64_t threads = threadCount;
+    for (int64_t i = 0; i < count; i++) {
+        rows[i].id = i;
+        rows[i].totals = retired[i];
+    }
+    for (ThreadTable* table = liveTables; table; table = table->next) {
+        snapshotTotals(table, snapshot, count);
+        for (int64_t i = 0; i < count; i++) {
+            rows[i].totals.calls += snapshot[i].calls;
+            rows[i].totals.inclusive += snapshot[i].inclusive;
+            rows[i].totals.exclusive += snapshot[i].exclusive;
+        }
+    }
+    UNLOCK_TABLES();
+    free(snapshot);
+    qsort(rows, (size_t)count, sizeof(ReportRow), byExclusiveTime);
+
+    double ns = tickNanoseconds();
+    uint64_t total = 0;
+    for (int64_t i = 0; i < count; i++) total += rows[i].totals.exclusive;
+
+    if (json) {
+        fprintf(out, "%s  \"threads\": %lld,\n  \"functions\": [", (*parts)++ ? ",\n" : "", (long long)threads);
+        int first = 1;
+        for (int64_t i = 0; i < count; i++) {
+            const ReportRow* row = &rows[i];
+            if (row->totals.calls == 0) continue;
+            const CaxInstrumentedFunction* func = &functionTable->functions[row->id];
+            fprintf(out, "%s\n    {\"name\": ", first ? "" : ",");
+            writeJsonString(out, func->name);
+            fprintf(out, ", \"line\": %lld, \"calls\": %lld, \"inclusive_ns\": %.0f, \"exclusive_ns\": %.0f}",
+                    (long long)func->line, (long long)row->totals.calls,
+                    (double)row->totals.inclusive * ns, (double)row->totals.exclusive * ns);
+            first = 0;
+        }
+        fprintf(out, "\n  ]");
+    } else {
+        fprintf(out, "\nC-Accel function profile (%lld thread%s, by exclusive time)\n", (long long)threads,
+                threads == 1 ? "" : "s");
+        fprintf(out, "%12s %14s %14s %7s  %s\n", "calls", "inclusive ms", "exclusive ms", "excl %", "function");
+        for (int64_t i = 0; i < count; i++) {
+            const ReportRow* row = &rows[i];
+            if (row->totals.calls == 0) continue;
+            const CaxInstrumentedFunction* func = &functionTable->functions[row->id];
+            fprintf(out, "%12lld %14.3f %14.3f %6.1f%%  %s (line %lld)\n", (long long)row->totals.calls,
+                    (double)row->totals.inclusive * ns * 1e-6, (double)row->totals.exclusive * ns * 1e-6,
+                    total ? 100.0 * (double)row->totals.exclusive / (double)total : 0.0,
+                    func->name, (long long)func->line);
+        }
+    }
+    free(rows);
+}
+
+static int64_t loadCount(const int64_t* counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+/* Loops (kind CAX_SITE_LOOP) or branches (CAX_SITE_BRANCH) in source order */
+static void writeSites(FILE* out, int json, int64_t kind, int* parts) {
+    int first = 1;
+    for (int64_t i = 0; i < siteTable->count; i++) {
+        const CaxInstrumentedSite* site = &siteTable->sites[i];
+        if (site->kind != kind || loadCount(&site->counts[0]) + loadCount(&site->counts[1]) == 0) continue;
+        if (first) {
+            if (json) {
+                fprintf(out, "%s  \"%s\": [", (*parts)++ ? ",\n" : "", kind == CAX_SITE_LOOP ? "loops" : "branches");
+            } else if (kind == CAX_SITE_LOOP) {
+                fprintf(out, "\nC-Accel loop trip counts\n%8s  %-24s %12s %12s %12s %14s\n",
+                        "line", "function", "runs", "min", "max", "mean");
+            } else {
+                fprintf(out, "\nC-Accel branches\n%8s  %-24s %14s %14s %8s\n",
+                        "line", "function", "taken", "not taken", "taken %");
+            }
+        }
+
+        if (kind == CAX_SITE_LOOP) {
+            int64_t runs = loadCount(&site->counts[0]);
+            int64_t trips = loadCount(&site->counts[1]);
+            int64_t minTrips = loadCount(&site->counts[2]);
+            int64_t maxTrips = loadCount(&site->counts[3]);
+            double mean = runs ? (double)trips / (double)runs : 0.0;
+            if (json) {
+                fprintf(out, "%s\n    {\"function\": ", first ? "" : ",");
+                writeJsonString(out, site->function);
+                fprintf(out, ", \"line\": %lld, \"runs\": %lld, \"min\": %lld, \"max\": %lld, \"mean\": %.2f}",
+                        (long long)site->line, (long long)runs, (long long)minTrips, (long long)maxTrips, mean);
+            } else {
+                fprintf(out, "%8lld  %-24s %12lld %12lld %12lld %14.2f\n", (long long)site->line, site->function,
+                        (long long)runs, (long long)minTrips, (long long)maxTrips, mean);
+            }
+        } else {
+            int64_t notTaken = loadCount(&site->counts[0]);
+            int64_t taken = loadCount(&site->counts[1]);
+            double percent = 100.0 * (double)taken / (double)(taken + notTaken);
+            if (json) {
+                fprintf(out, "%s\n    {\"function\": ", first ? "" : ",");
+                writeJsonString(out, site->function);
+                fprintf(out, ", \"line\": %lld, \"taken\": %lld, \"not_taken\": %lld}",
+                        (long long)site->line, (long long)taken, (long long)notTaken);
+            } else {
+                fprintf(out, "%8lld  %-24s %14lld %14lld %7.1f%%\n", (long long)site->line, site->function,
+                        (long long)taken, (long long)notTaken, percent);
+            }
+        }
+        first = 0;
+    }
+    if (json && !first) fprintf(out, "\n  ]");
+}
+
+static void writeReport(void) {
+    cax_flush();
+    const char* path = getenv("CAX_INSTRUMENT_OUTPUT");
+    FILE* out = path && *path ? fopen(path, "w") : stderr;
+    if (!out) {
+        fprintf(stderr, "C-Accel runtime: cannot write instrumentation report %s\n", path);
+        return;
+    }
+    size_t pathLength = path ? strlen(path) : 0;
+    int json = pathLength > 5 && strcmp(path + pathLength - 5, ".json") == 0;
+
+    int parts = 0;
+    if (json) fprintf(out, "{\n");
+    if (functionTable) writeFunctions(out, json, &parts);
+    if (siteTable) {
+        writeSites(out, json, CAX_SITE_LOOP, &parts);
+        writeSites(out, json, CAX_SITE_BRANCH, &parts);
+    }
+    if (json) fprintf(out, "\n}\n");
+    if (out != stderr) fclose(out);
+}
+
+static void requestReport(int signal) {
+    (void)signal;
+    __atomic_store_n(&reportRequested, 1, __ATOMIC_RELAXED);
+}
+
+/* Report at exit and on SIGUSR1, once for all kinds of instrumentation */
+static void registerReport(void) {
+    static int registered = 0;
+    if (registered) return;
+    registered = 1;
+    startSeconds = monotonicSeconds();
+    startTicks = ticks();
+    atexit(writeReport);
+#ifdef SIGUSR1
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestReport;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+#endif
+}
+
+static void reportIfRequested(void) {
+    if (__atomic_load_n(&reportRequested, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&reportRequested, 0, __ATOMIC_RELAXED)) {
+        writeReport();
+    }
+}
+
+/* --------------------------------------------
+ * Public entry points
+ * -------------------------------------------- */
+
+void cax_instrument_functions(CaxFunctionTable* table) {
+    if (functionTable) return;
+    retired = calloc((size_t)(table->count > 0 ? table->count : 1), sizeof(FunctionTotals));
+    if (!retired) instrumentOutOfMemory();
+    functionTable = table;
+    registerReport();
+}
+
+void cax_instrument_sites(CaxSiteTable* table) {
+    if (siteTable) return;
+    siteTable = table;
+    registerReport();
+}
+
+void cax_loop_exit(int64_t* counts, int64_t trips) {
+    __atomic_fetch_add(&counts[0], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counts[1], trips, __ATOMIC_RELAXED);
+    int64_t seen = __atomic_load_n(&counts[2], __ATOMIC_RELAXED);
+    while (trips < seen && !__atomic_compare_exchange_n(&counts[2], &seen, trips, 1,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    seen = __atomic_load_n(&counts[3], __ATOMIC_RELAXED);
+    while (trips > seen && !__atomic_compare_exchange_n(&counts[3], &seen, trips, 1,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    reportIfRequested();
+}
+
+void cax_func_enter(int32_t id) {
+    if (!functionTable) return;
+    ThreadTable* table = threadTable();
+    if (table->depth == table->capacity) {
+        int32_t capacity = table->capacity > 0 ? table->capacity * 2 : 64;
+        Frame* stack = realloc(table->stack, (size_t)capacity * sizeof(Frame));
+        if (!stack) instrumentOutOfMemory();
+        table->stack = stack;
+        table->capacity = capacity;
+    }
+    beginUpdate(table);
+    SHARED_ADD(table->totals[id].calls, 1);
+    endUpdate(table);
+    table->totals[id].active++;
+    Frame* frame = &table->stack[table->depth++];
+    frame->id = id;
+    frame->children = 0;
+    frame->start = ticks();
+}
+
+void cax_func_exit(int32_t id) {
+    uint64_t now = ticks();
+    ThreadTable* table = tlsTable;
+    if (!table || table->depth == 0 || table->stack[table->depth - 1].id != id) return;
+
+    Frame* frame = &table->stack[--table->depth];
+    uint64_t elapsed = now - frame->start;
+    FunctionTotals* totals = &table->totals[id];
+    beginUpdate(table);
+    if (--totals->active == 0) SHARED_ADD(totals->inclusive, elapsed);
+    SHARED_ADD(totals->exclusive, elapsed - frame->children);
+    endUpdate(table);
+    if (table->depth > 0) table->stack[table->depth - 1].children += elapsed;
+    reportIfRequested();
+}
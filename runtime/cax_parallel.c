@@ -0,0 +1,415 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  /* cpu_set_t, sched_getaffinity */
+#endif
+
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/* ============================================
+ * PARALLEL LOOP RUNTIME
+ * ============================================
+ *
+ * Backs exec(threads=N, fraction). The IR generator outlines each counted
+ * loop it can prove free of cross-iteration dependences into a function
+ * body(begin, end, env) over a sub-range of the iterations and calls
+ * cax_parallel_for instead of running the loop inline.
+ *
+ * The pool is started on the first parallel loop: N-1 worker threads plus
+ * the calling thread. A loop's iterations are split evenly between the
+ * threads; each thread then runs its share in chunks of
+ *
+ *     chunk = fraction * iterations / threads
+ *
+ * and, once its own share is done, steals the back half of the largest
+ * remaining share (all of it when under two chunks are left). fraction 1.0
+ * is a plain static split; smaller fractions give finer chunks and
+ * better balance for uneven iterations.
+ *
+ * exec(cpu=C, weight) puts the pool on a core budget: weight * C of the
+ * CPUs this process may run on (C = 0: all of them), further capped by
+ * the cgroup CPU quota. The budget only caps the pool's thread count: the
+ * threads are not pinned and the scheduler places them anywhere in the
+ * affinity mask, so budgeted programs sharing a host spread over all of
+ * its CPUs instead of piling onto the lowest-numbered ones.
+ */
+
+static int requestedThreads = 0;     /* exec(threads=N); 0 when absent */
+static int configuredThreads = 1;    /* pool size, after budget and CAX_THREADS */
+static double chunkFraction = 1.0;
+
+/* Set while a thread runs loop iterations; nested parallel loops run inline */
+static _Thread_local int insideParallelLoop;
+
+#ifndef _WIN32
+
+#define CAX_CACHE_LINE 64
+
+typedef struct {
+    pthread_mutex_t lock;   /* guards writes to next/end */
+    int64_t next;
+    int64_t end;
+    char padding[CAX_CACHE_LINE];
+} WorkShare;
+
+/* next/end are also read without the lock when picking a victim to steal
+ * from, so every access is atomic (relaxed: the lock orders the writes) */
+#define LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+
+static struct {
+    int threads;            /* including the thread calling cax_parallel_for */
+    WorkShare* shares;      /* one per thread; index 0 is the caller */
+
+    pthread_mutex_t lock;   /* guards everything below */
+    pthread_cond_t jobReady;
+    pthread_cond_t jobDone;
+    uint64_t generation;    /* bumped for every loop handed to the workers */
+    int running;            /* workers still busy with the current loop */
+    CaxLoopBody body;
+    void* env;
+    int64_t chunk;
+} pool = {1, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+          PTHREAD_COND_INITIALIZER, 0, 0, NULL, NULL, 1};
+
+/* --------------------------------------------
+ * Work distribution
+ * -------------------------------------------- */
+
+/* Takes the next chunk of `share`; 0 when it is empty */
+static int takeChunk(WorkShare* share, int64_t chunk, int64_t* begin, int64_t* end) {
+    int found = 0;
+    pthread_mutex_lock(&share->lock);
+    int64_t next = LOAD(share->next);
+    int64_t last = LOAD(share->end);
+    if (next < last) {
+        *begin = next;
+        *end = last - next > chunk ? next + chunk : last;
+        STORE(share->next, *end);
+        found = 1;
+    }
+    pthread_mutex_unlock(&share->lock);
+    return found;
+}
+
+/* Moves work from the fullest other share into `self`; 0 when none is left */
+static int steal(int self, int64_t chunk) {
+    int victim = -1;
+    int64_t most = 0;
+    for (int i = 0; i < pool.threads; i++) {
+        if (i == self) continue;
+        /* Unlocked peek: only picks the victim, the split below re-checks */
+        int64_t remaining = LOAD(pool.shares[i].end) - LOAD(pool.shares[i].next);
+        if (remaining > most) {
+            most = remaining;
+            victim = i;
+        }
+    }
+    if (victim < 0) return 0;
+
+    WorkShare* from = &pool.shares[victim];
+    int64_t begin = 0, end = 0;
+    pthread_mutex_lock(&from->lock);
+    int64_t remaining = LOAD(from->end) - LOAD(from->next);
+    if (remaining >= 2 * chunk) {
+        begin = LOAD(from->next) + remaining / 2;
+        end = LOAD(from->end);
+        STORE(from->end, begin);
+    } else if (remaining > 0) {
+        begin = LOAD(from->next);
+        end = LOAD(from->end);
+        STORE(from->next, end);
+    }
+    pthread_mutex_unlock(&from->lock);
+
+    if (begin == end) {
+        /* Lost the race for that share; look again */
+        for (int i = 0; i < pool.threads; i++) {
+            if (LOAD(pool.shares[i].end) - LOAD(pool.shares[i].next) > 0) return 1;
+        }
+        return 0;
+    }
+
+    WorkShare* own = &pool.shares[self];
+    pthread_mutex_lock(&own->lock);
+    STORE(own->next, begin);
+    STORE(own->end, end);
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+}
+
+static void runShare(int self) {
+    int64_t begin, end;
+    insideParallelLoop = 1;
+    do {
+        while (takeChunk(&pool.shares[self], pool.chunk, &begin, &end)) {
+            pool.body(begin, end, pool.env);
+        }
+    } while (steal(self, pool.chunk));
+    insideParallelLoop = 0;
+}
+
+/* --------------------------------------------
+ * Worker threads
+ * -------------------------------------------- */
+
+static void* workerMain(void* arg) {
+    int self = (int)(intptr_t)arg;
+    uint64_t seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool.lock);
+        while (pool.generation == seen) {
+            pthread_cond_wait(&pool.jobReady, &pool.lock);
+        }
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        runShare(self);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.running == 0) {
+            pthread_cond_signal(&pool.jobDone);
+        }
+        pthread_mutex_unlock(&pool.lock);
+    }
+    return NULL;
+}
+
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+static void startPool(void) {
+    pool.threads = configuredThreads;
+    pool.shares = calloc((size_t)pool.threads, sizeof(WorkShare));
+    if (!pool.shares) {
+        pool.threads = 1;
+        return;
+    }
+    for (int i = 0; i < pool.threads; i++) {
+        pthread_mutex_init(&pool.shares[i].lock, NULL);
+    }
+
+    for (int i = 1; i < pool.threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, workerMain, (void*)(intptr_t)i) != 0) {
+            /* Run with the workers we have */
+            pool.threads = i;
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+#endif /* !_WIN32 */
+
+/* --------------------------------------------
+ * CPU placement
+ * -------------------------------------------- */
+
+/* CPUs in this process's affinity mask; returns how many were stored */
+static int usableCpus(int* cpus, int capacity) {
+    int count = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < capacity; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus[count++] = cpu;
+        }
+        if (count > 0) return count;
+    }
+#endif
+#ifndef _WIN32
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long cpu = 0; cpu < online && count < capacity; cpu++) {
+        cpus[count++] = (int)cpu;
+    }
+#endif
+    if (count == 0) cpus[count++] = 0;
+    return count;
+}
+
+#ifdef __linux__
+static int readQuotaFile(const char* path, double* cores) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    char quota[32];
+    long long period = 0;
+    int found = fscanf(file, "%31s %lld", quota, &period) == 2;
+    fclose(file);
+    /* cgroup v2 cpu.max: "<quota> <period>" or "max <period>" */
+    if (found && strcmp(quota, "max") != 0 && period > 0) {
+        *cores = (double)atoll(quota) / (double)period;
+    }
+    return found;
+}
+
+static long long readNumberFile(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+    long long value = -1;
+    if (fscanf(file, "%lld", &value) != 1) value = -1;
+    fclose(file);
+    return value;
+}
+#endif
+
+/* CPUs' worth of time the cgroup may use per period; 0 when unlimited */
+static double cgroupCpuQuota(void) {
+    double cores = 0.0;
+#ifdef __linux__
+    /* cgroup v2: this process's own group first, then the namespace root */
+    FILE* self = fopen("/proc/self/cgroup", "r");
+    if (self) {
+        char line[512];
+        while (fgets(line, sizeof(line), self)) {
+            if (strncmp(line, "0::", 3) != 0) continue;
+            line[strcspn(line, "\n")] = '\0';
+            char path[600];
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/cpu.max", line + 3);
+            if (readQuotaFile(path, &cores)) {
+                fclose(self);
+                return cores;
+            }
+        }
+        fclose(self);
+    }
+    if (readQuotaFile("/sys/fs/cgroup/cpu.max", &cores)) return cores;
+
+    /* cgroup v1 */
+    long long quota = readNumberFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    long long period = readNumberFile("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    if (quota > 0 && period > 0) cores = (double)quota / (double)period;
+#endif
+    return cores;
+}
+
+/* "0-3,8,10-11" */
+static void formatCpuList(char* text, size_t size, const int* cpus, int count) {
+    size_t length = 0;
+    text[0] = '\0';
+    for (int i = 0; i < count && length < size; i++) {
+        int last = i;
+        while (last + 1 < count && cpus[last + 1] == cpus[last] + 1) last++;
+        int written = last > i
+            ? snprintf(text + length, size - length, "%s%d-%d", i ? "," : "", cpus[i], cpus[last])
+            : snprintf(text + length, size - length, "%s%d", i ? "," : "", cpus[i]);
+        if (written < 0) break;
+        length += (size_t)written;
+        i = last;
+    }
+}
+
+/* CAX_THREADS overrides the exec directives, e.g. for scaling runs */
+static int threadOverride(int threads) {
+    const char* forced = getenv("CAX_THREADS");
+    if (forced && atoi(forced) > 0) {
+        return atoi(forced);
+    }
+    return threads;
+}
+
+/* --------------------------------------------
+ * Entry points
+ * -------------------------------------------- */
+
+void cax_parallel_configure(int32_t threads, double fraction) {
+    requestedThreads = threads > 0 ? threads : 0;
+    threads = threadOverride(threads);
+    configuredThreads = threads > 1 ? threads : 1;
+    chunkFraction = fraction > 0.0 && fraction <= 1.0 ? fraction : 1.0;
+}
+
+void cax_parallel_cpu_budget(int32_t cpus, double weight) {
+    enum { MAX_CPUS = 1024 };
+    static int usable[MAX_CPUS];
+    int usableCount = usableCpus(usable, MAX_CPUS);
+
+    /* Whole CPUs the cgroup quota pays for (at least one) */
+    double quota = cgroupCpuQuota();
+    int available = usableCount;
+    if (quota > 0.0 && quota < available) {
+        available = quota >= 1.0 ? (int)quota : 1;
+    }
+
+    int budget = cpus > 0 && cpus < available ? cpus : available;
+    if (weight > 0.0 && weight <= 1.0) {
+        budget = (int)(budget * weight);
+    }
+    if (budget < 1) budget = 1;
+
+    int threads = requestedThreads > 0 && requestedThreads < budget ? requestedThreads : budget;
+    threads = threadOverride(threads);
+    configuredThreads = threads;
+
+    /* The threads stay unpinned: report the CPUs they may run on */
+    char cpuList[256];
+    formatCpuList(cpuList, sizeof(cpuList), usable, usableCount);
+    char quotaText[32] = "none";
+    if (quota > 0.0) snprintf(quotaText, sizeof(quotaText), "%.2f CPUs", quota);
+    fprintf(stderr, "C-Accel runtime: %d thread%s within CPU%s %s (budget: cpu=%d, weight %.2f; "
+            "%d CPU%s usable, cgroup quota %s)\n",
+            threads, threads == 1 ? "" : "s", usableCount == 1 ? "" : "s", cpuList,
+            cpus, weight, usableCount, usableCount == 1 ? "" : "s", quotaText);
+}
+
+void cax_parallel_for(int64_t begin, int64_t end, CaxLoopBody body, void* env) {
+    int64_t iterations = end - begin;
+    if (iterations <= 0) return;
+
+    if (configuredThreads <= 1 || iterations < 2 || insideParallelLoop) {
+        body(begin, end, env);
+        return;
+    }
+
+#ifdef _WIN32
+    /* No worker pool on Windows yet */
+    body(begin, end, env);
+#else
+    pthread_once(&poolOnce, startPool);
+    int threads = pool.threads;
+    if (threads <= 1) {
+        body(begin, end, env);
+        return;
+    }
+
+    /* Even initial split; the remainder goes to the first shares */
+    int64_t share = iterations / threads;
+    int64_t extra = iterations % threads;
+    int64_t next = begin;
+    for (int i = 0; i < threads; i++) {
+        int64_t length = share + (i < extra ? 1 : 0);
+        STORE(pool.shares[i].next, next);
+        STORE(pool.shares[i].end, next + length);
+        next += length;
+    }
+
+    int64_t chunk = (int64_t)(chunkFraction * (double)iterations / threads);
+    pool.chunk = chunk > 0 ? chunk : 1;
+    pool.body = body;
+    pool.env = env;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.running = threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.jobReady);
+    pthread_mutex_unlock(&pool.lock);
+
+    runShare(0);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running > 0) {
+        pthread_cond_wait(&pool.jobDone, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+#endif
+}
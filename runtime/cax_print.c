@@ -0,0 +1,262 @@
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#define isatty _isatty
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* ============================================
+ * BUFFERED OUTPUT RUNTIME
+ * ============================================
+ *
+ * Replaces one printf() per print() statement. Values are formatted
+ * directly into a per-thread buffer (no varargs parsing, no stdio lock)
+ * and the buffer is handed to write(2) in large chunks.
+ */
+
+#define CAX_OUT_CAPACITY (32 * 1024)
+
+typedef struct {
+    char data[CAX_OUT_CAPACITY];
+    size_t length;
+    int registered;
+} CaxOutBuffer;
+
+static _Thread_local CaxOutBuffer tlsOut;
+
+/* -1 = not yet checked, 0 = fully buffered, 1 = flush after every line */
+static int lineBuffered = -1;
+
+static const char digitPairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void writeAll(const char* data, size_t length) {
+    while (length > 0) {
+        long written = (long)write(1, data, (unsigned)length);
+        if (written < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) continue;
+#endif
+            return;  /* stdout closed; drop output like stdio would */
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+static void flushBuffer(CaxOutBuffer* out) {
+    if (out->length > 0) {
+        writeAll(out->data, out->length);
+        out->length = 0;
+    }
+}
+
+/* --------------------------------------------
+ * Flush registration
+ * -------------------------------------------- */
+
+static void flushAtExit(void) {
+    cax_flush();
+}
+
+#ifndef _WIN32
+static pthread_key_t flushKey;
+static pthread_once_t flushOnce = PTHREAD_ONCE_INIT;
+
+static void flushAtThreadExit(void* buffer) {
+    flushBuffer((CaxOutBuffer*)buffer);
+}
+
+static void initFlushHooks(void) {
+    pthread_key_create(&flushKey, flushAtThreadExit);
+    atexit(flushAtExit);
+    lineBuffered = isatty(1) ? 1 : 0;
+}
+#endif
+
+static CaxOutBuffer* outBuffer(void) {
+    CaxOutBuffer* out = &tlsOut;
+    if (!out->registered) {
+#ifndef _WIN32
+        pthread_once(&flushOnce, initFlushHooks);
+        pthread_setspecific(flushKey, out);
+#else
+        if (lineBuffered < 0) {
+            atexit(flushAtExit);
+            lineBuffered = isatty(1) ? 1 : 0;
+        }
+#endif
+        out->registered = 1;
+    }
+    return out;
+}
+
+/* Make room for `needed` bytes; callers never ask for more than the capacity */
+static char* reserve(CaxOutBuffer* out, size_t needed) {
+    if (out->length + needed > CAX_OUT_CAPACITY) {
+        flushBuffer(out);
+    }
+    return out->data + out->length;
+}
+
+static void endLine(CaxOutBuffer* out) {
+    out->data[out->length++] = '\n';
+    if (lineBuffered) {
+        flushBuffer(out);
+    }
+}
+
+/* --------------------------------------------
+ * Formatting helpers
+ * -------------------------------------------- */
+
+/* Writes the digits of `value` backwards ending at `end`; returns the start */
+static char* formatUnsigned(char* end, uint64_t value) {
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--end = digitPairs[pair + 1];
+        *--end = digitPairs[pair];
+    }
+    if (value < 10) {
+        *--end = (char)('0' + value);
+    } else {
+        unsigned pair = (unsigned)value * 2;
+        *--end = digitPairs[pair + 1];
+        *--end = digitPairs[pair];
+    }
+    return end;
+}
+
+static void appendSigned(CaxOutBuffer* out, int64_t value) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char* start = formatUnsigned(end, magnitude);
+    if (value < 0) *--start = '-';
+
+    size_t length = (size_t)(end - start);
+    char* dst = reserve(out, length + 1);
+    memcpy(dst, start, length);
+    out->length += length;
+}
+
+/*
+ * Same output as printf("%f"). The integer and fractional parts are
+ * split exactly; the fraction is scaled to 6 digits and rounded by hand.
+ * Values whose scaled fraction lands too close to a rounding tie for the
+ * double arithmetic to be trusted (and huge/non-finite values) go through
+ * snprintf so the result is always identical.
+ */
+static void appendDouble(CaxOutBuffer* out, double value) {
+    char text[64];
+    size_t length = 0;
+    int negative = value < 0 || (value == 0 && 1.0 / value < 0);
+    double magnitude = negative ? -value : value;
+
+    if (magnitude == magnitude && magnitude < 1e15) {
+        uint64_t whole = (uint64_t)magnitude;
+        double scaled = (magnitude - (double)whole) * 1e6;
+        uint64_t fraction = (uint64_t)scaled;
+        double remainder = scaled - (double)fraction;
+
+        if (remainder < 0.5 - 1e-6 || remainder > 0.5 + 1e-6) {
+            if (remainder > 0.5) fraction++;
+            if (fraction == 1000000) {
+                whole++;
+                fraction = 0;
+            }
+
+            char* end = text + sizeof(text);
+            char* start = end;
+            for (int i = 0; i < 6; i++) {
+                *--start = (char)('0' + fraction % 10);
+                fraction /= 10;
+            }
+            *--start = '.';
+            start = formatUnsigned(start, whole);
+            if (negative) *--start = '-';
+
+            length = (size_t)(end - start);
+            memmove(text, start, length);
+        }
+    }
+
+    if (length == 0) {
+        int n = snprintf(text, sizeof(text), "%f", value);
+        length = n < 0 ? 0 : ((size_t)n < sizeof(text) ? (size_t)n : sizeof(text) - 1);
+    }
+
+    char* dst = reserve(out, length + 1);
+    memcpy(dst, text, length);
+    out->length += length;
+}
+
+/* --------------------------------------------
+ * print() entry points
+ * -------------------------------------------- */
+
+void cax_print_i32(int32_t value) {
+    CaxOutBuffer* out = outBuffer();
+    appendSigned(out, value);
+    endLine(out);
+}
+
+void cax_print_i64(int64_t value) {
+    CaxOutBuffer* out = outBuffer();
+    appendSigned(out, value);
+    endLine(out);
+}
+
+void cax_print_f64(double value) {
+    CaxOutBuffer* out = outBuffer();
+    appendDouble(out, value);
+    endLine(out);
+}
+
+void cax_print_char(int32_t value) {
+    CaxOutBuffer* out = outBuffer();
+    char* dst = reserve(out, 2);
+    dst[0] = (char)value;
+    out->length++;
+    endLine(out);
+}
+
+void cax_print_bool(int32_t value) {
+    /* Printed as 0/1, as the printf lowering did */
+    cax_print_i32(value ? 1 : 0);
+}
+
+void cax_print_str(const char* str) {
+    CaxOutBuffer* out = outBuffer();
+    size_t length = str ? strlen(str) : 0;
+
+    if (length + 1 > CAX_OUT_CAPACITY) {
+        /* Larger than the whole buffer: write it straight through */
+        flushBuffer(out);
+        writeAll(str, length);
+        reserve(out, 1);
+    } else {
+        char* dst = reserve(out, length + 1);
+        memcpy(dst, str, length);
+        out->length += length;
+    }
+    endLine(out);
+}
+
+void cax_flush(void) {
+    flushBuffer(&tlsOut);
+}
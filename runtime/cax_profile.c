@@ -0,0 +1,127 @@
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================
+ * PROFILE COUNTERS (--profile-generate)
+ * ============================================
+ *
+ * An instrumented program counts function entries and the way each
+ * if/while/for condition went, and main registers the table of those
+ * counters here. At exit the counts are added to the profile file, so
+ * several training runs accumulate into one profile; clangax
+ * --profile-use=<file> reads it back. The file is plain text, one site
+ * per line:
+ *
+ *   <function>:entry <count>
+ *   <function>:<if|while|for|range>@<line>.<n> <false count> <true count>
+ *
+ * where n numbers the branches of the same kind on that line. Lines
+ * starting with '#' are comments. The compiler escapes function names
+ * (%XX for whitespace, '%', ':', '#' and non-ASCII bytes), so a site name
+ * is always a single field; lines that do not parse are reported and
+ * left out of the merge.
+ */
+
+#define CAX_PROFILE_LINE 4096
+
+static CaxProfile* registered = NULL;
+
+static int compareSites(const void* a, const void* b) {
+    const CaxProfileSite* x = *(const CaxProfileSite* const*)a;
+    const CaxProfileSite* y = *(const CaxProfileSite* const*)b;
+    return strcmp(x->name, y->name);
+}
+
+/* Counts already in the file from earlier runs, added to ours. Sites the
+ * program no longer has are dropped. */
+static void mergeExisting(FILE* in, const char* path, const CaxProfileSite** sorted, int64_t count,
+                          int64_t* merged) {
+    char line[CAX_PROFILE_LINE];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char* name = strtok(line, " \t\n");
+        if (!name) continue;
+
+        /* <name> <count> or <name> <false count> <true count> */
+        int64_t counts[2];
+        int fields = 0;
+        int malformed = 0;
+        for (char* field; (field = strtok(NULL, " \t\n")) != NULL;) {
+            char* end;
+            long long value = strtoll(field, &end, 10);
+            if (*end != '\0' || value < 0 || fields == 2) {
+                malformed = 1;
+                break;
+            }
+            counts[fields++] = value;
+        }
+        if (malformed || fields == 0) {
+            fprintf(stderr, "C-Accel runtime: ignoring malformed line %d of profile %s\n", lineNumber, path);
+            continue;
+        }
+
+        CaxProfileSite key = {name, NULL, 0};
+        const CaxProfileSite* keyPtr = &key;
+        const CaxProfileSite** found = bsearch(&keyPtr, sorted, (size_t)count, sizeof(*sorted), compareSites);
+        if (!found || (*found)->edges != fields) continue;
+
+        int64_t index = (int64_t)(found - sorted);
+        for (int e = 0; e < fields; e++) {
+            merged[index * 2 + e] += counts[e];
+        }
+    }
+}
+
+static void writeProfile(void) {
+    CaxProfile* profile = registered;
+    if (!profile || profile->count <= 0) return;
+
+    const char* path = getenv("CAX_PROFILE_FILE");
+    if (!path || !*path) path = profile->path;
+
+    const CaxProfileSite** sorted = malloc((size_t)profile->count * sizeof(*sorted));
+    int64_t* merged = calloc((size_t)profile->count * 2, sizeof(int64_t));
+    if (!sorted || !merged) {
+        fprintf(stderr, "C-Accel runtime: out of memory writing profile %s\n", path);
+        free(sorted);
+        free(merged);
+        return;
+    }
+    for (int64_t i = 0; i < profile->count; i++) sorted[i] = &profile->sites[i];
+    qsort(sorted, (size_t)profile->count, sizeof(*sorted), compareSites);
+
+    FILE* in = fopen(path, "r");
+    if (in) {
+        mergeExisting(in, path, sorted, profile->count, merged);
+        fclose(in);
+    }
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "C-Accel runtime: cannot write profile %s\n", path);
+    } else {
+        fprintf(out, "# C-Accel profile: <site> <count> | <site> <false count> <true count>\n");
+        for (int64_t i = 0; i < profile->count; i++) {
+            const CaxProfileSite* site = sorted[i];
+            fprintf(out, "%s", site->name);
+            for (int64_t e = 0; e < site->edges && e < 2; e++) {
+                fprintf(out, " %lld", (long long)(merged[i * 2 + e] + site->counts[e]));
+            }
+            fputc('\n', out);
+        }
+        fclose(out);
+    }
+    free(sorted);
+    free(merged);
+}
+
+void cax_profile_register(CaxProfile* profile) {
+    if (registered) return;
+    registered = profile;
+    atexit(writeProfile);
+}
@@ -0,0 +1,220 @@
+#ifndef CLANGAX_RUNTIME_H
+#define CLANGAX_RUNTIME_H
+
+#include <stdint.h>
+
+/* ============================================
+ * C-ACCEL RUNTIME LIBRARY
+ * ============================================
+ *
+ * Support code linked into every program produced by clangax. The IR
+ * generator declares these functions by name, so their signatures are
+ * part of the compiler/runtime ABI: only use i32/i64/double/pointer
+ * parameters (no bool/char) so no sign/zero-extension attributes are
+ * needed on the IR side.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CAX_NORETURN __attribute__((noreturn))
+#else
+#define CAX_NORETURN
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --------------------------------------------
+ * Buffered output (cax_print.c)
+ * --------------------------------------------
+ * Each print() lowers to exactly one of these calls. Output is collected
+ * in a thread-local buffer and written with write(2) when the buffer is
+ * full, at thread exit and at process exit. When stdout is a terminal the
+ * buffer is flushed after every line, matching stdio's line buffering.
+ */
+void cax_print_i32(int32_t value);
+void cax_print_i64(int64_t value);
+void cax_print_f64(double value);
+void cax_print_char(int32_t value);
+void cax_print_bool(int32_t value);
+void cax_print_str(const char* str);
+void cax_flush(void);
+
+/* --------------------------------------------
+ * Growable vectors (cax_vector.c)
+ * --------------------------------------------
+ * Header of every vector<T>. The IR generator lays a vector out as this
+ * header immediately followed by CAX_VEC_INLINE_BYTES of inline storage
+ * (%cax.vec.<T> in the IR) and emits push/pop/get/set/size inline; the
+ * runtime only moves storage to the heap when it outgrows the inline
+ * buffer, and frees it when the owning function returns.
+ */
+#define CAX_VEC_INLINE_BYTES 64
+
+typedef struct {
+    void* data;         /* inline buffer (just past the header) or heap */
+    int64_t size;
+    int64_t capacity;
+} CaxVector;
+
+void cax_vec_grow(CaxVector* vec, int64_t elemSize, int64_t minCapacity);
+/* Frees heap storage and empties the vector onto its inline buffer, which
+ * holds inlineCapacity elements */
+void cax_vec_free(CaxVector* vec, int64_t inlineCapacity);
+
+/* Element storage of vector<Name> for a class Name: `count` heap columns,
+ * each 64-byte aligned and `columnSizes[k]` bytes per element. Vectors of
+ * records use one column of whole objects; structure-of-arrays vectors
+ * (vector<soa Name>, class(SoA)) one column per field. The IR generator
+ * indexes the columns inline; growth and cleanup come here. */
+typedef struct {
+    int64_t size;
+    int64_t capacity;
+    void* columns[];
+} CaxColumns;
+
+void cax_columns_grow(CaxColumns* vec, int32_t count, const int64_t* columnSizes, int64_t minCapacity);
+void cax_columns_free(CaxColumns* vec, int32_t count);
+
+/* Reports an out-of-range index (when bounds checks are enabled) and aborts */
+CAX_NORETURN void cax_bounds_fail(int64_t index, int64_t size);
+
+/* --------------------------------------------
+ * Class instance pools (cax_slab.c)
+ * --------------------------------------------
+ * Heap instances of a class come from that class's pool: the IR generator
+ * emits one zero-initialised CaxSlabPool per class (class.<Name>.pool)
+ * holding the instance size, constructors call cax_slab_alloc and the
+ * generated destructor Name::~Name calls cax_slab_free. Objects are
+ * handed out from a thread-local free list and move between threads and
+ * the pool in batches. Allocated objects are zero-filled.
+ */
+typedef struct {
+    int64_t objectSize;
+    void* state;        /* owned by the runtime; NULL until first use */
+} CaxSlabPool;
+
+void* cax_slab_alloc(CaxSlabPool* pool);
+void cax_slab_free(CaxSlabPool* pool, void* object);
+
+/* --------------------------------------------
+ * Profile counters (cax_profile.c)
+ * --------------------------------------------
+ * Programs built with --profile-generate keep one counter per function
+ * entry and two (false, true) per if/while/for condition, and register
+ * the table at the start of main. At exit the counts are added to the
+ * profile file (CAX_PROFILE_FILE in the environment overrides the path
+ * given at compile time) for --profile-use to read.
+ */
+typedef struct {
+    const char* name;   /* "<function>:entry" or "<function>:<kind>@<line>.<n>" */
+    int64_t* counts;
+    int64_t edges;      /* 1 (entry) or 2 (branch: false, true) */
+} CaxProfileSite;
+
+typedef struct {
+    int64_t count;
+    const CaxProfileSite* sites;
+    const char* path;
+} CaxProfile;
+
+void cax_profile_register(CaxProfile* profile);
+
+/* --------------------------------------------
+ * Function instrumentation (cax_instrument.c)
+ * --------------------------------------------
+ * --instrument=functions: main registers the table of instrumented
+ * functions, each of which calls cax_func_enter(id) on entry and
+ * cax_func_exit(id) before returning, id being its index in the table.
+ * Calls and inclusive/exclusive time are kept per thread and reported at
+ * exit and on SIGUSR1 (stderr, or CAX_INSTRUMENT_OUTPUT; JSON for a
+ * file name ending in .json).
+ */
+typedef struct {
+    const char* name;
+    int64_t line;
+} CaxInstrumentedFunction;
+
+typedef struct {
+    int64_t count;
+    const CaxInstrumentedFunction* functions;
+} CaxFunctionTable;
+
+void cax_instrument_functions(CaxFunctionTable* table);
+void cax_func_enter(int32_t id);
+void cax_func_exit(int32_t id);
+
+/* --instrument=loops,branches: a counter block per loop and if statement,
+ * keyed by source line and registered by main the same way. Loops keep
+ * {runs, total trips, min trips, max trips} (min starts at INT64_MAX) and
+ * report each run's iteration count with cax_loop_exit; ifs keep
+ * {not taken, taken}, updated inline. Reported with the functions. */
+#define CAX_SITE_LOOP 0
+#define CAX_SITE_BRANCH 1
+
+typedef struct {
+    const char* function;
+    int64_t line;
+    int64_t kind;       /* CAX_SITE_LOOP or CAX_SITE_BRANCH */
+    int64_t* counts;
+} CaxInstrumentedSite;
+
+typedef struct {
+    int64_t count;
+    const CaxInstrumentedSite* sites;
+} CaxSiteTable;
+
+void cax_instrument_sites(CaxSiteTable* table);
+void cax_loop_exit(int64_t* counts, int64_t trips);
+
+/* --------------------------------------------
+ * Tensor kernels (cax_tensor.c)
+ * --------------------------------------------
+ * Built-in numeric kernels behind dot(), axpy(), matmul(), vadd() ...
+ * in .cax code. Operands are contiguous row-major double buffers (float
+ * arrays and vector<float>). Each call runs the AVX-512, AVX2+FMA or
+ * portable version, chosen once per process from the CPU's features.
+ */
+double cax_dot_f64(const double* x, const double* y, int64_t n);
+void cax_axpy_f64(int64_t n, double alpha, const double* x, double* y);   /* y += alpha * x */
+void cax_matmul_f64(const double* a, const double* b, double* c,
+                    int64_t m, int64_t k, int64_t n);                      /* C[m x n] = A[m x k] * B[k x n]; C may be A or B */
+void cax_add_f64(const double* x, const double* y, double* out, int64_t n);
+void cax_sub_f64(const double* x, const double* y, double* out, int64_t n);
+void cax_mul_f64(const double* x, const double* y, double* out, int64_t n);
+void cax_div_f64(const double* x, const double* y, double* out, int64_t n);
+double cax_sum_f64(const double* x, int64_t n);
+double cax_max_f64(const double* x, int64_t n);
+double cax_min_f64(const double* x, int64_t n);
+
+/* Name of the kernel set in use: "avx512", "avx2" or "generic" */
+const char* cax_tensor_isa(void);
+
+/* Reports a matmul operand smaller than its m/k/n sizes and aborts */
+CAX_NORETURN void cax_tensor_shape_fail(int64_t needed, int64_t available);
+
+/* --------------------------------------------
+ * Parallel loops (cax_parallel.c)
+ * --------------------------------------------
+ * exec(threads=N, fraction) lowers to one cax_parallel_configure call at
+ * the start of main. Loops the compiler proves independent are outlined
+ * into a CaxLoopBody and run by cax_parallel_for on a work-stealing pool
+ * of N threads (the caller included), in chunks of about
+ * fraction * iterations / N. CAX_THREADS=n in the environment overrides N.
+ *
+ * exec(cpu=C, weight) adds a cax_parallel_cpu_budget call after it: the
+ * pool is capped at weight * C usable CPUs (C = 0: all of them) and the
+ * cgroup CPU quota, and the budget is reported on stderr. The threads are
+ * left unpinned within the process's affinity mask.
+ */
+typedef void (*CaxLoopBody)(int64_t begin, int64_t end, void* env);
+
+void cax_parallel_configure(int32_t threads, double fraction);
+void cax_parallel_cpu_budget(int32_t cpus, double weight);
+void cax_parallel_for(int64_t begin, int64_t end, CaxLoopBody body, void* env);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLANGAX_RUNTIME_H */
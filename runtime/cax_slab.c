@@ -0,0 +1,263 @@
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/* ============================================
+ * SLAB ALLOCATOR FOR CLASS INSTANCES
+ * ============================================
+ *
+ * Heap objects of a class all have the same size, so each class gets its
+ * own pool (a CaxSlabPool emitted by the IR generator) instead of going
+ * through malloc. A pool carves 64 KiB slabs into objects and hands them
+ * out in batches of CAX_SLAB_BATCH:
+ *
+ *   - every thread keeps a free list per pool; alloc and free only touch
+ *     this list, without locks or atomics;
+ *   - an empty list takes one whole batch from the pool (one lock);
+ *   - a list holding two batches gives one back (one lock), so a thread
+ *     that frees what another allocated does not hoard memory;
+ *   - at thread exit the lists go back to their pools.
+ *
+ * Free objects are linked through their first word; the first object of
+ * a batch parked in the pool links to the next batch through its second
+ * word, which is why objects are at least 16 bytes. Slabs are never
+ * returned to the system: memory a class has used stays available to it.
+ */
+
+#define CAX_SLAB_BYTES (64 * 1024)
+#define CAX_SLAB_ALIGN 64
+#define CAX_SLAB_BATCH 64
+
+static CAX_NORETURN void slabOutOfMemory(int64_t bytes) {
+    cax_flush();
+    fprintf(stderr, "C-Accel runtime: out of memory allocating a %lld byte object slab\n",
+            (long long)bytes);
+    abort();
+}
+
+#ifndef _WIN32
+
+typedef struct FreeObject {
+    struct FreeObject* next;        /* next object of the same list/batch */
+    struct FreeObject* nextBatch;   /* first object of a parked batch only */
+} FreeObject;
+
+typedef struct {
+    int64_t objectSize;       /* rounded up to 16 bytes */
+    int32_t id;               /* index into each thread's cache table */
+    pthread_mutex_t lock;     /* guards everything below */
+    FreeObject* batches;      /* full batches of CAX_SLAB_BATCH objects */
+    FreeObject* loose;        /* partial batches returned at thread exit */
+    char* bump;               /* uncarved part of the newest slab */
+    char* bumpEnd;
+} SlabState;
+
+typedef struct {
+    SlabState* state;
+    FreeObject* head;
+    int64_t count;
+} ThreadCache;
+
+typedef struct {
+    ThreadCache* caches;      /* indexed by SlabState::id */
+    int32_t capacity;
+    int registered;
+} ThreadCaches;
+
+static _Thread_local ThreadCaches tlsCaches;
+
+static pthread_mutex_t poolsLock = PTHREAD_MUTEX_INITIALIZER;
+static int32_t poolCount = 0;
+
+/* --------------------------------------------
+ * Pool setup and thread exit
+ * -------------------------------------------- */
+
+static pthread_key_t cacheKey;
+static pthread_once_t cacheOnce = PTHREAD_ONCE_INIT;
+
+static void parkLoose(SlabState* state, FreeObject* head) {
+    while (head) {
+        FreeObject* next = head->next;
+        head->next = state->loose;
+        state->loose = head;
+        head = next;
+    }
+}
+
+static void releaseAtThreadExit(void* tables) {
+    ThreadCaches* own = (ThreadCaches*)tables;
+    for (int32_t i = 0; i < own->capacity; i++) {
+        ThreadCache* cache = &own->caches[i];
+        if (!cache->state || !cache->head) continue;
+        pthread_mutex_lock(&cache->state->lock);
+        parkLoose(cache->state, cache->head);
+        pthread_mutex_unlock(&cache->state->lock);
+    }
+    free(own->caches);
+    own->caches = NULL;
+    own->capacity = 0;
+    own->registered = 0;
+}
+
+static void initCacheKey(void) {
+    pthread_key_create(&cacheKey, releaseAtThreadExit);
+}
+
+static SlabState* poolState(CaxSlabPool* pool) {
+    SlabState* state = __atomic_load_n(&pool->state, __ATOMIC_ACQUIRE);
+    if (state) return state;
+
+    pthread_mutex_lock(&poolsLock);
+    state = (SlabState*)pool->state;
+    if (!state) {
+        state = calloc(1, sizeof(SlabState));
+        if (!state) slabOutOfMemory((int64_t)sizeof(SlabState));
+        int64_t size = pool->objectSize < 16 ? 16 : pool->objectSize;
+        state->objectSize = (size + 15) & ~(int64_t)15;
+        state->id = poolCount++;
+        pthread_mutex_init(&state->lock, NULL);
+        __atomic_store_n(&pool->state, (void*)state, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&poolsLock);
+    return state;
+}
+
+static ThreadCache* threadCache(SlabState* state) {
+    ThreadCaches* own = &tlsCaches;
+    if (state->id >= own->capacity) {
+        int32_t capacity = own->capacity > 0 ? own->capacity * 2 : 8;
+        while (capacity <= state->id) capacity *= 2;
+        ThreadCache* caches = realloc(own->caches, (size_t)capacity * sizeof(ThreadCache));
+        if (!caches) slabOutOfMemory((int64_t)capacity * (int64_t)sizeof(ThreadCache));
+        memset(caches + own->capacity, 0, (size_t)(capacity - own->capacity) * sizeof(ThreadCache));
+        own->caches = caches;
+        own->capacity = capacity;
+    }
+    if (!own->registered) {
+        pthread_once(&cacheOnce, initCacheKey);
+        pthread_setspecific(cacheKey, own);
+        own->registered = 1;
+    }
+    ThreadCache* cache = &own->caches[state->id];
+    cache->state = state;
+    return cache;
+}
+
+/* --------------------------------------------
+ * Batches
+ * -------------------------------------------- */
+
+/* Links up to CAX_SLAB_BATCH fresh objects from the slab; caller holds the lock */
+static FreeObject* carveBatch(SlabState* state, int64_t* count) {
+    int64_t size = state->objectSize;
+    if (state->bumpEnd - state->bump < size) {
+        int64_t bytes = CAX_SLAB_BYTES;
+        if (bytes < size * CAX_SLAB_BATCH) bytes = size * CAX_SLAB_BATCH;
+        bytes = (bytes + CAX_SLAB_ALIGN - 1) / CAX_SLAB_ALIGN * CAX_SLAB_ALIGN;
+        char* slab = aligned_alloc(CAX_SLAB_ALIGN, (size_t)bytes);
+        if (!slab) slabOutOfMemory(bytes);
+        state->bump = slab;
+        state->bumpEnd = slab + bytes;
+    }
+
+    int64_t available = (state->bumpEnd - state->bump) / size;
+    int64_t n = available < CAX_SLAB_BATCH ? available : CAX_SLAB_BATCH;
+    FreeObject* head = (FreeObject*)state->bump;
+    for (int64_t i = 0; i < n; i++) {
+        FreeObject* object = (FreeObject*)(state->bump + i * size);
+        object->next = i + 1 < n ? (FreeObject*)(state->bump + (i + 1) * size) : NULL;
+    }
+    state->bump += n * size;
+    *count = n;
+    return head;
+}
+
+static void refill(SlabState* state, ThreadCache* cache) {
+    pthread_mutex_lock(&state->lock);
+    if (state->batches) {
+        FreeObject* batch = state->batches;
+        state->batches = batch->nextBatch;
+        cache->head = batch;
+        cache->count = CAX_SLAB_BATCH;
+    } else if (state->loose) {
+        FreeObject* head = state->loose;
+        FreeObject* tail = head;
+        int64_t n = 1;
+        while (n < CAX_SLAB_BATCH && tail->next) {
+            tail = tail->next;
+            n++;
+        }
+        state->loose = tail->next;
+        tail->next = NULL;
+        cache->head = head;
+        cache->count = n;
+    } else {
+        cache->head = carveBatch(state, &cache->count);
+    }
+    pthread_mutex_unlock(&state->lock);
+}
+
+/* Moves the first CAX_SLAB_BATCH objects of the cache back to the pool */
+static void returnBatch(SlabState* state, ThreadCache* cache) {
+    FreeObject* batch = cache->head;
+    FreeObject* tail = batch;
+    for (int i = 1; i < CAX_SLAB_BATCH; i++) tail = tail->next;
+    cache->head = tail->next;
+    cache->count -= CAX_SLAB_BATCH;
+    tail->next = NULL;
+
+    pthread_mutex_lock(&state->lock);
+    batch->nextBatch = state->batches;
+    state->batches = batch;
+    pthread_mutex_unlock(&state->lock);
+}
+
+/* --------------------------------------------
+ * Public entry points
+ * -------------------------------------------- */
+
+void* cax_slab_alloc(CaxSlabPool* pool) {
+    SlabState* state = poolState(pool);
+    ThreadCache* cache = threadCache(state);
+    if (!cache->head) refill(state, cache);
+
+    FreeObject* object = cache->head;
+    cache->head = object->next;
+    cache->count--;
+    memset(object, 0, (size_t)state->objectSize);
+    return object;
+}
+
+void cax_slab_free(CaxSlabPool* pool, void* object) {
+    if (!object) return;
+    SlabState* state = poolState(pool);
+    ThreadCache* cache = threadCache(state);
+
+    FreeObject* freed = (FreeObject*)object;
+    freed->next = cache->head;
+    cache->head = freed;
+    if (++cache->count >= 2 * CAX_SLAB_BATCH) returnBatch(state, cache);
+}
+
+#else
+
+/* No thread-exit hooks to hand caches back: use the C heap */
+void* cax_slab_alloc(CaxSlabPool* pool) {
+    void* object = calloc(1, (size_t)(pool->objectSize > 0 ? pool->objectSize : 1));
+    if (!object) slabOutOfMemory(pool->objectSize);
+    return object;
+}
+
+void cax_slab_free(CaxSlabPool* pool, void* object) {
+    (void)pool;
+    free(object);
+}
+
+#endif
@@ -0,0 +1,537 @@
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CAX_TENSOR_X86 1
+#include <immintrin.h>
+#define CAX_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* ============================================
+ * TENSOR KERNELS
+ * ============================================
+ *
+ * dot/axpy/matmul/elementwise/reductions on contiguous double buffers.
+ * Every kernel exists in a portable version plus AVX2+FMA and AVX-512F
+ * versions on x86; the widest one the CPU supports is picked on first use
+ * (override with CAX_TENSOR_ISA=generic|avx2|avx512).
+ *
+ * matmul is blocked for the caches: C is computed in MC x NC tiles, each
+ * accumulated over KC-deep slices of A and B so the B slice stays in L2
+ * and the A rows in L1, and every tile is built from register-blocked
+ * micro-kernels (MR x NR accumulators kept in vector registers).
+ */
+
+#define CAX_MC 64      /* rows of A per block */
+#define CAX_KC 256     /* shared dimension per block */
+#define CAX_NC 256     /* columns of B per block */
+
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV };
+enum { RED_SUM, RED_MAX, RED_MIN };
+
+/* C[MR x NR] += A[MR x kc] * B[kc x NR] (row-major, leading dimensions given) */
+typedef void (*MicroKernel)(int64_t kc, const double* a, int64_t lda,
+                            const double* b, int64_t ldb, double* c, int64_t ldc);
+
+typedef struct {
+    const char* name;
+    double (*dot)(const double* x, const double* y, int64_t n);
+    void (*axpy)(int64_t n, double alpha, const double* x, double* y);
+    void (*elementwise)(int op, const double* x, const double* y, double* out, int64_t n);
+    double (*reduce)(int op, const double* x, int64_t n);
+    MicroKernel kernel;
+    int64_t mr, nr;
+} TensorIsa;
+
+/* --------------------------------------------
+ * Portable kernels
+ * -------------------------------------------- */
+
+static double applyOp(int op, double x, double y) {
+    switch (op) {
+        case OP_ADD: return x + y;
+        case OP_SUB: return x - y;
+        case OP_MUL: return x * y;
+        default: return x / y;
+    }
+}
+
+static double genericDot(const double* x, const double* y, int64_t n) {
+    double acc[4] = {0, 0, 0, 0};
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += x[i] * y[i];
+        acc[1] += x[i + 1] * y[i + 1];
+        acc[2] += x[i + 2] * y[i + 2];
+        acc[3] += x[i + 3] * y[i + 3];
+    }
+    for (; i < n; i++) acc[0] += x[i] * y[i];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+static void genericAxpy(int64_t n, double alpha, const double* x, double* y) {
+    for (int64_t i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+static void genericElementwise(int op, const double* x, const double* y, double* out, int64_t n) {
+    for (int64_t i = 0; i < n; i++) out[i] = applyOp(op, x[i], y[i]);
+}
+
+static double genericReduce(int op, const double* x, int64_t n) {
+    if (op == RED_SUM) {
+        double acc[4] = {0, 0, 0, 0};
+        int64_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            acc[0] += x[i];
+            acc[1] += x[i + 1];
+            acc[2] += x[i + 2];
+            acc[3] += x[i + 3];
+        }
+        for (; i < n; i++) acc[0] += x[i];
+        return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+    double best = x[0];
+    for (int64_t i = 1; i < n; i++) {
+        if (op == RED_MAX ? x[i] > best : x[i] < best) best = x[i];
+    }
+    return best;
+}
+
+static void genericKernel(int64_t kc, const double* a, int64_t lda,
+                          const double* b, int64_t ldb, double* c, int64_t ldc) {
+    double acc[4][4] = {{0}};
+    for (int64_t p = 0; p < kc; p++) {
+        for (int r = 0; r < 4; r++) {
+            double ar = a[r * lda + p];
+            for (int j = 0; j < 4; j++) acc[r][j] += ar * b[p * ldb + j];
+        }
+    }
+    for (int r = 0; r < 4; r++) {
+        for (int j = 0; j < 4; j++) c[r * ldc + j] += acc[r][j];
+    }
+}
+
+/* Partial tiles at the matrix edges */
+static void edgeKernel(int64_t mr, int64_t nr, int64_t kc, const double* a, int64_t lda,
+                       const double* b, int64_t ldb, double* c, int64_t ldc) {
+    for (int64_t r = 0; r < mr; r++) {
+        for (int64_t p = 0; p < kc; p++) {
+            double ar = a[r * lda + p];
+            for (int64_t j = 0; j < nr; j++) c[r * ldc + j] += ar * b[p * ldb + j];
+        }
+    }
+}
+
+static const TensorIsa genericIsa = {
+    "generic", genericDot, genericAxpy, genericElementwise, genericReduce, genericKernel, 4, 4
+};
+
+#ifdef CAX_TENSOR_X86
+
+/* --------------------------------------------
+ * AVX2 + FMA kernels (4 doubles per register)
+ * -------------------------------------------- */
+
+CAX_TARGET("avx2,fma")
+static double hsum256(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+CAX_TARGET("avx2,fma")
+static double avx2Dot(const double* x, const double* y, int64_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    int64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), acc3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+    }
+    double sum = hsum256(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+    for (; i < n; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+CAX_TARGET("avx2,fma")
+static void avx2Axpy(int64_t n, double alpha, const double* x, double* y) {
+    __m256d va = _mm256_set1_pd(alpha);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+CAX_TARGET("avx2,fma")
+static void avx2Elementwise(int op, const double* x, const double* y, double* out, int64_t n) {
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i), r;
+        switch (op) {
+            case OP_ADD: r = _mm256_add_pd(vx, vy); break;
+            case OP_SUB: r = _mm256_sub_pd(vx, vy); break;
+            case OP_MUL: r = _mm256_mul_pd(vx, vy); break;
+            default: r = _mm256_div_pd(vx, vy); break;
+        }
+        _mm256_storeu_pd(out + i, r);
+    }
+    for (; i < n; i++) out[i] = applyOp(op, x[i], y[i]);
+}
+
+CAX_TARGET("avx2,fma")
+static double avx2Reduce(int op, const double* x, int64_t n) {
+    if (n < 8) return genericReduce(op, x, n);
+
+    __m256d acc0 = _mm256_loadu_pd(x), acc1 = _mm256_loadu_pd(x + 4);
+    int64_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m256d v0 = _mm256_loadu_pd(x + i), v1 = _mm256_loadu_pd(x + i + 4);
+        switch (op) {
+            case RED_SUM: acc0 = _mm256_add_pd(acc0, v0); acc1 = _mm256_add_pd(acc1, v1); break;
+            case RED_MAX: acc0 = _mm256_max_pd(acc0, v0); acc1 = _mm256_max_pd(acc1, v1); break;
+            default: acc0 = _mm256_min_pd(acc0, v0); acc1 = _mm256_min_pd(acc1, v1); break;
+        }
+    }
+
+    double lanes[8];
+    _mm256_storeu_pd(lanes, acc0);
+    _mm256_storeu_pd(lanes + 4, acc1);
+    double result = genericReduce(op, lanes, 8);
+    if (i == n) return result;
+
+    double tail = genericReduce(op, x + i, n - i);
+    switch (op) {
+        case RED_SUM: return result + tail;
+        case RED_MAX: return tail > result ? tail : result;
+        default: return tail < result ? tail : result;
+    }
+}
+
+/* 4 x 8 tile: 8 accumulators, two B loads and four broadcasts per step */
+CAX_TARGET("avx2,fma")
+static void avx2Kernel(int64_t kc, const double* a, int64_t lda,
+                       const double* b, int64_t ldb, double* c, int64_t ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+    for (int64_t p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_loadu_pd(b + p * ldb);
+        __m256d b1 = _mm256_loadu_pd(b + p * ldb + 4);
+        __m256d a0 = _mm256_broadcast_sd(a + p);
+        __m256d a1 = _mm256_broadcast_sd(a + lda + p);
+        __m256d a2 = _mm256_broadcast_sd(a + 2 * lda + p);
+        __m256d a3 = _mm256_broadcast_sd(a + 3 * lda + p);
+        c00 = _mm256_fmadd_pd(a0, b0, c00); c01 = _mm256_fmadd_pd(a0, b1, c01);
+        c10 = _mm256_fmadd_pd(a1, b0, c10); c11 = _mm256_fmadd_pd(a1, b1, c11);
+        c20 = _mm256_fmadd_pd(a2, b0, c20); c21 = _mm256_fmadd_pd(a2, b1, c21);
+        c30 = _mm256_fmadd_pd(a3, b0, c30); c31 = _mm256_fmadd_pd(a3, b1, c31);
+    }
+
+    _mm256_storeu_pd(c, _mm256_add_pd(_mm256_loadu_pd(c), c00));
+    _mm256_storeu_pd(c + 4, _mm256_add_pd(_mm256_loadu_pd(c + 4), c01));
+    _mm256_storeu_pd(c + ldc, _mm256_add_pd(_mm256_loadu_pd(c + ldc), c10));
+    _mm256_storeu_pd(c + ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + ldc + 4), c11));
+    _mm256_storeu_pd(c + 2 * ldc, _mm256_add_pd(_mm256_loadu_pd(c + 2 * ldc), c20));
+    _mm256_storeu_pd(c + 2 * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + 2 * ldc + 4), c21));
+    _mm256_storeu_pd(c + 3 * ldc, _mm256_add_pd(_mm256_loadu_pd(c + 3 * ldc), c30));
+    _mm256_storeu_pd(c + 3 * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + 3 * ldc + 4), c31));
+}
+
+static const TensorIsa avx2Isa = {
+    "avx2", avx2Dot, avx2Axpy, avx2Elementwise, avx2Reduce, avx2Kernel, 4, 8
+};
+
+/* --------------------------------------------
+ * AVX-512F kernels (8 doubles per register)
+ * -------------------------------------------- */
+
+CAX_TARGET("avx512f")
+static double avx512Dot(const double* x, const double* y, int64_t n) {
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+    int64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+        acc2 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 16), _mm512_loadu_pd(y + i + 16), acc2);
+        acc3 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 24), _mm512_loadu_pd(y + i + 24), acc3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+    }
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), acc1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+}
+
+CAX_TARGET("avx512f")
+static void avx512Axpy(int64_t n, double alpha, const double* x, double* y) {
+    __m512d va = _mm512_set1_pd(alpha);
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+    }
+    if (i < n) {
+        __mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+        __m512d r = _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+        _mm512_mask_storeu_pd(y + i, mask, r);
+    }
+}
+
+CAX_TARGET("avx512f")
+static void avx512Elementwise(int op, const double* x, const double* y, double* out, int64_t n) {
+    int64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d vx = _mm512_loadu_pd(x + i), vy = _mm512_loadu_pd(y + i), r;
+        switch (op) {
+            case OP_ADD: r = _mm512_add_pd(vx, vy); break;
+            case OP_SUB: r = _mm512_sub_pd(vx, vy); break;
+            case OP_MUL: r = _mm512_mul_pd(vx, vy); break;
+            default: r = _mm512_div_pd(vx, vy); break;
+        }
+        _mm512_storeu_pd(out + i, r);
+    }
+    for (; i < n; i++) out[i] = applyOp(op, x[i], y[i]);
+}
+
+CAX_TARGET("avx512f")
+static double avx512Reduce(int op, const double* x, int64_t n) {
+    if (n < 8) return genericReduce(op, x, n);
+
+    __m512d acc = _mm512_loadu_pd(x);
+    int64_t i = 8;
+    for (; i + 8 <= n; i += 8) {
+        __m512d v = _mm512_loadu_pd(x + i);
+        switch (op) {
+            case RED_SUM: acc = _mm512_add_pd(acc, v); break;
+            case RED_MAX: acc = _mm512_max_pd(acc, v); break;
+            default: acc = _mm512_min_pd(acc, v); break;
+        }
+    }
+
+    double result;
+    switch (op) {
+        case RED_SUM: result = _mm512_reduce_add_pd(acc); break;
+        case RED_MAX: result = _mm512_reduce_max_pd(acc); break;
+        default: result = _mm512_reduce_min_pd(acc); break;
+    }
+    if (i == n) return result;
+
+    double tail = genericReduce(op, x + i, n - i);
+    switch (op) {
+        case RED_SUM: return result + tail;
+        case RED_MAX: return tail > result ? tail : result;
+        default: return tail < result ? tail : result;
+    }
+}
+
+/* 4 x 16 tile: 8 zmm accumulators */
+CAX_TARGET("avx512f")
+static void avx512Kernel(int64_t kc, const double* a, int64_t lda,
+                         const double* b, int64_t ldb, double* c, int64_t ldc) {
+    __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+    __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+    __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+    __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+
+    for (int64_t p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_loadu_pd(b + p * ldb);
+        __m512d b1 = _mm512_loadu_pd(b + p * ldb + 8);
+        __m512d a0 = _mm512_set1_pd(a[p]);
+        __m512d a1 = _mm512_set1_pd(a[lda + p]);
+        __m512d a2 = _mm512_set1_pd(a[2 * lda + p]);
+        __m512d a3 = _mm512_set1_pd(a[3 * lda + p]);
+        c00 = _mm512_fmadd_pd(a0, b0, c00); c01 = _mm512_fmadd_pd(a0, b1, c01);
+        c10 = _mm512_fmadd_pd(a1, b0, c10); c11 = _mm512_fmadd_pd(a1, b1, c11);
+        c20 = _mm512_fmadd_pd(a2, b0, c20); c21 = _mm512_fmadd_pd(a2, b1, c21);
+        c30 = _mm512_fmadd_pd(a3, b0, c30); c31 = _mm512_fmadd_pd(a3, b1, c31);
+    }
+
+    _mm512_storeu_pd(c, _mm512_add_pd(_mm512_loadu_pd(c), c00));
+    _mm512_storeu_pd(c + 8, _mm512_add_pd(_mm512_loadu_pd(c + 8), c01));
+    _mm512_storeu_pd(c + ldc, _mm512_add_pd(_mm512_loadu_pd(c + ldc), c10));
+    _mm512_storeu_pd(c + ldc + 8, _mm512_add_pd(_mm512_loadu_pd(c + ldc + 8), c11));
+    _mm512_storeu_pd(c + 2 * ldc, _mm512_add_pd(_mm512_loadu_pd(c + 2 * ldc), c20));
+    _mm512_storeu_pd(c + 2 * ldc + 8, _mm512_add_pd(_mm512_loadu_pd(c + 2 * ldc + 8), c21));
+    _mm512_storeu_pd(c + 3 * ldc, _mm512_add_pd(_mm512_loadu_pd(c + 3 * ldc), c30));
+    _mm512_storeu_pd(c + 3 * ldc + 8, _mm512_add_pd(_mm512_loadu_pd(c + 3 * ldc + 8), c31));
+}
+
+static const TensorIsa avx512Isa = {
+    "avx512", avx512Dot, avx512Axpy, avx512Elementwise, avx512Reduce, avx512Kernel, 4, 16
+};
+
+#endif /* CAX_TENSOR_X86 */
+
+/* --------------------------------------------
+ * Dispatch
+ * -------------------------------------------- */
+
+static const TensorIsa* selectedIsa = NULL;
+
+static void selectIsa(void) {
+    const TensorIsa* best = &genericIsa;
+#ifdef CAX_TENSOR_X86
+    __builtin_cpu_init();
+    int hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    int hasAvx512 = __builtin_cpu_supports("avx512f");
+    if (hasAvx512) best = &avx512Isa;
+    else if (hasAvx2) best = &avx2Isa;
+
+    const char* forced = getenv("CAX_TENSOR_ISA");
+    if (forced) {
+        if (strcmp(forced, "generic") == 0) best = &genericIsa;
+        else if (strcmp(forced, "avx2") == 0 && hasAvx2) best = &avx2Isa;
+        else if (strcmp(forced, "avx512") == 0 && hasAvx512) best = &avx512Isa;
+    }
+#endif
+    selectedIsa = best;
+}
+
+#ifndef _WIN32
+static pthread_once_t isaOnce = PTHREAD_ONCE_INIT;
+#endif
+
+static const TensorIsa* isa(void) {
+#ifndef _WIN32
+    pthread_once(&isaOnce, selectIsa);
+#else
+    if (!selectedIsa) selectIsa();
+#endif
+    return selectedIsa;
+}
+
+/* --------------------------------------------
+ * Matrix multiply
+ * -------------------------------------------- */
+
+/* Blocked product; C is cleared first, so it must not overlap A or B */
+static void matmulBlocked(const double* a, const double* b, double* c, int64_t m, int64_t k, int64_t n) {
+    for (int64_t i = 0; i < m; i++) memset(c + i * n, 0, (size_t)n * sizeof(double));
+    if (k <= 0) return;
+
+    const TensorIsa* impl = isa();
+    int64_t mr = impl->mr, nr = impl->nr;
+
+    for (int64_t jc = 0; jc < n; jc += CAX_NC) {
+        int64_t nc = n - jc < CAX_NC ? n - jc : CAX_NC;
+        for (int64_t pc = 0; pc < k; pc += CAX_KC) {
+            int64_t kc = k - pc < CAX_KC ? k - pc : CAX_KC;
+            for (int64_t ic = 0; ic < m; ic += CAX_MC) {
+                int64_t mc = m - ic < CAX_MC ? m - ic : CAX_MC;
+
+                for (int64_t i = 0; i < mc; i += mr) {
+                    for (int64_t j = 0; j < nc; j += nr) {
+                        const double* ablk = a + (ic + i) * k + pc;
+                        const double* bblk = b + pc * n + jc + j;
+                        double* cblk = c + (ic + i) * n + jc + j;
+                        if (i + mr <= mc && j + nr <= nc) {
+                            impl->kernel(kc, ablk, k, bblk, n, cblk, n);
+                        } else {
+                            int64_t rows = mc - i < mr ? mc - i : mr;
+                            int64_t cols = nc - j < nr ? nc - j : nr;
+                            edgeKernel(rows, cols, kc, ablk, k, bblk, n, cblk, n);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static int overlaps(const double* x, int64_t xCount, const double* y, int64_t yCount) {
+    uintptr_t xBegin = (uintptr_t)x, xEnd = (uintptr_t)(x + xCount);
+    uintptr_t yBegin = (uintptr_t)y, yEnd = (uintptr_t)(y + yCount);
+    return xBegin < yEnd && yBegin < xEnd;
+}
+
+/* --------------------------------------------
+ * Public entry points
+ * -------------------------------------------- */
+
+const char* cax_tensor_isa(void) {
+    return isa()->name;
+}
+
+void cax_tensor_shape_fail(int64_t needed, int64_t available) {
+    cax_flush();
+    fprintf(stderr, "C-Accel runtime: tensor operand has %lld elements but the shape needs %lld\n",
+            (long long)available, (long long)needed);
+    abort();
+}
+
+double cax_dot_f64(const double* x, const double* y, int64_t n) {
+    return n > 0 ? isa()->dot(x, y, n) : 0.0;
+}
+
+void cax_axpy_f64(int64_t n, double alpha, const double* x, double* y) {
+    if (n > 0) isa()->axpy(n, alpha, x, y);
+}
+
+void cax_add_f64(const double* x, const double* y, double* out, int64_t n) {
+    if (n > 0) isa()->elementwise(OP_ADD, x, y, out, n);
+}
+
+void cax_sub_f64(const double* x, const double* y, double* out, int64_t n) {
+    if (n > 0) isa()->elementwise(OP_SUB, x, y, out, n);
+}
+
+void cax_mul_f64(const double* x, const double* y, double* out, int64_t n) {
+    if (n > 0) isa()->elementwise(OP_MUL, x, y, out, n);
+}
+
+void cax_div_f64(const double* x, const double* y, double* out, int64_t n) {
+    if (n > 0) isa()->elementwise(OP_DIV, x, y, out, n);
+}
+
+double cax_sum_f64(const double* x, int64_t n) {
+    return n > 0 ? isa()->reduce(RED_SUM, x, n) : 0.0;
+}
+
+double cax_max_f64(const double* x, int64_t n) {
+    return n > 0 ? isa()->reduce(RED_MAX, x, n) : 0.0;
+}
+
+double cax_min_f64(const double* x, int64_t n) {
+    return n > 0 ? isa()->reduce(RED_MIN, x, n) : 0.0;
+}
+
+void cax_matmul_f64(const double* a, const double* b, double* c, int64_t m, int64_t k, int64_t n) {
+    if (m <= 0 || n <= 0) return;
+    if (k <= 0 || (!overlaps(c, m * n, a, m * k) && !overlaps(c, m * n, b, k * n))) {
+        matmulBlocked(a, b, c, m, k, n);
+        return;
+    }
+
+    /* C shares storage with an operand (matmul(a, b, a)): build the result
+     * aside and copy it over once A and B have been read */
+    size_t bytes = (size_t)(m * n) * sizeof(double);
+    double* result = malloc(bytes);
+    if (!result) {
+        cax_flush();
+        fprintf(stderr, "C-Accel runtime: out of memory for a %lld x %lld matmul result\n",
+                (long long)m, (long long)n);
+        abort();
+    }
+    matmulBlocked(a, b, result, m, k, n);
+    memcpy(c, result, bytes);
+    free(result);
+}
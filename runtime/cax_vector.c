@@ -0,0 +1,102 @@
+#include "cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================
+ * VECTOR RUNTIME (slow paths)
+ * ============================================
+ *
+ * The fast paths (push into spare capacity, indexed get/set, pop, size)
+ * are emitted inline by the IR generator for each element type. Only
+ * growth and cleanup come here, so this code is element-type agnostic
+ * and works in bytes.
+ */
+
+/* The inline buffer starts right after the header (all element types have
+ * alignment <= 8, so there is no padding between them in %cax.vec.<T>) */
+static void* inlineStorage(CaxVector* vec) {
+    return (void*)(vec + 1);
+}
+
+static CAX_NORETURN void outOfMemory(int64_t bytes) {
+    cax_flush();
+    fprintf(stderr, "C-Accel runtime: out of memory growing vector to %lld bytes\n",
+            (long long)bytes);
+    abort();
+}
+
+void cax_vec_grow(CaxVector* vec, int64_t elemSize, int64_t minCapacity) {
+    /* Geometric growth keeps push amortised O(1) */
+    int64_t capacity = vec->capacity > 0 ? vec->capacity * 2 : 8;
+    if (capacity < minCapacity) capacity = minCapacity;
+
+    if (capacity > INT64_MAX / elemSize) outOfMemory(INT64_MAX);
+    int64_t bytes = capacity * elemSize;
+
+    void* data;
+    if (vec->data == inlineStorage(vec)) {
+        /* First spill out of the small buffer */
+        data = malloc((size_t)bytes);
+        if (!data) outOfMemory(bytes);
+        memcpy(data, vec->data, (size_t)(vec->size * elemSize));
+    } else {
+        data = realloc(vec->data, (size_t)bytes);
+        if (!data) outOfMemory(bytes);
+    }
+
+    vec->data = data;
+    vec->capacity = capacity;
+}
+
+void cax_vec_free(CaxVector* vec, int64_t inlineCapacity) {
+    if (vec->data != inlineStorage(vec)) {
+        free(vec->data);
+    }
+    /* Back to the state the vector started in: the inline fast path only
+     * checks size < capacity, so the heap capacity must not survive */
+    vec->data = inlineStorage(vec);
+    vec->size = 0;
+    vec->capacity = inlineCapacity;
+}
+
+/* Columns are cache-line aligned so field scans start on a line and
+ * vectorized loops need no peeling for alignment */
+#define CAX_COLUMN_ALIGN 64
+
+void cax_columns_grow(CaxColumns* vec, int32_t count, const int64_t* columnSizes, int64_t minCapacity) {
+    int64_t capacity = vec->capacity > 0 ? vec->capacity * 2 : 16;
+    if (capacity < minCapacity) capacity = minCapacity;
+
+    for (int32_t k = 0; k < count; k++) {
+        int64_t elemSize = columnSizes[k] > 0 ? columnSizes[k] : 1;
+        if (capacity > (INT64_MAX - CAX_COLUMN_ALIGN) / elemSize) outOfMemory(INT64_MAX);
+        int64_t bytes = (capacity * elemSize + CAX_COLUMN_ALIGN - 1) / CAX_COLUMN_ALIGN * CAX_COLUMN_ALIGN;
+
+        void* data = aligned_alloc(CAX_COLUMN_ALIGN, (size_t)bytes);
+        if (!data) outOfMemory(bytes);
+        if (vec->columns[k]) {
+            memcpy(data, vec->columns[k], (size_t)(vec->size * elemSize));
+            free(vec->columns[k]);
+        }
+        vec->columns[k] = data;
+    }
+    vec->capacity = capacity;
+}
+
+void cax_columns_free(CaxColumns* vec, int32_t count) {
+    for (int32_t k = 0; k < count; k++) {
+        free(vec->columns[k]);
+        vec->columns[k] = NULL;
+    }
+    vec->size = 0;
+    vec->capacity = 0;
+}
+
+void cax_bounds_fail(int64_t index, int64_t size) {
+    cax_flush();
+    fprintf(stderr, "C-Accel runtime: index %lld out of range for size %lld\n",
+            (long long)index, (long long)size);
+    abort();
+}
@@ -0,0 +1,97 @@
+/*
+ * Vector runtime (runtime/cax_vector.c) against the inline fast path the
+ * IR generator emits for push.
+ *
+ *   runtimeVectorTest
+ *
+ * Exits non-zero on the first failed check.
+ */
+#include "runtime/cax_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INLINE_COUNT (CAX_VEC_INLINE_BYTES / (int64_t)sizeof(int32_t))
+
+/* %cax.vec.i32: the header followed by its inline buffer */
+typedef struct {
+    CaxVector header;
+    int32_t storage[INLINE_COUNT];
+} VectorI32;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                          \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+/* The generated initialization: empty, on the inline buffer */
+static void init(VectorI32* vec) {
+    vec->header.data = vec->storage;
+    vec->header.size = 0;
+    vec->header.capacity = INLINE_COUNT;
+}
+
+/* The generated cax.vec.i32.push: grow only when size reaches capacity */
+static void push(VectorI32* vec, int32_t value) {
+    CaxVector* header = &vec->header;
+    if (header->size >= header->capacity) {
+        cax_vec_grow(header, sizeof(int32_t), header->size + 1);
+    }
+    if (header->data == vec->storage && header->size >= INLINE_COUNT) {
+        CHECK(!"push would overrun the inline buffer");
+        return;
+    }
+    ((int32_t*)header->data)[header->size++] = value;
+}
+
+/* A spilled vector, once freed, is back on its inline buffer with the
+ * inline capacity; pushing past that buffer must spill again */
+static void pushAfterFree(void) {
+    VectorI32 vec;
+    init(&vec);
+    for (int32_t i = 0; i < 100; i++) push(&vec, i);
+    CHECK(vec.header.data != vec.storage);
+    CHECK(vec.header.capacity >= 100);
+
+    cax_vec_free(&vec.header, INLINE_COUNT);
+    CHECK(vec.header.data == vec.storage);
+    CHECK(vec.header.size == 0);
+    CHECK(vec.header.capacity == INLINE_COUNT);
+
+    for (int32_t i = 0; i < 3 * INLINE_COUNT; i++) push(&vec, i * 2);
+    CHECK(vec.header.data != vec.storage);
+    CHECK(vec.header.size == 3 * INLINE_COUNT);
+    for (int32_t i = 0; i < 3 * INLINE_COUNT; i++) {
+        CHECK(((int32_t*)vec.header.data)[i] == i * 2);
+    }
+    cax_vec_free(&vec.header, INLINE_COUNT);
+}
+
+/* Freeing a vector that never left its inline buffer */
+static void freeInline(void) {
+    VectorI32 vec;
+    init(&vec);
+    push(&vec, 7);
+    cax_vec_free(&vec.header, INLINE_COUNT);
+    CHECK(vec.header.data == vec.storage);
+    CHECK(vec.header.size == 0);
+    CHECK(vec.header.capacity == INLINE_COUNT);
+    push(&vec, 8);
+    CHECK(vec.storage[0] == 8);
+}
+
+int main(void) {
+    pushAfterFree();
+    freeInline();
+    if (failures) {
+        fprintf(stderr, "runtimeVectorTest: %d check%s failed\n", failures, failures == 1 ? "" : "s");
+        return EXIT_FAILURE;
+    }
+    printf("runtimeVectorTest: ok\n");
+    return EXIT_SUCCESS;
+}